@@ -0,0 +1,161 @@
+#include "asset_format.h"
+
+#include <array>
+#include <string_view>
+
+#include "file_utils.h"
+
+namespace
+{
+    constexpr std::array<uint32_t, 256> makeCrcTable()
+    {
+        std::array<uint32_t, 256> table = {};
+        for(uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for(int bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> CrcTable = makeCrcTable();
+
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + AssetFormat::SectionAlignment - 1) & ~(AssetFormat::SectionAlignment - 1);
+    }
+}
+
+namespace AssetFormat
+{
+    uint32_t crc32(std::span<const std::byte> data)
+    {
+        uint32_t crc = 0xFFFFFFFF;
+        for(std::byte byte : data)
+            crc = CrcTable[(crc ^ (uint32_t)byte) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void Writer::addSection(SectionType type, std::span<const std::byte> data)
+    {
+        sections.emplace_back(type, std::vector<std::byte>(data.begin(), data.end()));
+    }
+
+    bool Writer::write(const std::filesystem::path& path) const
+    {
+        std::vector<SectionHeader> headers;
+        uint64_t offset = alignUp(sizeof(FileHeader) + sections.size() * sizeof(SectionHeader));
+        for(const auto& [type, data] : sections)
+        {
+            headers.push_back(SectionHeader{
+                .type = type,
+                .checksum = crc32(data),
+                .offset = offset,
+                .size = data.size(),
+            });
+            offset = alignUp(offset + data.size());
+        }
+
+        std::vector<std::byte> file(offset);
+        FileHeader fileHeader = {
+            .magic = Magic,
+            .version = Version,
+            .sectionCount = (uint32_t)sections.size(),
+            .reserved = 0,
+        };
+        std::memcpy(file.data(), &fileHeader, sizeof(fileHeader));
+        std::memcpy(
+            file.data() + sizeof(FileHeader),
+            headers.data(),
+            headers.size() * sizeof(SectionHeader));
+        for(size_t i = 0; i < sections.size(); ++i)
+        {
+            const std::vector<std::byte>& data = sections[i].second;
+            std::memcpy(file.data() + headers[i].offset, data.data(), data.size());
+        }
+
+        return FileUtils::writeFileAtomic(
+            path,
+            std::string_view((const char*)file.data(), file.size()));
+    }
+
+    std::variant<Reader, Error> Reader::open(std::span<const std::byte> file, bool verify)
+    {
+        Error error = {};
+        if(file.size() < sizeof(FileHeader))
+        {
+            error.type = ErrorType::Truncated;
+            return error;
+        }
+
+        FileHeader fileHeader;
+        std::memcpy(&fileHeader, file.data(), sizeof(fileHeader));
+        if(fileHeader.magic != Magic)
+        {
+            error.type = ErrorType::InvalidMagic;
+            return error;
+        }
+        if(fileHeader.version != Version)
+        {
+            error.type = ErrorType::VersionMismatch;
+            error.VersionMismatch.version = fileHeader.version;
+            return error;
+        }
+        if((file.size() - sizeof(FileHeader)) / sizeof(SectionHeader) < fileHeader.sectionCount)
+        {
+            error.type = ErrorType::Truncated;
+            return error;
+        }
+
+        std::vector<SectionHeader> sections(fileHeader.sectionCount);
+        std::memcpy(
+            sections.data(),
+            file.data() + sizeof(FileHeader),
+            sections.size() * sizeof(SectionHeader));
+        for(const SectionHeader& section : sections)
+        {
+            if(section.offset > file.size() || section.size > file.size() - section.offset)
+            {
+                error.type = ErrorType::Truncated;
+                return error;
+            }
+            if(verify && crc32(file.subspan(section.offset, section.size)) != section.checksum)
+            {
+                error.type = ErrorType::ChecksumMismatch;
+                error.ChecksumMismatch.type = section.type;
+                return error;
+            }
+        }
+
+        return Reader(file, std::move(sections));
+    }
+
+    Reader::Reader(std::span<const std::byte> file, std::vector<SectionHeader>&& sections)
+        : file(file)
+        , sections(std::move(sections))
+    {
+    }
+
+    std::span<const std::byte> Reader::getSection(SectionType type) const
+    {
+        for(const SectionHeader& section : sections)
+        {
+            if(section.type == type)
+                return file.subspan(section.offset, section.size);
+        }
+        return {};
+    }
+
+    std::vector<std::span<const std::byte>> Reader::getSections(SectionType type) const
+    {
+        std::vector<std::span<const std::byte>> result;
+        for(const SectionHeader& section : sections)
+        {
+            if(section.type == type)
+                result.push_back(file.subspan(section.offset, section.size));
+        }
+        return result;
+    }
+}
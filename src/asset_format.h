@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief The binary format asset_cook writes and the runtime reads.
+ *
+ * A file is a FileHeader, a table of SectionHeaders and the sections themselves, each aligned to
+ * SectionAlignment and stored exactly as the GPU consumes it, so loading is mapping the file and
+ * copying sections into staging memory. Every section has a CRC-32 of its contents. The version
+ * is bumped whenever the layout of anything in here changes; old files are rejected and have to
+ * be cooked again.
+ */
+namespace AssetFormat
+{
+    constexpr uint32_t Magic = 0x54455341; // "ASET"
+    constexpr uint32_t Version = 2;
+    constexpr uint64_t SectionAlignment = 64;
+
+    enum class SectionType : uint32_t
+    {
+        // MeshInfo
+        MeshInfo = 1,
+        // MeshInfo::vertexCount vertices of MeshInfo::vertexStride bytes
+        Vertices = 2,
+        // MeshInfo::indexCount indices of MeshInfo::indexSize bytes
+        Indices = 3,
+        // TextureInfo
+        TextureInfo = 4,
+        // One per level, most detailed first
+        TextureLevel = 5,
+    };
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t sectionCount;
+        uint32_t reserved;
+    };
+
+    struct SectionHeader
+    {
+        SectionType type;
+        uint32_t checksum;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct MeshInfo
+    {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t vertexStride;
+        // 2 or 4
+        uint32_t indexSize;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct TextureInfo
+    {
+        // A VkFormat
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+    };
+
+    uint32_t crc32(std::span<const std::byte> data);
+
+    // Collects sections and writes them with their table and checksums
+    class Writer
+    {
+      public:
+        void addSection(SectionType type, std::span<const std::byte> data);
+        template<typename T>
+        void addSection(SectionType type, const T& value)
+        {
+            addSection(type, std::as_bytes(std::span<const T>(&value, 1)));
+        }
+
+        // Replaces `path` atomically
+        bool write(const std::filesystem::path& path) const;
+
+      private:
+        std::vector<std::pair<SectionType, std::vector<std::byte>>> sections;
+    };
+
+    enum class ErrorType
+    {
+        InvalidMagic,
+        // Cooked by a different version of asset_cook
+        VersionMismatch,
+        Truncated,
+        ChecksumMismatch,
+        MissingSection,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                uint32_t version;
+            } VersionMismatch;
+            struct
+            {
+                SectionType type;
+            } ChecksumMismatch;
+            struct
+            {
+                SectionType type;
+            } MissingSection;
+        };
+    };
+
+    // Views into a file, which must outlive it
+    class Reader
+    {
+      public:
+        /**
+         * @brief Checks the header and that every section lies in `file`. Checksums are only
+         * verified if asked for since that touches every byte of the file
+         */
+        static std::variant<Reader, Error> open(std::span<const std::byte> file, bool verify);
+
+        // The first section of `type`, or an empty span
+        std::span<const std::byte> getSection(SectionType type) const;
+        // Every section of `type` in file order
+        std::vector<std::span<const std::byte>> getSections(SectionType type) const;
+
+        // The first section of `type` if it is exactly a T
+        template<typename T>
+        std::optional<T> getStruct(SectionType type) const
+        {
+            auto section = getSection(type);
+            if(section.size() != sizeof(T))
+                return std::nullopt;
+            T value;
+            std::memcpy(&value, section.data(), sizeof(T));
+            return value;
+        }
+
+      private:
+        Reader(std::span<const std::byte> file, std::vector<SectionHeader>&& sections);
+
+        std::span<const std::byte> file;
+        std::vector<SectionHeader> sections;
+    };
+}
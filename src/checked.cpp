@@ -0,0 +1,22 @@
+#include "checked.h"
+
+#include <cstdlib>
+#include <iostream>
+
+#include <vulkan/vulkan.hpp>
+
+namespace Checked
+{
+    void fail(const char* expression, const char* file, int line)
+    {
+        std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+        std::abort();
+    }
+
+    void failResult(const char* expression, const char* file, int line, int32_t result)
+    {
+        std::cerr << file << ":" << line << ": check failed: " << expression << " returned "
+                  << vk::to_string((vk::Result)result) << std::endl;
+        std::abort();
+    }
+}
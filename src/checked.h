@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Checks that are kept in release builds.
+ *
+ * Unlike assert(), the checked expression is always evaluated, so it is safe to put calls with side
+ * effects in them. The success path is a single compare-and-branch; all formatting and reporting is
+ * moved into out-of-line cold functions so it doesn't bloat the call site.
+ */
+
+#if defined(_MSC_VER)
+    #define CHECKED_COLD __declspec(noinline)
+#else
+    #define CHECKED_COLD [[gnu::cold, gnu::noinline]]
+#endif
+
+namespace Checked
+{
+    [[noreturn]] CHECKED_COLD void fail(const char* expression, const char* file, int line);
+    [[noreturn]] CHECKED_COLD void failResult(
+        const char* expression,
+        const char* file,
+        int line,
+        int32_t result);
+}
+
+// `expr` must evaluate to a vk::Result or VkResult, anything but success is fatal
+#define checkResult(expr)                                                            \
+    do                                                                               \
+    {                                                                                \
+        auto checkedResult_ = (expr);                                                \
+        if(checkedResult_ != decltype(checkedResult_)(0)) [[unlikely]]               \
+            Checked::failResult(#expr, __FILE__, __LINE__, (int32_t)checkedResult_); \
+    } while(false)
+
+// `expr` must evaluate to something that converts to bool, such as a pointer or std::optional
+#define checkTrue(expr)                               \
+    do                                                \
+    {                                                 \
+        if(!(expr)) [[unlikely]]                      \
+            Checked::fail(#expr, __FILE__, __LINE__); \
+    } while(false)
+
+// For builders that return std::optional<Error>, where holding a value means failure
+#define checkNoError(expr)                            \
+    do                                                \
+    {                                                 \
+        if((expr).has_value()) [[unlikely]]           \
+            Checked::fail(#expr, __FILE__, __LINE__); \
+    } while(false)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include <vulkan/vulkan.hpp>
 
 // Contains data/config that the user sets; things from an options menu
@@ -11,6 +12,13 @@ struct UserConfig
     vk::SampleCountFlagBits
         sampleCount; // This is a bit unclear and should probably be changed to an enum
     uint32_t backbufferCount;
+    // Independent of backbufferCount. More frames in flight trades latency for throughput
+    uint32_t framesInFlight;
+    // The first supported mode is used, FIFO if none are
+    std::vector<vk::PresentModeKHR> presentModePreference;
+    // How many presents may be queued before the CPU waits, if VK_KHR_present_wait is supported.
+    // 0 disables pacing
+    uint32_t maxQueuedPresents;
 };
 
 // Contains data/config about things selected/configured at runtime
@@ -21,6 +29,14 @@ struct SelectedConfig
     vk::UniqueDevice device;
     vk::PhysicalDevice physicalDevice;
 
+    struct DeviceFeatures
+    {
+        bool presentWait;
+        bool textureCompressionBC;
+        bool textureCompressionETC2;
+        bool textureCompressionASTC;
+    } deviceFeatures;
+
     struct Queues
     {
         struct WorkQueue
@@ -40,9 +56,14 @@ struct SelectedConfig
     struct SwapChain
     {
         vk::UniqueSwapchainKHR swapchain;
+        vk::PresentModeKHR presentMode;
+        vk::Extent2D extent;
         std::vector<vk::Image> images;
         std::vector<vk::UniqueImageView> imageViews;
         std::vector<vk::UniqueFramebuffer> framebuffers;
+        // Signaled when rendering to the image is done and waited on by present. One per image
+        // since an image is only re-acquired after its present has consumed the semaphore
+        std::vector<vk::UniqueSemaphore> renderFinished;
     } swapchainConfig;
 
     struct Debug
@@ -22,4 +22,31 @@ namespace FileUtils
 
         return outData;
     }
+
+    bool writeFileAtomic(const std::filesystem::path& path, std::string_view data)
+    {
+        auto tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if(!out.is_open())
+                return false;
+            out.write(data.data(), (std::streamsize)data.size());
+            if(!out.good())
+                return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+
+    bool appendFile(const std::filesystem::path& path, std::string_view data)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        if(!out.is_open())
+            return false;
+        out.write(data.data(), (std::streamsize)data.size());
+        return out.good();
+    }
 }
@@ -2,9 +2,15 @@
 
 #include <filesystem>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 namespace FileUtils
 {
     std::optional<std::vector<char>> readFile(const std::filesystem::path& path);
-}
\ No newline at end of file
+
+    // Writes to a temporary file next to `path` and renames it over `path`, so a reader never sees
+    // a partially written file
+    bool writeFileAtomic(const std::filesystem::path& path, std::string_view data);
+    bool appendFile(const std::filesystem::path& path, std::string_view data);
+}
@@ -0,0 +1,289 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "file_utils.h"
+
+void Histogram::record(uint64_t value)
+{
+    buckets[bucketIndex(value)]++;
+    count++;
+    sum += value;
+    max = std::max(max, value);
+}
+
+void Histogram::merge(const Histogram& other)
+{
+    for(uint32_t i = 0; i < BucketCount; ++i)
+        buckets[i] += other.buckets[i];
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+void Histogram::clear()
+{
+    buckets.fill(0);
+    count = 0;
+    sum = 0;
+    max = 0;
+}
+
+uint64_t Histogram::percentile(double p) const
+{
+    if(count == 0)
+        return 0;
+
+    auto rank = (uint64_t)std::ceil(std::clamp(p, 0.0, 1.0) * (double)count);
+    rank = std::max(rank, (uint64_t)1);
+
+    uint64_t seen = 0;
+    for(uint32_t i = 0; i < BucketCount; ++i)
+    {
+        seen += buckets[i];
+        if(seen >= rank)
+            return std::min(bucketValue(i), max);
+    }
+    return max;
+}
+
+uint64_t Histogram::getCount() const
+{
+    return count;
+}
+
+uint64_t Histogram::getSum() const
+{
+    return sum;
+}
+
+uint64_t Histogram::getMax() const
+{
+    return max;
+}
+
+uint32_t Histogram::bucketIndex(uint64_t value)
+{
+    if(value < SubBucketCount)
+        return (uint32_t)value;
+
+    uint32_t exponent = (uint32_t)std::bit_width(value) - 1;
+    uint32_t shift = exponent - SubBucketBits;
+    uint32_t subBucket = (uint32_t)(value >> shift) - SubBucketCount;
+    return SubBucketCount + shift * SubBucketCount + subBucket;
+}
+
+uint64_t Histogram::bucketValue(uint32_t index)
+{
+    if(index < SubBucketCount)
+        return index;
+
+    uint32_t shift = (index - SubBucketCount) / SubBucketCount;
+    uint32_t subBucket = (index - SubBucketCount) % SubBucketCount;
+    uint64_t lower = (uint64_t)(SubBucketCount + subBucket) << shift;
+    // Middle of the bucket
+    return lower + (((uint64_t)1 << shift) >> 1);
+}
+
+FrameStats::ScopedTimer::ScopedTimer(FrameStats& stats, Metric metric)
+    : stats(stats)
+    , metric(metric)
+    , start(Clock::now())
+{
+}
+
+FrameStats::ScopedTimer::~ScopedTimer()
+{
+    stats.record(metric, Clock::now() - start);
+}
+
+FrameStats::FrameStats(std::chrono::milliseconds window)
+    : sliceDuration(std::chrono::duration_cast<std::chrono::nanoseconds>(window) / SliceCount)
+    , sliceStart(Clock::now())
+    , currentSlice(0)
+    , exportFormat(Format::Prometheus)
+    , exportInterval(0)
+{
+}
+
+FrameStats& FrameStats::withExport(
+    const std::filesystem::path& path,
+    Format format,
+    std::chrono::milliseconds interval)
+{
+    this->exportPath = path;
+    this->exportFormat = format;
+    this->exportInterval = interval;
+    this->nextExport = Clock::now() + interval;
+    return *this;
+}
+
+void FrameStats::record(Metric metric, std::chrono::nanoseconds duration)
+{
+    advanceSlices(Clock::now());
+    auto nanoseconds = (uint64_t)std::max<int64_t>(duration.count(), 0);
+    metrics[(size_t)metric].slices[currentSlice].record(nanoseconds);
+}
+
+FrameStats::ScopedTimer FrameStats::time(Metric metric)
+{
+    return ScopedTimer(*this, metric);
+}
+
+void FrameStats::markFrame()
+{
+    auto now = Clock::now();
+    if(lastFrame.has_value())
+        record(Metric::FrameTime, now - lastFrame.value());
+    lastFrame = now;
+}
+
+FrameStats::Summary FrameStats::summary(Metric metric) const
+{
+    Histogram merged;
+    for(const Histogram& slice : metrics[(size_t)metric].slices)
+        merged.merge(slice);
+
+    return Summary{
+        .count = merged.getCount(),
+        .p50 = std::chrono::nanoseconds(merged.percentile(0.50)),
+        .p95 = std::chrono::nanoseconds(merged.percentile(0.95)),
+        .p99 = std::chrono::nanoseconds(merged.percentile(0.99)),
+        .max = std::chrono::nanoseconds(merged.getMax()),
+        .sum = std::chrono::nanoseconds(merged.getSum()),
+    };
+}
+
+std::optional<FrameStats::Error> FrameStats::exportIfDue()
+{
+    if(!exportPath.has_value())
+        return std::nullopt;
+
+    auto now = Clock::now();
+    if(now < nextExport)
+        return std::nullopt;
+
+    // Skip ahead instead of trying to catch up if a frame took longer than the interval
+    nextExport = now + exportInterval;
+    return exportNow();
+}
+
+std::optional<FrameStats::Error> FrameStats::exportNow()
+{
+    if(!exportPath.has_value())
+        return std::nullopt;
+
+    // Make sure slices that are outside the window are not included if no frames have been
+    // recorded for a while
+    advanceSlices(Clock::now());
+
+    bool success;
+    if(exportFormat == Format::Prometheus)
+    {
+        success = FileUtils::writeFileAtomic(exportPath.value(), formatPrometheus());
+    }
+    else
+    {
+        std::string data;
+        if(!std::filesystem::exists(exportPath.value()))
+            data = "timestamp,metric,count,p50_ms,p95_ms,p99_ms,max_ms\n";
+        data += formatCsvRows();
+        success = FileUtils::appendFile(exportPath.value(), data);
+    }
+
+    if(!success)
+    {
+        Error error;
+        error.type = ErrorType::FileWrite;
+        error.FileWrite.message = "Could not write frame stats";
+        return error;
+    }
+
+    return std::nullopt;
+}
+
+const char* FrameStats::metricName(Metric metric)
+{
+    switch(metric)
+    {
+        case Metric::FrameTime: return "frame_time";
+        case Metric::AcquireWait: return "acquire_wait";
+        case Metric::FrameWait: return "frame_wait";
+        case Metric::Present: return "present";
+        case Metric::GpuTime: return "gpu_time";
+        case Metric::InputToPresent: return "input_to_present";
+        default: return "unknown";
+    }
+}
+
+void FrameStats::advanceSlices(Clock::time_point now)
+{
+    if(now - sliceStart < sliceDuration)
+        return;
+
+    auto elapsedSlices = (uint64_t)((now - sliceStart) / sliceDuration);
+    // Everything is stale, no need to step through every slice
+    auto clearCount = std::min(elapsedSlices, (uint64_t)SliceCount);
+    for(uint64_t i = 0; i < clearCount; ++i)
+    {
+        currentSlice = (currentSlice + 1) % SliceCount;
+        for(RollingHistogram& metric : metrics)
+            metric.slices[currentSlice].clear();
+    }
+
+    sliceStart += sliceDuration * elapsedSlices;
+}
+
+std::string FrameStats::formatPrometheus() const
+{
+    std::ostringstream out;
+    out << std::setprecision(9);
+
+    for(uint32_t i = 0; i < (uint32_t)Metric::Count; ++i)
+    {
+        auto name = std::string("vulkan_") + metricName((Metric)i) + "_seconds";
+        auto stats = summary((Metric)i);
+
+        auto seconds = [](std::chrono::nanoseconds duration) {
+            return std::chrono::duration<double>(duration).count();
+        };
+
+        out << "# TYPE " << name << " summary\n";
+        out << name << "{quantile=\"0.5\"} " << seconds(stats.p50) << "\n";
+        out << name << "{quantile=\"0.95\"} " << seconds(stats.p95) << "\n";
+        out << name << "{quantile=\"0.99\"} " << seconds(stats.p99) << "\n";
+        out << name << "{quantile=\"1\"} " << seconds(stats.max) << "\n";
+        out << name << "_sum " << seconds(stats.sum) << "\n";
+        out << name << "_count " << stats.count << "\n";
+    }
+
+    return out.str();
+}
+
+std::string FrameStats::formatCsvRows() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4);
+
+    auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+
+    auto milliseconds = [](std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    for(uint32_t i = 0; i < (uint32_t)Metric::Count; ++i)
+    {
+        auto stats = summary((Metric)i);
+        out << timestamp << "," << metricName((Metric)i) << "," << stats.count << ","
+            << milliseconds(stats.p50) << "," << milliseconds(stats.p95) << ","
+            << milliseconds(stats.p99) << "," << milliseconds(stats.max) << "\n";
+    }
+
+    return out.str();
+}
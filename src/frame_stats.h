@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Log-linear histogram of nanosecond durations.
+ *
+ * Every power of two is split into `SubBucketCount` linear buckets, so any recorded value is off
+ * by at most ~1.6% while the whole uint64_t range fits in a few thousand counters. Recording is a
+ * couple of bit operations and an increment, which makes it cheap enough to do several times per
+ * frame.
+ */
+class Histogram
+{
+  public:
+    constexpr static uint32_t SubBucketBits = 6;
+    constexpr static uint32_t SubBucketCount = 1 << SubBucketBits;
+    constexpr static uint32_t BucketCount = SubBucketCount + (64 - SubBucketBits) * SubBucketCount;
+
+    void record(uint64_t value);
+    void merge(const Histogram& other);
+    void clear();
+
+    // `p` is in the range [0, 1]
+    uint64_t percentile(double p) const;
+
+    uint64_t getCount() const;
+    uint64_t getSum() const;
+    uint64_t getMax() const;
+
+  private:
+    std::array<uint32_t, BucketCount> buckets = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    static uint32_t bucketIndex(uint64_t value);
+    static uint64_t bucketValue(uint32_t index);
+};
+
+/**
+ * @brief Keeps rolling histograms of per-frame timings and periodically writes p50/p95/p99/max to
+ * a file that can be scraped by monitoring.
+ *
+ * The window is split into a number of slices, and the oldest slice is dropped whenever time moves
+ * past it, so the percentiles always cover roughly the last `window` of frames.
+ */
+class FrameStats
+{
+    using Self = FrameStats;
+    using Clock = std::chrono::steady_clock;
+
+  public:
+    enum class Metric
+    {
+        FrameTime,
+        AcquireWait,
+        FrameWait,
+        Present,
+        GpuTime,
+        InputToPresent,
+        Count,
+    };
+
+    enum class Format
+    {
+        Prometheus,
+        Csv,
+    };
+
+    enum class ErrorType
+    {
+        FileWrite,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                const char* message;
+            } FileWrite;
+        };
+    };
+
+    struct Summary
+    {
+        uint64_t count;
+        std::chrono::nanoseconds p50;
+        std::chrono::nanoseconds p95;
+        std::chrono::nanoseconds p99;
+        std::chrono::nanoseconds max;
+        std::chrono::nanoseconds sum;
+    };
+
+    /**
+     * @brief Records the time from construction to destruction into the given metric
+     */
+    class ScopedTimer
+    {
+      public:
+        ScopedTimer(FrameStats& stats, Metric metric);
+        ~ScopedTimer();
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+      private:
+        FrameStats& stats;
+        Metric metric;
+        Clock::time_point start;
+    };
+
+    constexpr static uint32_t SliceCount = 8;
+
+    explicit FrameStats(std::chrono::milliseconds window);
+
+    Self& withExport(
+        const std::filesystem::path& path,
+        Format format,
+        std::chrono::milliseconds interval);
+
+    void record(Metric metric, std::chrono::nanoseconds duration);
+    ScopedTimer time(Metric metric);
+
+    /**
+     * @brief Records the time since the last call as `Metric::FrameTime`. Call once per frame
+     */
+    void markFrame();
+
+    Summary summary(Metric metric) const;
+
+    /**
+     * @brief Writes the current summaries if the export interval has elapsed. Does nothing if no
+     * export has been configured
+     */
+    std::optional<Error> exportIfDue();
+    std::optional<Error> exportNow();
+
+    static const char* metricName(Metric metric);
+
+  private:
+    struct RollingHistogram
+    {
+        // On the heap, together they are far too big for the stack FrameStats usually lives on
+        std::vector<Histogram> slices = std::vector<Histogram>(SliceCount);
+    };
+
+    std::chrono::nanoseconds sliceDuration;
+    Clock::time_point sliceStart;
+    uint32_t currentSlice;
+    std::array<RollingHistogram, (size_t)Metric::Count> metrics;
+
+    std::optional<Clock::time_point> lastFrame;
+
+    std::optional<std::filesystem::path> exportPath;
+    Format exportFormat;
+    std::chrono::milliseconds exportInterval;
+    Clock::time_point nextExport;
+
+    void advanceSlices(Clock::time_point now);
+
+    std::string formatPrometheus() const;
+    std::string formatCsvRows() const;
+};
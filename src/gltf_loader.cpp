@@ -0,0 +1,479 @@
+#include "gltf_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace
+{
+    constexpr uint32_t ModeTriangles = 4;
+
+    constexpr uint32_t ComponentByte = 5120;
+    constexpr uint32_t ComponentUnsignedByte = 5121;
+    constexpr uint32_t ComponentShort = 5122;
+    constexpr uint32_t ComponentUnsignedShort = 5123;
+    constexpr uint32_t ComponentUnsignedInt = 5125;
+    constexpr uint32_t ComponentFloat = 5126;
+
+    // Vertices converted per job
+    constexpr uint32_t BatchSize = 16384;
+
+    struct Accessor
+    {
+        const std::byte* data;
+        uint32_t count;
+        // In bytes between elements
+        uint32_t stride;
+        uint32_t componentType;
+        uint32_t componentCount;
+        bool normalized;
+
+        // Component `component` of element `index` converted to float
+        float get(uint32_t index, uint32_t component) const
+        {
+            const std::byte* element = data + (size_t)index * stride;
+            switch(componentType)
+            {
+                case ComponentByte:
+                {
+                    int8_t value;
+                    std::memcpy(&value, element + component, sizeof(value));
+                    return normalized ? std::max(value / 127.0f, -1.0f) : value;
+                }
+                case ComponentUnsignedByte:
+                {
+                    uint8_t value;
+                    std::memcpy(&value, element + component, sizeof(value));
+                    return normalized ? value / 255.0f : value;
+                }
+                case ComponentShort:
+                {
+                    int16_t value;
+                    std::memcpy(&value, element + component * 2, sizeof(value));
+                    return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+                }
+                case ComponentUnsignedShort:
+                {
+                    uint16_t value;
+                    std::memcpy(&value, element + component * 2, sizeof(value));
+                    return normalized ? value / 65535.0f : value;
+                }
+                default:
+                {
+                    float value;
+                    std::memcpy(&value, element + component * 4, sizeof(value));
+                    return value;
+                }
+            }
+        }
+
+        uint32_t getIndex(uint32_t index) const
+        {
+            const std::byte* element = data + (size_t)index * stride;
+            switch(componentType)
+            {
+                case ComponentUnsignedByte: return (uint32_t)element[0];
+                case ComponentUnsignedShort:
+                {
+                    uint16_t value;
+                    std::memcpy(&value, element, sizeof(value));
+                    return value;
+                }
+                default:
+                {
+                    uint32_t value;
+                    std::memcpy(&value, element, sizeof(value));
+                    return value;
+                }
+            }
+        }
+
+        glm::vec3 getVec3(uint32_t index) const
+        {
+            return {get(index, 0), get(index, 1), get(index, 2)};
+        }
+
+        glm::vec2 getVec2(uint32_t index) const
+        {
+            return {get(index, 0), get(index, 1)};
+        }
+    };
+
+    struct Primitive
+    {
+        Accessor positions;
+        std::optional<Accessor> normals;
+        std::optional<Accessor> uvs;
+        std::optional<Accessor> indices;
+
+        // Where the primitive goes in the MeshData
+        uint32_t firstVertex;
+        uint32_t firstIndex;
+
+        uint32_t getIndexCount() const
+        {
+            return indices.has_value() ? indices->count : positions.count;
+        }
+
+        uint32_t getIndex(uint32_t i) const
+        {
+            return indices.has_value() ? indices->getIndex(i) : i;
+        }
+
+        // Flat shaded primitives get a vertex per corner
+        uint32_t getVertexCount() const
+        {
+            return normals.has_value() ? positions.count : getIndexCount();
+        }
+    };
+
+    GltfLoader::Error invalid(const char* message)
+    {
+        GltfLoader::Error error = {};
+        error.type = GltfLoader::ErrorType::InvalidGltf;
+        error.InvalidGltf.message = message;
+        return error;
+    }
+
+    GltfLoader::Error unsupported(const char* message)
+    {
+        GltfLoader::Error error = {};
+        error.type = GltfLoader::ErrorType::Unsupported;
+        error.Unsupported.message = message;
+        return error;
+    }
+
+    uint32_t componentSize(uint32_t componentType)
+    {
+        switch(componentType)
+        {
+            case ComponentByte:
+            case ComponentUnsignedByte: return 1;
+            case ComponentShort:
+            case ComponentUnsignedShort: return 2;
+            case ComponentUnsignedInt:
+            case ComponentFloat: return 4;
+            default: return 0;
+        }
+    }
+
+    uint32_t componentCount(std::string_view type)
+    {
+        if(type == "SCALAR")
+            return 1;
+        if(type == "VEC2")
+            return 2;
+        if(type == "VEC3")
+            return 3;
+        if(type == "VEC4")
+            return 4;
+        return 0;
+    }
+
+    // Resolves accessor `index` to memory in `buffers` and checks that it lies within them
+    std::variant<Accessor, GltfLoader::Error> readAccessor(
+        const Json::Value& document,
+        const std::vector<std::span<const std::byte>>& buffers,
+        uint32_t index)
+    {
+        const Json::Value* accessor = nullptr;
+        if(const Json::Value* accessors = document.find("accessors"))
+            accessor = accessors->at(index);
+        if(!accessor)
+            return invalid("Accessor index out of range");
+        if(accessor->find("sparse"))
+            return unsupported("Sparse accessors aren't supported");
+
+        auto viewIndex = accessor->getUint("bufferView");
+        auto count = accessor->getUint("count");
+        auto componentType = accessor->getUint("componentType");
+        auto type = accessor->getString("type");
+        if(!viewIndex.has_value())
+            return unsupported("Accessors without a buffer view aren't supported");
+        if(!count.has_value() || !componentType.has_value() || !type.has_value()
+           || componentSize(*componentType) == 0 || componentCount(*type) == 0)
+            return invalid("Invalid accessor");
+
+        const Json::Value* view = nullptr;
+        if(const Json::Value* views = document.find("bufferViews"))
+            view = views->at(*viewIndex);
+        if(!view)
+            return invalid("Buffer view index out of range");
+        auto bufferIndex = view->getUint("buffer");
+        auto viewLength = view->getUint("byteLength");
+        uint64_t viewOffset = view->getUint("byteOffset").value_or(0);
+        if(!bufferIndex.has_value() || *bufferIndex >= buffers.size() || !viewLength.has_value()
+           || viewOffset + *viewLength > buffers[*bufferIndex].size())
+            return invalid("Invalid buffer view");
+
+        Accessor result = {
+            .data = nullptr,
+            .count = *count,
+            .stride = 0,
+            .componentType = *componentType,
+            .componentCount = componentCount(*type),
+            .normalized = false,
+        };
+        if(const Json::Value* normalized = accessor->find("normalized"))
+            result.normalized = normalized->type == Json::Type::Bool && normalized->boolean;
+        uint32_t elementSize = componentSize(result.componentType) * result.componentCount;
+        result.stride = view->getUint("byteStride").value_or(elementSize);
+        uint64_t offset = accessor->getUint("byteOffset").value_or(0);
+        if(result.stride < elementSize
+           || (result.count > 0
+               && offset + (uint64_t)result.stride * (result.count - 1) + elementSize
+                      > *viewLength))
+            return invalid("Accessor outside of its buffer view");
+
+        result.data = buffers[*bufferIndex].data() + viewOffset + offset;
+        return result;
+    }
+
+    std::variant<Primitive, GltfLoader::Error> readPrimitive(
+        const Json::Value& document,
+        const std::vector<std::span<const std::byte>>& buffers,
+        const Json::Value& primitive)
+    {
+        if(primitive.getUint("mode").value_or(ModeTriangles) != ModeTriangles)
+            return unsupported("Only triangle lists are supported");
+        const Json::Value* attributes = primitive.find("attributes");
+        if(!attributes)
+            return invalid("Primitive without attributes");
+
+        Primitive result = {};
+        auto positionIndex = attributes->getUint("POSITION");
+        if(!positionIndex.has_value())
+            return unsupported("Primitives without positions aren't supported");
+        auto accessorVar = readAccessor(document, buffers, *positionIndex);
+        if(std::holds_alternative<GltfLoader::Error>(accessorVar))
+            return std::get<GltfLoader::Error>(accessorVar);
+        result.positions = std::get<Accessor>(accessorVar);
+        if(result.positions.componentType != ComponentFloat || result.positions.componentCount != 3)
+            return invalid("POSITION must be float VEC3");
+
+        if(auto normalIndex = attributes->getUint("NORMAL"))
+        {
+            accessorVar = readAccessor(document, buffers, *normalIndex);
+            if(std::holds_alternative<GltfLoader::Error>(accessorVar))
+                return std::get<GltfLoader::Error>(accessorVar);
+            result.normals = std::get<Accessor>(accessorVar);
+            if(result.normals->componentType != ComponentFloat
+               || result.normals->componentCount != 3
+               || result.normals->count != result.positions.count)
+                return invalid("NORMAL must be float VEC3 with an element per position");
+        }
+
+        if(auto uvIndex = attributes->getUint("TEXCOORD_0"))
+        {
+            accessorVar = readAccessor(document, buffers, *uvIndex);
+            if(std::holds_alternative<GltfLoader::Error>(accessorVar))
+                return std::get<GltfLoader::Error>(accessorVar);
+            result.uvs = std::get<Accessor>(accessorVar);
+            bool validType = result.uvs->componentType == ComponentFloat
+                             || (result.uvs->normalized
+                                 && (result.uvs->componentType == ComponentUnsignedByte
+                                     || result.uvs->componentType == ComponentUnsignedShort));
+            if(!validType || result.uvs->componentCount != 2
+               || result.uvs->count != result.positions.count)
+                return invalid("Invalid TEXCOORD_0");
+        }
+
+        if(auto indexIndex = primitive.getUint("indices"))
+        {
+            accessorVar = readAccessor(document, buffers, *indexIndex);
+            if(std::holds_alternative<GltfLoader::Error>(accessorVar))
+                return std::get<GltfLoader::Error>(accessorVar);
+            result.indices = std::get<Accessor>(accessorVar);
+            if(result.indices->componentCount != 1
+               || (result.indices->componentType != ComponentUnsignedByte
+                   && result.indices->componentType != ComponentUnsignedShort
+                   && result.indices->componentType != ComponentUnsignedInt))
+                return invalid("Indices must be unsigned SCALARs");
+        }
+        if(result.getIndexCount() % 3 != 0)
+            return invalid("Triangle list with an incomplete triangle");
+
+        return result;
+    }
+
+    // Returns false if an index is out of range
+    bool convert(const Primitive& primitive, MeshData& mesh, JobSystem& jobSystem)
+    {
+        std::atomic<bool> valid = true;
+        auto uvOf = [&](uint32_t vertex) {
+            return primitive.uvs.has_value() ? primitive.uvs->getVec2(vertex) : glm::vec2(0.0f);
+        };
+
+        if(primitive.normals.has_value())
+        {
+            jobSystem.parallelFor(
+                primitive.positions.count,
+                BatchSize,
+                [&](uint32_t begin, uint32_t end) {
+                    for(uint32_t i = begin; i < end; ++i)
+                    {
+                        mesh.vertices[primitive.firstVertex + i] = packMeshVertex(
+                            primitive.positions.getVec3(i),
+                            primitive.normals->getVec3(i),
+                            uvOf(i));
+                    }
+                });
+            jobSystem.parallelFor(
+                primitive.getIndexCount(),
+                BatchSize,
+                [&](uint32_t begin, uint32_t end) {
+                    for(uint32_t i = begin; i < end; ++i)
+                    {
+                        uint32_t index = primitive.getIndex(i);
+                        if(index >= primitive.positions.count)
+                        {
+                            valid = false;
+                            return;
+                        }
+                        mesh.indices[primitive.firstIndex + i] = primitive.firstVertex + index;
+                    }
+                });
+            return valid;
+        }
+
+        jobSystem.parallelFor(
+            primitive.getIndexCount() / 3,
+            BatchSize / 3,
+            [&](uint32_t begin, uint32_t end) {
+                for(uint32_t triangle = begin; triangle < end; ++triangle)
+                {
+                    uint32_t corners[3];
+                    for(uint32_t i = 0; i < 3; ++i)
+                    {
+                        corners[i] = primitive.getIndex(triangle * 3 + i);
+                        if(corners[i] >= primitive.positions.count)
+                        {
+                            valid = false;
+                            return;
+                        }
+                    }
+
+                    glm::vec3 positions[3] = {
+                        primitive.positions.getVec3(corners[0]),
+                        primitive.positions.getVec3(corners[1]),
+                        primitive.positions.getVec3(corners[2]),
+                    };
+                    glm::vec3 faceNormal =
+                        glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+                    float length = glm::length(faceNormal);
+                    faceNormal =
+                        length > 0.0f ? faceNormal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+                    for(uint32_t i = 0; i < 3; ++i)
+                    {
+                        uint32_t vertex = primitive.firstVertex + triangle * 3 + i;
+                        mesh.vertices[vertex] =
+                            packMeshVertex(positions[i], faceNormal, uvOf(corners[i]));
+                        mesh.indices[primitive.firstIndex + triangle * 3 + i] = vertex;
+                    }
+                }
+            });
+        return valid;
+    }
+}
+
+namespace GltfLoader
+{
+    std::variant<MeshData, Error> load(const std::filesystem::path& path, JobSystem& jobSystem)
+    {
+        Error error = {};
+
+        auto file = MappedFile::open(path);
+        if(!file.has_value())
+        {
+            error.type = ErrorType::FileNotFound;
+            return error;
+        }
+        auto documentVar = Json::parse(
+            std::string_view((const char*)file->getData().data(), file->getData().size()));
+        if(std::holds_alternative<Json::Error>(documentVar))
+        {
+            error.type = ErrorType::InvalidJson;
+            error.InvalidJson.error = std::get<Json::Error>(documentVar);
+            return error;
+        }
+        const Json::Value& document = std::get<Json::Value>(documentVar);
+
+        const Json::Value* asset = document.find("asset");
+        auto version = asset ? asset->getString("version") : std::nullopt;
+        if(!version.has_value())
+            return invalid("Missing asset version");
+        if(!version->starts_with("2."))
+            return unsupported("Only glTF 2.x is supported");
+
+        // Mapped rather than read, so only the pages the accessors touch are loaded
+        std::vector<MappedFile> bufferFiles;
+        std::vector<std::span<const std::byte>> buffers;
+        if(const Json::Value* bufferList = document.find("buffers"))
+        {
+            for(const Json::Value& buffer : bufferList->elements)
+            {
+                auto uri = buffer.getString("uri");
+                auto byteLength = buffer.getUint("byteLength");
+                if(!uri.has_value())
+                    return unsupported("Only buffers in external files are supported");
+                if(uri->starts_with("data:"))
+                    return unsupported("Embedded buffers aren't supported");
+                if(!byteLength.has_value())
+                    return invalid("Buffer without a byteLength");
+
+                auto bufferFile = MappedFile::open(path.parent_path() / *uri);
+                if(!bufferFile.has_value())
+                {
+                    error.type = ErrorType::FileNotFound;
+                    return error;
+                }
+                if(bufferFile->getData().size() < *byteLength)
+                    return invalid("Buffer file is smaller than its byteLength");
+                buffers.push_back(bufferFile->getData().first(*byteLength));
+                bufferFiles.push_back(std::move(bufferFile.value()));
+            }
+        }
+
+        std::vector<Primitive> primitives;
+        uint64_t vertexCount = 0;
+        uint64_t indexCount = 0;
+        if(const Json::Value* meshes = document.find("meshes"))
+        {
+            for(const Json::Value& mesh : meshes->elements)
+            {
+                const Json::Value* meshPrimitives = mesh.find("primitives");
+                if(!meshPrimitives || meshPrimitives->type != Json::Type::Array)
+                    return invalid("Mesh without primitives");
+                for(const Json::Value& primitive : meshPrimitives->elements)
+                {
+                    auto primitiveVar = readPrimitive(document, buffers, primitive);
+                    if(std::holds_alternative<Error>(primitiveVar))
+                        return std::get<Error>(primitiveVar);
+                    primitives.push_back(std::get<Primitive>(primitiveVar));
+                    primitives.back().firstVertex = (uint32_t)vertexCount;
+                    primitives.back().firstIndex = (uint32_t)indexCount;
+                    vertexCount += primitives.back().getVertexCount();
+                    indexCount += primitives.back().getIndexCount();
+                    if(vertexCount > UINT32_MAX || indexCount > UINT32_MAX)
+                        return unsupported("More than 2^32 vertices or indices");
+                }
+            }
+        }
+
+        MeshData result;
+        result.vertices.resize(vertexCount);
+        result.indices.resize(indexCount);
+        for(const Primitive& primitive : primitives)
+        {
+            if(!convert(primitive, result, jobSystem))
+                return invalid("Index out of range");
+        }
+        return result;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <filesystem>
+#include <variant>
+
+#include "job_system.h"
+#include "json.h"
+#include "mesh_data.h"
+
+/**
+ * @brief Reads the geometry of glTF 2.0 files with external buffers (.gltf + .bin).
+ *
+ * Every triangle primitive of every mesh is appended to one MeshData in the space of its mesh;
+ * nodes, materials and animations are ignored. Buffers are memory mapped and the vertices of each
+ * primitive are converted on the JobSystem. Primitives without normals get face normals, which
+ * means their vertices are no longer shared, like the spec asks for flat shading.
+ *
+ * Embedded (data:) buffers, .glb files, sparse accessors and other primitive modes aren't
+ * supported.
+ */
+namespace GltfLoader
+{
+    enum class ErrorType
+    {
+        FileNotFound,
+        InvalidJson,
+        // The JSON doesn't describe valid glTF, e.g. accessors outside of their buffer
+        InvalidGltf,
+        Unsupported,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                Json::Error error;
+            } InvalidJson;
+            struct
+            {
+                const char* message;
+            } InvalidGltf;
+            struct
+            {
+                const char* message;
+            } Unsupported;
+        };
+    };
+
+    std::variant<MeshData, Error> load(const std::filesystem::path& path, JobSystem& jobSystem);
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <vector>
+
+/**
+ * @brief 32-bit typed handle into a HandlePool: 20 bits of slot index and 12 bits of generation.
+ *
+ * The generation is bumped every time a slot is freed, so a handle to a destroyed object is
+ * detected instead of silently pointing at whatever reused the slot (until the generation wraps
+ * around after 4095 reuses). The all-zero handle is null.
+ */
+template<typename Tag>
+struct Handle
+{
+    static constexpr uint32_t IndexBits = 20;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+    static constexpr uint32_t MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+    uint32_t value = 0;
+
+    static Handle make(uint32_t index, uint32_t generation)
+    {
+        return Handle{.value = (generation << IndexBits) | index};
+    }
+
+    uint32_t index() const
+    {
+        return value & IndexMask;
+    }
+
+    uint32_t generation() const
+    {
+        return value >> IndexBits;
+    }
+
+    explicit operator bool() const
+    {
+        return value != 0;
+    }
+
+    bool operator==(const Handle&) const = default;
+};
+
+/**
+ * @brief Generational object pool with dense struct-of-arrays storage.
+ *
+ * Every component type gets its own tightly packed array, so iterating over one component of every
+ * object (e.g. the sizes of all buffers) only touches that data. Handles map to dense indices
+ * through a slot table, which makes lookups O(1), and destroying an object moves the last object
+ * into its place so the arrays never have holes. The component types must be distinct.
+ */
+template<typename Tag, typename... Components>
+class HandlePool
+{
+  public:
+    using HandleType = Handle<Tag>;
+
+    HandleType create(Components&&... values)
+    {
+        uint32_t slotIndex;
+        if(!freeSlots.empty())
+        {
+            slotIndex = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            assert(slots.size() < HandleType::IndexMask);
+            slotIndex = (uint32_t)slots.size();
+            slots.push_back(Slot{.generation = 1, .denseIndex = 0});
+        }
+
+        slots[slotIndex].denseIndex = (uint32_t)denseToSlot.size();
+        denseToSlot.push_back(slotIndex);
+        (std::get<std::vector<Components>>(components).push_back(std::move(values)), ...);
+
+        return HandleType::make(slotIndex, slots[slotIndex].generation);
+    }
+
+    /**
+     * @brief Removes the object and hands its components back, e.g. to retire them in a
+     * DeletionQueue. Returns std::nullopt for stale or null handles
+     */
+    std::optional<std::tuple<Components...>> destroy(HandleType handle)
+    {
+        if(!isValid(handle))
+            return std::nullopt;
+
+        Slot& slot = slots[handle.index()];
+        uint32_t denseIndex = slot.denseIndex;
+        uint32_t lastIndex = (uint32_t)denseToSlot.size() - 1;
+
+        std::tuple<Components...> removed(
+            std::move(std::get<std::vector<Components>>(components)[denseIndex])...);
+
+        (swapRemove(std::get<std::vector<Components>>(components), denseIndex), ...);
+        if(denseIndex != lastIndex)
+        {
+            denseToSlot[denseIndex] = denseToSlot[lastIndex];
+            slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+        }
+        denseToSlot.pop_back();
+
+        slot.generation = slot.generation == HandleType::MaxGeneration ? 1 : slot.generation + 1;
+        freeSlots.push_back(handle.index());
+
+        return removed;
+    }
+
+    bool isValid(HandleType handle) const
+    {
+        return handle && handle.index() < slots.size()
+               && slots[handle.index()].generation == handle.generation();
+    }
+
+    // nullptr for stale or null handles
+    template<typename Component>
+    Component* get(HandleType handle)
+    {
+        if(!isValid(handle))
+            return nullptr;
+        return &std::get<std::vector<Component>>(components)[slots[handle.index()].denseIndex];
+    }
+
+    template<typename Component>
+    const Component* get(HandleType handle) const
+    {
+        if(!isValid(handle))
+            return nullptr;
+        return &std::get<std::vector<Component>>(components)[slots[handle.index()].denseIndex];
+    }
+
+    // Every live object's component, in dense order. Invalidated by `create` and `destroy`
+    template<typename Component>
+    std::span<Component> all()
+    {
+        return std::get<std::vector<Component>>(components);
+    }
+
+    template<typename Component>
+    std::span<const Component> all() const
+    {
+        return std::get<std::vector<Component>>(components);
+    }
+
+    // The handle of the object at `denseIndex`, to go along with `all`
+    HandleType handleAt(uint32_t denseIndex) const
+    {
+        uint32_t slotIndex = denseToSlot[denseIndex];
+        return HandleType::make(slotIndex, slots[slotIndex].generation);
+    }
+
+    uint32_t size() const
+    {
+        return (uint32_t)denseToSlot.size();
+    }
+
+  private:
+    struct Slot
+    {
+        uint32_t generation;
+        uint32_t denseIndex;
+    };
+
+    template<typename T>
+    static void swapRemove(std::vector<T>& values, uint32_t index)
+    {
+        if(index != values.size() - 1)
+            values[index] = std::move(values.back());
+        values.pop_back();
+    }
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> denseToSlot;
+    std::tuple<std::vector<Components>...> components;
+};
@@ -0,0 +1,249 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace
+{
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local uint32_t currentIndex = 0;
+}
+
+bool JobSystem::Counter::isDone() const
+{
+    return pending.load(std::memory_order_acquire) == 0;
+}
+
+JobSystem::JobSystem(uint32_t threadCount, bool pinThreads)
+{
+    if(threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for(uint32_t i = 0; i < threadCount; ++i)
+        queues.push_back(std::make_unique<WorkQueue>());
+
+    currentSystem = this;
+    currentIndex = 0;
+    if(pinThreads)
+        pinCurrentThread(0);
+
+    for(uint32_t i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back([this, i, pinThreads]() {
+            currentSystem = this;
+            currentIndex = i;
+            if(pinThreads)
+                pinCurrentThread(i);
+            workerLoop(i);
+        });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    quit = true;
+    {
+        std::lock_guard lock(sleepMutex);
+    }
+    sleepCondition.notify_all();
+
+    for(std::thread& thread : threads)
+        thread.join();
+
+    if(currentSystem == this)
+        currentSystem = nullptr;
+}
+
+void JobSystem::run(Job job, Counter* counter)
+{
+    if(counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    push(Task{.job = std::move(job), .counter = counter});
+}
+
+void JobSystem::runAfter(Counter& dependency, Job job, Counter* counter)
+{
+    if(counter)
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::lock_guard lock(dependency.mutex);
+        if(!dependency.isDone())
+        {
+            dependency.continuations.emplace_back(std::move(job), counter);
+            return;
+        }
+    }
+
+    push(Task{.job = std::move(job), .counter = counter});
+}
+
+void JobSystem::parallelFor(
+    uint32_t count,
+    uint32_t batchSize,
+    const std::function<void(uint32_t begin, uint32_t end)>& function)
+{
+    batchSize = std::max(batchSize, 1u);
+
+    Counter counter;
+    for(uint32_t begin = 0; begin < count; begin += batchSize)
+    {
+        uint32_t end = std::min(begin + batchSize, count);
+        run([&function, begin, end]() { function(begin, end); }, &counter);
+    }
+    wait(counter);
+}
+
+void JobSystem::wait(Counter& counter)
+{
+    uint32_t threadIndex = currentThreadIndex();
+    while(!counter.isDone())
+    {
+        if(!tryRunOne(threadIndex))
+            std::this_thread::yield();
+    }
+
+    // `finish` decrements the counter while holding its mutex, so make sure it has let go of it
+    // before the caller is allowed to destroy the counter
+    std::lock_guard lock(counter.mutex);
+}
+
+void JobSystem::runOnMainThread(Job job)
+{
+    std::lock_guard lock(mainThreadMutex);
+    mainThreadJobs.push_back(std::move(job));
+}
+
+void JobSystem::pumpMainThread()
+{
+    std::vector<Job> jobs;
+    {
+        std::lock_guard lock(mainThreadMutex);
+        jobs.swap(mainThreadJobs);
+    }
+
+    for(Job& job : jobs)
+        job();
+}
+
+uint32_t JobSystem::getThreadCount() const
+{
+    return (uint32_t)queues.size();
+}
+
+uint32_t JobSystem::currentThreadIndex() const
+{
+    return currentSystem == this ? currentIndex : 0;
+}
+
+void JobSystem::push(Task task)
+{
+    WorkQueue& queue = *queues[currentThreadIndex()];
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    queuedTasks.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock makes sure a worker can't miss the notification between checking
+    // `queuedTasks` and going to sleep
+    {
+        std::lock_guard lock(sleepMutex);
+    }
+    sleepCondition.notify_one();
+}
+
+bool JobSystem::tryRunOne(uint32_t threadIndex)
+{
+    Task task;
+    bool found = false;
+
+    {
+        WorkQueue& own = *queues[threadIndex];
+        std::lock_guard lock(own.mutex);
+        if(!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+
+    for(uint32_t offset = 1; !found && offset < queues.size(); ++offset)
+    {
+        WorkQueue& victim = *queues[(threadIndex + offset) % queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if(!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+
+    if(!found)
+        return false;
+
+    queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+    execute(task);
+    return true;
+}
+
+void JobSystem::execute(Task& task)
+{
+    task.job();
+    finish(task.counter);
+}
+
+void JobSystem::finish(Counter* counter)
+{
+    if(!counter)
+        return;
+
+    std::vector<std::pair<Job, Counter*>> ready;
+    {
+        std::lock_guard lock(counter->mutex);
+        if(counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            ready.swap(counter->continuations);
+    }
+
+    for(auto& [job, continuationCounter] : ready)
+        push(Task{.job = std::move(job), .counter = continuationCounter});
+}
+
+void JobSystem::workerLoop(uint32_t threadIndex)
+{
+    while(!quit)
+    {
+        if(tryRunOne(threadIndex))
+            continue;
+
+        std::unique_lock lock(sleepMutex);
+        sleepCondition.wait(lock, [this]() {
+            return quit || queuedTasks.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+void JobSystem::pinCurrentThread(uint32_t core)
+{
+    core %= std::max(std::thread::hardware_concurrency(), 1u);
+#if defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)core;
+#endif
+}
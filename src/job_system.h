@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work-stealing task scheduler shared by everything that wants to run in parallel.
+ *
+ * Every thread, including the one that created the JobSystem (the main thread, index 0), owns a
+ * deque. Jobs pushed from a thread go to the back of its own deque and are popped from the back
+ * again, while idle threads steal from the front of other threads' deques. The deques are guarded
+ * by their own mutex which is practically uncontended since stealing only happens when a thread
+ * has run out of work.
+ *
+ * Completion is tracked with Counters: a job increments its counter when it is queued and
+ * decrements it when it finishes, other jobs can be scheduled to start once a counter reaches
+ * zero, and `wait` keeps executing jobs until the counter it waits for is zero.
+ */
+class JobSystem
+{
+  public:
+    using Job = std::function<void()>;
+
+    class Counter
+    {
+        friend class JobSystem;
+
+      public:
+        Counter() = default;
+        Counter(const Counter&) = delete;
+        Counter& operator=(const Counter&) = delete;
+
+        bool isDone() const;
+
+      private:
+        std::atomic<uint32_t> pending = 0;
+        // Jobs waiting for `pending` to reach 0
+        std::mutex mutex;
+        std::vector<std::pair<Job, Counter*>> continuations;
+    };
+
+    /**
+     * @param threadCount the number of threads including the calling thread. 0 means one per core
+     * @param pinThreads pin thread N to core N so the OS doesn't migrate the workers around
+     */
+    JobSystem(uint32_t threadCount, bool pinThreads);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // `counter` is optional and is decremented once `job` has finished
+    void run(Job job, Counter* counter = nullptr);
+    // Queues `job` once `dependency` reaches zero. `dependency` must outlive the call to `job`
+    void runAfter(Counter& dependency, Job job, Counter* counter = nullptr);
+    // Runs `function(begin, end)` over [0, count) in batches of `batchSize` and waits for it
+    void parallelFor(
+        uint32_t count,
+        uint32_t batchSize,
+        const std::function<void(uint32_t begin, uint32_t end)>& function);
+    // Executes other jobs on the calling thread until `counter` reaches zero
+    void wait(Counter& counter);
+
+    // For things that have to happen on the main thread, such as GLFW calls
+    void runOnMainThread(Job job);
+    // Runs everything queued with `runOnMainThread`. Must be called from the main thread
+    void pumpMainThread();
+
+    uint32_t getThreadCount() const;
+    // Index of the calling thread in [0, getThreadCount()), 0 is the main thread. Threads that
+    // don't belong to this JobSystem also get 0, so only use this from inside jobs or on the main
+    // thread
+    uint32_t currentThreadIndex() const;
+
+  private:
+    struct Task
+    {
+        Job job;
+        Counter* counter;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<uint32_t> queuedTasks = 0;
+    std::atomic<bool> quit = false;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+
+    std::mutex mainThreadMutex;
+    std::vector<Job> mainThreadJobs;
+
+    void push(Task task);
+    bool tryRunOne(uint32_t threadIndex);
+    void execute(Task& task);
+    void finish(Counter* counter);
+    void workerLoop(uint32_t threadIndex);
+
+    static void pinCurrentThread(uint32_t core);
+};
@@ -0,0 +1,332 @@
+#include "json.h"
+
+#include <charconv>
+
+namespace
+{
+    bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    void appendUtf8(std::string& string, uint32_t codePoint)
+    {
+        if(codePoint < 0x80)
+            string.push_back((char)codePoint);
+        else if(codePoint < 0x800)
+        {
+            string.push_back((char)(0xC0 | codePoint >> 6));
+            string.push_back((char)(0x80 | (codePoint & 0x3F)));
+        }
+        else if(codePoint < 0x10000)
+        {
+            string.push_back((char)(0xE0 | codePoint >> 12));
+            string.push_back((char)(0x80 | (codePoint >> 6 & 0x3F)));
+            string.push_back((char)(0x80 | (codePoint & 0x3F)));
+        }
+        else
+        {
+            string.push_back((char)(0xF0 | codePoint >> 18));
+            string.push_back((char)(0x80 | (codePoint >> 12 & 0x3F)));
+            string.push_back((char)(0x80 | (codePoint >> 6 & 0x3F)));
+            string.push_back((char)(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    class Parser
+    {
+      public:
+        Parser(std::string_view text): text(text), position(0), error({}) {}
+
+        std::variant<Json::Value, Json::Error> parseDocument()
+        {
+            Json::Value value;
+            if(!parseValue(value, 0))
+                return error;
+            skipWhitespace();
+            if(position != text.size())
+                return syntaxError();
+            return value;
+        }
+
+      private:
+        std::string_view text;
+        size_t position;
+        Json::Error error;
+
+        Json::Error syntaxError()
+        {
+            error.type = Json::ErrorType::InvalidSyntax;
+            error.InvalidSyntax.offset = position;
+            return error;
+        }
+
+        bool fail()
+        {
+            syntaxError();
+            return false;
+        }
+
+        void skipWhitespace()
+        {
+            while(position < text.size()
+                  && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n'
+                      || text[position] == '\r'))
+                position++;
+        }
+
+        bool consume(char c)
+        {
+            skipWhitespace();
+            if(position < text.size() && text[position] == c)
+            {
+                position++;
+                return true;
+            }
+            return false;
+        }
+
+        bool consumeLiteral(std::string_view literal)
+        {
+            if(text.substr(position, literal.size()) != literal)
+                return false;
+            position += literal.size();
+            return true;
+        }
+
+        bool parseValue(Json::Value& value, uint32_t depth)
+        {
+            skipWhitespace();
+            if(position == text.size())
+                return fail();
+
+            char c = text[position];
+            if(c == '{' || c == '[')
+            {
+                if(depth == Json::MaxDepth)
+                {
+                    error.type = Json::ErrorType::TooDeep;
+                    error.TooDeep.offset = position;
+                    return false;
+                }
+                return c == '{' ? parseObject(value, depth + 1) : parseArray(value, depth + 1);
+            }
+            if(c == '"')
+            {
+                value.type = Json::Type::String;
+                return parseString(value.string);
+            }
+            if(c == '-' || isDigit(c))
+            {
+                value.type = Json::Type::Number;
+                return parseNumber(value.number);
+            }
+            if(consumeLiteral("true") || consumeLiteral("false"))
+            {
+                value.type = Json::Type::Bool;
+                value.boolean = c == 't';
+                return true;
+            }
+            if(consumeLiteral("null"))
+            {
+                value.type = Json::Type::Null;
+                return true;
+            }
+            return fail();
+        }
+
+        bool parseObject(Json::Value& value, uint32_t depth)
+        {
+            value.type = Json::Type::Object;
+            position++;
+            if(consume('}'))
+                return true;
+            do
+            {
+                skipWhitespace();
+                if(position == text.size() || text[position] != '"')
+                    return fail();
+                value.keys.emplace_back();
+                if(!parseString(value.keys.back()) || !consume(':'))
+                    return fail();
+                value.elements.emplace_back();
+                if(!parseValue(value.elements.back(), depth))
+                    return false;
+            } while(consume(','));
+            return consume('}') || fail();
+        }
+
+        bool parseArray(Json::Value& value, uint32_t depth)
+        {
+            value.type = Json::Type::Array;
+            position++;
+            if(consume(']'))
+                return true;
+            do
+            {
+                value.elements.emplace_back();
+                if(!parseValue(value.elements.back(), depth))
+                    return false;
+            } while(consume(','));
+            return consume(']') || fail();
+        }
+
+        // Checks the JSON number grammar first since from_chars also takes "inf", "nan" and such
+        bool parseNumber(double& number)
+        {
+            size_t start = position;
+            if(text[position] == '-')
+                position++;
+            if(position < text.size() && text[position] == '0')
+                position++;
+            else if(position < text.size() && isDigit(text[position]))
+            {
+                while(position < text.size() && isDigit(text[position]))
+                    position++;
+            }
+            else
+                return fail();
+
+            if(position < text.size() && text[position] == '.')
+            {
+                position++;
+                if(position == text.size() || !isDigit(text[position]))
+                    return fail();
+                while(position < text.size() && isDigit(text[position]))
+                    position++;
+            }
+            if(position < text.size() && (text[position] == 'e' || text[position] == 'E'))
+            {
+                position++;
+                if(position < text.size() && (text[position] == '+' || text[position] == '-'))
+                    position++;
+                if(position == text.size() || !isDigit(text[position]))
+                    return fail();
+                while(position < text.size() && isDigit(text[position]))
+                    position++;
+            }
+
+            const char* first = text.data() + start;
+            auto [end, result] = std::from_chars(first, text.data() + position, number);
+            // Out of range numbers are rejected rather than rounded to infinity
+            return result == std::errc() || fail();
+        }
+
+        bool parseHex4(uint32_t& value)
+        {
+            if(text.size() - position < 4)
+                return fail();
+            auto [end, result] =
+                std::from_chars(text.data() + position, text.data() + position + 4, value, 16);
+            if(result != std::errc() || end != text.data() + position + 4)
+                return fail();
+            position += 4;
+            return true;
+        }
+
+        bool parseString(std::string& string)
+        {
+            position++;
+            while(position < text.size())
+            {
+                char c = text[position++];
+                if(c == '"')
+                    return true;
+                if((unsigned char)c < 0x20)
+                    return fail();
+                if(c != '\\')
+                {
+                    string.push_back(c);
+                    continue;
+                }
+
+                if(position == text.size())
+                    return fail();
+                switch(text[position++])
+                {
+                    case '"': string.push_back('"'); break;
+                    case '\\': string.push_back('\\'); break;
+                    case '/': string.push_back('/'); break;
+                    case 'b': string.push_back('\b'); break;
+                    case 'f': string.push_back('\f'); break;
+                    case 'n': string.push_back('\n'); break;
+                    case 'r': string.push_back('\r'); break;
+                    case 't': string.push_back('\t'); break;
+                    case 'u':
+                    {
+                        uint32_t codePoint;
+                        if(!parseHex4(codePoint))
+                            return false;
+                        // Characters outside the BMP are escaped as a surrogate pair
+                        if(codePoint >= 0xD800 && codePoint < 0xDC00)
+                        {
+                            uint32_t low;
+                            if(!consumeLiteral("\\u") || !parseHex4(low) || low < 0xDC00
+                               || low >= 0xE000)
+                                return fail();
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        else if(codePoint >= 0xDC00 && codePoint < 0xE000)
+                            return fail();
+                        appendUtf8(string, codePoint);
+                        break;
+                    }
+                    default: return fail();
+                }
+            }
+            return fail();
+        }
+    };
+}
+
+namespace Json
+{
+    const Value* Value::find(std::string_view key) const
+    {
+        if(type != Type::Object)
+            return nullptr;
+        for(size_t i = 0; i < keys.size(); ++i)
+        {
+            if(keys[i] == key)
+                return &elements[i];
+        }
+        return nullptr;
+    }
+
+    const Value* Value::at(size_t index) const
+    {
+        if(type != Type::Array || index >= elements.size())
+            return nullptr;
+        return &elements[index];
+    }
+
+    std::optional<double> Value::getNumber(std::string_view key) const
+    {
+        const Value* value = find(key);
+        if(!value || value->type != Type::Number)
+            return std::nullopt;
+        return value->number;
+    }
+
+    std::optional<uint32_t> Value::getUint(std::string_view key) const
+    {
+        auto number = getNumber(key);
+        if(!number.has_value() || *number < 0.0 || *number > UINT32_MAX
+           || *number != (double)(uint32_t)*number)
+            return std::nullopt;
+        return (uint32_t)*number;
+    }
+
+    std::optional<std::string_view> Value::getString(std::string_view key) const
+    {
+        const Value* value = find(key);
+        if(!value || value->type != Type::String)
+            return std::nullopt;
+        return value->string;
+    }
+
+    std::variant<Value, Error> parse(std::string_view text)
+    {
+        return Parser(text).parseDocument();
+    }
+}
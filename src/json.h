@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief A small JSON (RFC 8259) parser for asset formats such as glTF. The whole document is
+ * parsed into a tree of Values up front.
+ */
+namespace Json
+{
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    struct Value
+    {
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        // Array elements, or object members with their names in `keys`
+        std::vector<Value> elements;
+        std::vector<std::string> keys;
+
+        // The member called `key` of an object, nullptr if there is none
+        const Value* find(std::string_view key) const;
+        // Element `index` of an array, nullptr if out of range
+        const Value* at(size_t index) const;
+
+        // The member `key` if it has the asked for type
+        std::optional<double> getNumber(std::string_view key) const;
+        std::optional<uint32_t> getUint(std::string_view key) const;
+        std::optional<std::string_view> getString(std::string_view key) const;
+    };
+
+    enum class ErrorType
+    {
+        InvalidSyntax,
+        // Arrays and objects nested deeper than MaxDepth
+        TooDeep,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                // Byte offset into the text
+                size_t offset;
+            } InvalidSyntax;
+            struct
+            {
+                size_t offset;
+            } TooDeep;
+        };
+    };
+
+    constexpr uint32_t MaxDepth = 256;
+
+    std::variant<Value, Error> parse(std::string_view text);
+}
@@ -0,0 +1,104 @@
+#include "ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr uint8_t Identifier[12] =
+        {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+    constexpr size_t HeaderSize = 80;
+    constexpr size_t LevelIndexEntrySize = 24;
+
+    template<typename T>
+    T read(std::span<const std::byte> file, size_t offset)
+    {
+        // KTX2 is little endian, like every platform this runs on
+        T value;
+        std::memcpy(&value, file.data() + offset, sizeof(T));
+        return value;
+    }
+}
+
+namespace Ktx2
+{
+    std::variant<Texture, Error> parse(std::span<const std::byte> file)
+    {
+        Error error = {};
+        if(file.size() < HeaderSize)
+        {
+            error.type = ErrorType::Truncated;
+            return error;
+        }
+        if(std::memcmp(file.data(), Identifier, sizeof(Identifier)) != 0)
+        {
+            error.type = ErrorType::InvalidIdentifier;
+            return error;
+        }
+
+        auto format = read<uint32_t>(file, 12);
+        auto width = read<uint32_t>(file, 20);
+        auto height = read<uint32_t>(file, 24);
+        auto depth = read<uint32_t>(file, 28);
+        auto layerCount = read<uint32_t>(file, 32);
+        auto faceCount = read<uint32_t>(file, 36);
+        // 0 asks the loader to generate the mips, only level 0 is stored then
+        auto levelCount = std::max(read<uint32_t>(file, 40), 1u);
+        auto supercompression = read<uint32_t>(file, 44);
+
+        error.type = ErrorType::Unsupported;
+        if(format == 0)
+        {
+            error.Unsupported.message = "Formats without VkFormat, such as Basis Universal";
+            return error;
+        }
+        if(supercompression != 0)
+        {
+            error.Unsupported.message = "Supercompression";
+            return error;
+        }
+        if(width == 0 || height == 0 || depth > 1)
+        {
+            error.Unsupported.message = "Only 2D textures are supported";
+            return error;
+        }
+        if(layerCount > 1 || faceCount != 1)
+        {
+            error.Unsupported.message = "Arrays and cube maps";
+            return error;
+        }
+        if(levelCount > 32)
+        {
+            error.Unsupported.message = "More than 32 levels";
+            return error;
+        }
+
+        if(file.size() < HeaderSize + levelCount * LevelIndexEntrySize)
+        {
+            error.type = ErrorType::Truncated;
+            return error;
+        }
+
+        Texture texture = {
+            .format = format,
+            .width = width,
+            .height = height,
+            .levels = std::vector<Level>(levelCount),
+        };
+        for(uint32_t i = 0; i < levelCount; ++i)
+        {
+            size_t entry = HeaderSize + i * LevelIndexEntrySize;
+            Level& level = texture.levels[i];
+            level.offset = read<uint64_t>(file, entry);
+            level.size = read<uint64_t>(file, entry + 8);
+            if(level.offset > file.size() || level.size > file.size() - level.offset)
+            {
+                error.type = ErrorType::Truncated;
+                return error;
+            }
+        }
+
+        return texture;
+    }
+}
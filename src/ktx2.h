@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief Reads the header and level index of KTX2 files.
+ *
+ * Only what can be copied to the GPU as is is accepted: a single 2D image, optionally with mips,
+ * in a format with a VkFormat and without supercompression. The level data isn't touched, so
+ * parsing a memory mapped file only reads its first page.
+ */
+namespace Ktx2
+{
+    struct Level
+    {
+        // Relative to the start of the file
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Texture
+    {
+        // A VkFormat
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        // Most detailed level first
+        std::vector<Level> levels;
+    };
+
+    enum class ErrorType
+    {
+        InvalidIdentifier,
+        // The file ends before the header or a level does
+        Truncated,
+        Unsupported,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                const char* message;
+            } Unsupported;
+        };
+    };
+
+    std::variant<Texture, Error> parse(std::span<const std::byte> file);
+}
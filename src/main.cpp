@@ -1,11 +1,20 @@
-#include <cassert>
+#include <algorithm>
 #include <iostream>
+#include <random>
 #include <variant>
 
 #include <vulkan/vulkan.h>
 
+#include "checked.h"
 #include "config.h"
+#include "frame_stats.h"
+#include "gltf_loader.h"
+#include "job_system.h"
+#include "mapped_file.h"
+#include "mesh_optimizer.h"
+#include "obj_loader.h"
 #include "shader_registry.h"
+#include "sprite_batch.h"
 #include "stl_utils.h"
 #include "vertex.h"
 #include "vulkan/device_builder.h"
@@ -15,30 +24,21 @@
 #include "window.h"
 
 #include "shader_paths.h"
+#include "vulkan/asset_loader.h"
+#include "vulkan/bindless_descriptors.h"
 #include "vulkan/buffer.h"
-
-#define vkGetInstanceProcAddrQ(instance, func) (PFN_##func) instance->getProcAddr(#func)
-
-// https://github.com/KhronosGroup/Vulkan-Hpp/blob/master/samples/CreateDebugUtilsMessenger/CreateDebugUtilsMessenger.cpp
-PFN_vkCreateDebugUtilsMessengerEXT pfnVkCreateDebugUtilsMessengerEXT;
-PFN_vkDestroyDebugUtilsMessengerEXT pfnVkDestroyDebugUtilsMessengerEXT;
-
-VKAPI_ATTR VkResult VKAPI_CALL vkCreateDebugUtilsMessengerEXT(
-    VkInstance instance,
-    const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
-    const VkAllocationCallbacks* pAllocator,
-    VkDebugUtilsMessengerEXT* pMessenger)
-{
-    return pfnVkCreateDebugUtilsMessengerEXT(instance, pCreateInfo, pAllocator, pMessenger);
-}
-
-VKAPI_ATTR void VKAPI_CALL vkDestroyDebugUtilsMessengerEXT(
-    VkInstance instance,
-    VkDebugUtilsMessengerEXT messenger,
-    VkAllocationCallbacks const* pAllocator)
-{
-    return pfnVkDestroyDebugUtilsMessengerEXT(instance, messenger, pAllocator);
-}
+#include "vulkan/commands.h"
+#include "vulkan/deletion_queue.h"
+#include "vulkan/frame_context.h"
+#include "vulkan/gpu_resources.h"
+#include "vulkan/gpu_timeline.h"
+#include "vulkan/image.h"
+#include "vulkan/mesh_uploader.h"
+#include "vulkan/mip_generator.h"
+#include "vulkan/present_pacer.h"
+#include "vulkan/texture_atlas.h"
+#include "vulkan/texture_residency.h"
+#include "vulkan/texture_streamer.h"
 
 VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -61,7 +61,7 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
 template<typename T, typename E>
 T expectResult(std::variant<T, E> var)
 {
-    assert(std::holds_alternative<T>(var));
+    checkTrue(std::holds_alternative<T>(var));
     return std::move(std::get<T>(var));
 }
 
@@ -75,10 +75,21 @@ int main()
         .backbufferFormat = vk::Format::eB8G8R8A8Srgb,
         .sampleCount = vk::SampleCountFlagBits::e1,
         .backbufferCount = 3,
+        .framesInFlight = 2,
+        // Latency matters more than tearing
+        .presentModePreference =
+            {
+                vk::PresentModeKHR::eMailbox,
+                vk::PresentModeKHR::eImmediate,
+                vk::PresentModeKHR::eFifoRelaxed,
+            },
+        .maxQueuedPresents = 1,
     };
 
     SelectedConfig selectedConfig;
 
+    JobSystem jobSystem(0, false);
+
     //  Create window
     bool windowResized = false;
     auto mainWindowOpt = Window::createWindow(
@@ -86,28 +97,24 @@ int main()
         (int)config.resolutionHeight,
         "Vulkan window",
         [&windowResized](uint32_t, uint32_t) { windowResized = true; });
-    assert(mainWindowOpt.has_value());
+    checkTrue(mainWindowOpt.has_value());
     std::unique_ptr<Window> mainWindow = std::move(mainWindowOpt.value());
 
     uint32_t glfwExtensionCount = 0;
     const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-    assert(!InstanceBuilder()
-                .withValidationLayer()
-                .withDebugExtension()
-                .withRequiredExtensions(glfwExtensions, glfwExtensionCount)
-                .build(selectedConfig)
-                .has_value());
+    auto instanceBuilder = InstanceBuilder();
+#ifndef NDEBUG
+    instanceBuilder.withValidationLayer().withDebugExtension();
+#endif
+    checkNoError(instanceBuilder.withVulkanVersion(VK_API_VERSION_1_2)
+                     .withRequiredExtensions(glfwExtensions, glfwExtensionCount)
+                     .build(selectedConfig));
 
+#ifndef NDEBUG
     {
-        pfnVkCreateDebugUtilsMessengerEXT =
-            vkGetInstanceProcAddrQ(*selectedConfig.instance, vkCreateDebugUtilsMessengerEXT);
-        assert(pfnVkCreateDebugUtilsMessengerEXT);
-
-        pfnVkDestroyDebugUtilsMessengerEXT =
-            vkGetInstanceProcAddrQ(*selectedConfig.instance, vkDestroyDebugUtilsMessengerEXT);
-        assert(pfnVkCreateDebugUtilsMessengerEXT);
-
+        // The debug utils functions are loaded by the dispatcher along with the rest of the
+        // instance functions
         vk::DebugUtilsMessengerCreateInfoEXT msgCreateInfo = {
             .messageSeverity = vk::DebugUtilsMessageSeverityFlagBitsEXT::eVerbose
                                | vk::DebugUtilsMessageSeverityFlagBitsEXT::eWarning
@@ -121,19 +128,18 @@ int main()
 
         auto [cdrcRes, msg] =
             selectedConfig.instance->createDebugUtilsMessengerEXTUnique(msgCreateInfo);
-        assert(cdrcRes == vk::Result::eSuccess);
+        checkResult(cdrcRes);
         selectedConfig.debug.msg = std::move(msg);
     }
+#endif
 
     {
         VkSurfaceKHR surfaceRaw;
-        assert(
-            glfwCreateWindowSurface(
-                *selectedConfig.instance,
-                mainWindow->getWindowHandle(),
-                nullptr,
-                &surfaceRaw)
-            == VK_SUCCESS);
+        checkResult(glfwCreateWindowSurface(
+            *selectedConfig.instance,
+            mainWindow->getWindowHandle(),
+            nullptr,
+            &surfaceRaw));
         selectedConfig.surfaceConfig.surface =
             vk::UniqueSurfaceKHR(surfaceRaw, *selectedConfig.instance);
     }
@@ -145,11 +151,24 @@ int main()
                     auto capabilities =
                         potential.getSurfaceCapabilitiesKHR(*selectedConfig.surfaceConfig.surface)
                             .value;
+                    // maxImageCount is 0 if there's no limit
                     return config.backbufferCount >= capabilities.minImageCount
-                           && config.backbufferCount <= capabilities.maxImageCount;
+                           && (capabilities.maxImageCount == 0
+                               || config.backbufferCount <= capabilities.maxImageCount);
                 })
+            .withRequiredVulkan12Features({
+                .descriptorIndexing = true,
+                .descriptorBindingSampledImageUpdateAfterBind = true,
+                .descriptorBindingStorageBufferUpdateAfterBind = true,
+                .descriptorBindingUpdateUnusedWhilePending = true,
+                .descriptorBindingPartiallyBound = true,
+                .runtimeDescriptorArray = true,
+                .timelineSemaphore = true,
+            })
+            .withOptionalPresentWait()
+            .withOptionalTextureCompression()
             .build(selectedConfig);
-    assert(!dbRes.has_value());
+    checkNoError(dbRes);
     {
         auto surfaceFormats = selectedConfig.physicalDevice
                                   .getSurfaceFormatsKHR(*selectedConfig.surfaceConfig.surface)
@@ -159,7 +178,7 @@ int main()
                 return format.format == config.backbufferFormat;
             });
 
-        assert(iter != surfaceFormats.end());
+        checkTrue(iter != surfaceFormats.end());
         selectedConfig.surfaceConfig.format = *iter;
     }
 
@@ -169,11 +188,52 @@ int main()
     }
 
     vk::UniqueDevice& device = selectedConfig.device;
+    GpuResources resources;
 
     // Preload shaders
     ShaderRegistry shaderRegistry;
-    assert(!shaderRegistry.loadVertexShader(device, ShaderPaths::Simple2D).has_value());
-    assert(!shaderRegistry.loadFragmentShader(device, ShaderPaths::ColorPassthrough).has_value());
+    {
+        std::optional<ShaderRegistry::Error> vertexError;
+        std::optional<ShaderRegistry::Error> fragmentError;
+        std::optional<ShaderRegistry::Error> spriteVertexError;
+        std::optional<ShaderRegistry::Error> spriteFragmentError;
+        std::optional<ShaderRegistry::Error> mipDownsampleError;
+
+        JobSystem::Counter shadersLoaded;
+        jobSystem.run(
+            [&]() { vertexError = shaderRegistry.loadVertexShader(device, ShaderPaths::Simple2D); },
+            &shadersLoaded);
+        jobSystem.run(
+            [&]() {
+                fragmentError =
+                    shaderRegistry.loadFragmentShader(device, ShaderPaths::ColorPassthrough);
+            },
+            &shadersLoaded);
+        jobSystem.run(
+            [&]() {
+                spriteVertexError = shaderRegistry.loadVertexShader(device, ShaderPaths::Sprite);
+            },
+            &shadersLoaded);
+        jobSystem.run(
+            [&]() {
+                spriteFragmentError =
+                    shaderRegistry.loadFragmentShader(device, ShaderPaths::SpriteFrag);
+            },
+            &shadersLoaded);
+        jobSystem.run(
+            [&]() {
+                mipDownsampleError =
+                    shaderRegistry.loadComputeShader(device, ShaderPaths::MipDownsample);
+            },
+            &shadersLoaded);
+        jobSystem.wait(shadersLoaded);
+
+        checkNoError(vertexError);
+        checkNoError(fragmentError);
+        checkNoError(spriteVertexError);
+        checkNoError(spriteFragmentError);
+        checkNoError(mipDownsampleError);
+    }
 
     auto pipelineBuilder =
         PipelineBuilder()
@@ -183,158 +243,420 @@ int main()
             .withVertexShader(ShaderPaths::Simple2D)
             .withFragmentShader(ShaderPaths::ColorPassthrough)
             .withPrimitiveTopology(PipelineBuilder::PrimitiveTopology::TriangleList)
-            .withViewport(PipelineBuilder::Viewport::Fullscreen)
+            .withViewport(PipelineBuilder::Viewport::Dynamic)
             .withRasterizerState(PipelineBuilder::Rasterizer::BackfaceCulling)
             .withMultisampleState(PipelineBuilder::Multisample::Disabled)
             .withBlendState(PipelineBuilder::Blend::Disabled)
-            .withLinearVertexLayout<TriangleVertex>(
-                vk::Format::eR32G32Sfloat,
-                vk::Format::eR32G32B32Sfloat);
+            .withVertexLayout(PackedTriangleVertexLayout);
 
     pipelineBuilder.build(selectedConfig);
+    PipelineHandle pipeline = resources.addPipeline(
+        std::move(selectedConfig.pipelineConfig.pipeline),
+        std::move(selectedConfig.pipelineConfig.layout));
 
     auto swapchainBuilder =
         SwapchainBuilder(config, selectedConfig.surfaceConfig.surface, selectedConfig.device)
+            .usingPhysicalDevice(selectedConfig.physicalDevice)
+            .withPresentModePreference(config.presentModePreference)
             .withBackbufferFormat(selectedConfig.surfaceConfig.format.format)
             .withColorSpace(selectedConfig.surfaceConfig.format.colorSpace)
             .createFramebuffersFor(selectedConfig.pipelineConfig.renderPass);
 
-    assert(!swapchainBuilder.build(selectedConfig.swapchainConfig));
+    checkNoError(swapchainBuilder.build(selectedConfig.swapchainConfig));
 
     // Command buffers
 
-    auto [ccpRes, commandPool] = selectedConfig.device->createCommandPoolUnique({
-        .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+    // Only used for one-off uploads, frames are recorded through their FrameContext
+    auto [ccpRes, uploadCommandPool] = selectedConfig.device->createCommandPoolUnique({
+        .flags = vk::CommandPoolCreateFlagBits::eTransient,
         .queueFamilyIndex = selectedConfig.queues.workQueueInfo.index,
     });
-    assert(ccpRes == vk::Result::eSuccess);
+    checkResult(ccpRes);
 
-    auto [acbRes, commandBuffers] = selectedConfig.device->allocateCommandBuffersUnique({
-        .commandPool = commandPool.get(),
-        .level = vk::CommandBufferLevel::ePrimary,
-        .commandBufferCount = 3,
-    });
-    assert(acbRes == vk::Result::eSuccess);
+    auto memoryProperties = selectedConfig.physicalDevice.getMemoryProperties();
+    auto deviceLimits = selectedConfig.physicalDevice.getProperties().limits;
 
-    // Sync
-    std::vector<vk::UniqueSemaphore> imageAvailableList(config.backbufferCount);
-    std::vector<vk::UniqueSemaphore> renderFinishedList(config.backbufferCount);
-    std::vector<vk::UniqueFence> fences(config.backbufferCount);
-    for(uint32_t i = 0; i < config.backbufferCount; ++i)
+    std::vector<FrameContext> frameContexts;
+    for(uint32_t i = 0; i < config.framesInFlight; ++i)
     {
-        auto [iasRes, imageAvailable] = selectedConfig.device->createSemaphoreUnique({});
-        assert(iasRes == vk::Result::eSuccess);
-        imageAvailableList[i] = std::move(imageAvailable);
-
-        auto [rfsRes, renderFinished] = selectedConfig.device->createSemaphoreUnique({});
-        assert(rfsRes == vk::Result::eSuccess);
-        renderFinishedList[i] = std::move(renderFinished);
-
-        auto [fRes, fence] = selectedConfig.device->createFenceUnique({
-            .flags = vk::FenceCreateFlagBits::eSignaled,
-        });
-        assert(fRes == vk::Result::eSuccess);
-        fences[i] = std::move(fence);
+        frameContexts.push_back(expectResult(
+            FrameContext::Builder(selectedConfig.device)
+                .usingJobSystem(jobSystem)
+                .withQueueFamily(selectedConfig.queues.workQueueInfo.index)
+                // Room for a bit over a million sprites
+                .withTransientBufferSize(32 * 1024 * 1024, memoryProperties)
+                .withGpuTimer(
+                    deviceLimits.timestampPeriod,
+                    selectedConfig.queues.workQueueInfo.properties.timestampValidBits)
+                .build()));
     }
 
-    auto memoryProperties = selectedConfig.physicalDevice.getMemoryProperties();
-
-    std::vector<TriangleVertex> vertices = {
-        TriangleVertex{{-0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
-        TriangleVertex{{0.0f, -0.5f}, {0.0f, 1.0f, 0.0f}},
-        TriangleVertex{{0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    // Every submission to the work queue goes through this
+    auto timeline = expectResult(GpuTimeline::create(selectedConfig.device));
+    DeletionQueue deletionQueue(timeline, &jobSystem);
+
+    constexpr uint32_t MaxBindlessTextures = 16 * 1024;
+    constexpr uint32_t MaxBindlessBuffers = 4 * 1024;
+    auto bindless = expectResult(BindlessDescriptors::create(
+        selectedConfig.device,
+        selectedConfig.physicalDevice,
+        timeline,
+        MaxBindlessTextures,
+        MaxBindlessBuffers));
+    auto [csRes, linearSampler] = selectedConfig.device->createSamplerUnique({
+        .magFilter = vk::Filter::eLinear,
+        .minFilter = vk::Filter::eLinear,
+        .mipmapMode = vk::SamplerMipmapMode::eLinear,
+        .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+        .maxLod = VK_LOD_CLAMP_NONE,
+    });
+    checkResult(csRes);
 
-        TriangleVertex{{-0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
-        TriangleVertex{{0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}},
-        TriangleVertex{{0.0f, 0.5f}, {0.0f, 1.0f, 0.0f}},
+    PipelineHandle spritePipeline =
+        PipelineBuilder()
+            .usingConfig(config)
+            .usingShaderRegistry(shaderRegistry)
+            .usingDevice(selectedConfig.device)
+            .usingPhysicalDevice(selectedConfig.physicalDevice)
+            .withVertexShader(ShaderPaths::Sprite)
+            .withFragmentShader(ShaderPaths::SpriteFrag)
+            .withPrimitiveTopology(PipelineBuilder::PrimitiveTopology::TriangleStrip)
+            .withViewport(PipelineBuilder::Viewport::Dynamic)
+            .withRasterizerState(PipelineBuilder::Rasterizer::NoCulling)
+            .withMultisampleState(PipelineBuilder::Multisample::Disabled)
+            .withBlendState(PipelineBuilder::Blend::Alpha)
+            .withPushConstants<SpriteBatch::PushConstants>(SpriteBatch::PushConstantStages)
+            .withDescriptorSetLayouts(bindless.getSetLayouts())
+            .withVertexLayout(SpriteBatch::InstanceLayout)
+            .build(resources, selectedConfig.pipelineConfig.renderPass.get());
+
+    // The timeline value of the frame that last rendered to each swapchain image. With more frames
+    // in flight than swapchain images an acquired image can still be in use
+    std::vector<uint64_t> imageTimelineValues(selectedConfig.swapchainConfig.images.size(), 0);
+    // Replaced swapchains that might still be presenting, see the end of the frame loop
+    std::vector<SelectedConfig::SwapChain> oldSwapchains;
+
+    std::vector<PackedTriangleVertex> vertices = {
+        packVertex({{-0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}}),
+        packVertex({{0.0f, -0.5f}, {0.0f, 1.0f, 0.0f}}),
+        packVertex({{0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}}),
+        packVertex({{0.0f, 0.5f}, {0.0f, 1.0f, 0.0f}}),
     };
-    auto verticesSize = sizeof(TriangleVertex) * vertices.size();
-
-    auto vertexBuffer = expectResult(Buffer::Builder(selectedConfig.device)
-                                         .withVertexBufferFormat()
-                                         .withTransferDestFormat(memoryProperties)
-                                         .withSize(verticesSize)
-                                         .build());
-    assert(
-        selectedConfig.device
-            ->bindBufferMemory(vertexBuffer.buffer.get(), vertexBuffer.memory.get(), 0)
-        == vk::Result::eSuccess);
+    std::vector<uint16_t> indices = {0, 1, 2, 0, 2, 3};
+    auto verticesSize = sizeof(PackedTriangleVertex) * vertices.size();
+    auto indicesSize = sizeof(uint16_t) * indices.size();
+
+    // A checkerboard with a full mip chain generated on the GPU
+    constexpr uint32_t CheckerSize = 256;
+    std::vector<uint32_t> checkerTexels(CheckerSize * CheckerSize);
+    for(uint32_t y = 0; y < CheckerSize; ++y)
+    {
+        for(uint32_t x = 0; x < CheckerSize; ++x)
+            checkerTexels[y * CheckerSize + x] = ((x / 32 + y / 32) % 2) ? 0xFFFFFFFF : 0xFF404040;
+    }
+    auto checkerSize = sizeof(uint32_t) * checkerTexels.size();
+    // Texel copies need 4 byte aligned offsets
+    auto checkerOffset = (verticesSize + indicesSize + 3) & ~(size_t)3;
+
+    auto mipGenerator = expectResult(
+        MipGenerator::create(selectedConfig.device, selectedConfig.physicalDevice, shaderRegistry));
+    constexpr vk::Format CheckerFormat = vk::Format::eR8G8B8A8Srgb;
+    auto checkerBuilder = Image::Builder(selectedConfig.device);
+    checkerBuilder.withExtent(CheckerSize, CheckerSize)
+        .withFormat(CheckerFormat)
+        .withFullMipChain()
+        .withTransferDestUsage()
+        .withSampledUsage()
+        .withMemoryProperties(memoryProperties);
+    auto checkerMipMethod = mipGenerator.methodFor(CheckerFormat);
+    checkTrue(checkerMipMethod != MipGenerator::Method::Unsupported);
+    if(checkerMipMethod == MipGenerator::Method::Blit)
+        checkerBuilder.withTransferSourceUsage();
+    else
+        checkerBuilder.withStorageUsage();
+    auto checker = expectResult(checkerBuilder.build());
+
+    BufferHandle vertexBuffer;
+    BufferHandle indexBuffer;
+    {
+        auto buffer = expectResult(Buffer::Builder(selectedConfig.device)
+                                       .withVertexBufferFormat()
+                                       .withTransferDestFormat(memoryProperties)
+                                       .withSize(verticesSize)
+                                       .build());
+        checkResult(selectedConfig.device->bindBufferMemory(
+            buffer.buffer.get(),
+            buffer.memory.get(),
+            0));
+        vertexBuffer = resources.addBuffer(std::move(buffer));
+
+        buffer = expectResult(Buffer::Builder(selectedConfig.device)
+                                  .withIndexBufferFormat()
+                                  .withTransferDestFormat(memoryProperties)
+                                  .withSize(indicesSize)
+                                  .build());
+        checkResult(selectedConfig.device->bindBufferMemory(
+            buffer.buffer.get(),
+            buffer.memory.get(),
+            0));
+        indexBuffer = resources.addBuffer(std::move(buffer));
+    }
 
     {
+        // Vertices followed by indices and the checkerboard
         auto srcBuffer = expectResult(Buffer::Builder(selectedConfig.device)
-                                          .withSize(verticesSize)
+                                          .withSize(checkerOffset + checkerSize)
                                           .withMapFunctionality(memoryProperties)
                                           .withTransferSourceFormat(memoryProperties)
                                           .build());
 
-        assert(
-            selectedConfig.device
-                ->bindBufferMemory(srcBuffer.buffer.get(), srcBuffer.memory.get(), 0)
-            == vk::Result::eSuccess);
+        checkResult(selectedConfig.device->bindBufferMemory(
+            srcBuffer.buffer.get(),
+            srcBuffer.memory.get(),
+            0));
 
         void* data;
-        assert(
-            selectedConfig.device
-                ->mapMemory(srcBuffer.memory.get(), 0, VK_WHOLE_SIZE, vk::MemoryMapFlags(), &data)
-            == vk::Result::eSuccess);
+        checkResult(selectedConfig.device->mapMemory(
+            srcBuffer.memory.get(),
+            0,
+            VK_WHOLE_SIZE,
+            vk::MemoryMapFlags(),
+            &data));
         std::memcpy(data, vertices.data(), verticesSize);
+        std::memcpy((uint8_t*)data + verticesSize, indices.data(), indicesSize);
+        std::memcpy((uint8_t*)data + checkerOffset, checkerTexels.data(), checkerSize);
         selectedConfig.device->unmapMemory(srcBuffer.memory.get());
 
         auto [acb2Res, copyBuffer] = selectedConfig.device->allocateCommandBuffersUnique({
-            .commandPool = commandPool.get(),
+            .commandPool = uploadCommandPool.get(),
             .level = vk::CommandBufferLevel::ePrimary,
             .commandBufferCount = 1,
         });
-        assert(acb2Res == vk::Result::eSuccess);
+        checkResult(acb2Res);
 
         vk::CommandBufferBeginInfo beginInfo = {
             .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
         };
-        assert(copyBuffer[0]->begin(beginInfo) == vk::Result::eSuccess);
+        checkResult(copyBuffer[0]->begin(beginInfo));
         vk::BufferCopy copyInfo{
             .size = verticesSize,
         };
-        copyBuffer[0]->copyBuffer(srcBuffer.buffer.get(), vertexBuffer.buffer.get(), 1, &copyInfo);
-        assert(copyBuffer[0]->end() == vk::Result::eSuccess);
-
-        vk::SubmitInfo submitInfo = {
-            .commandBufferCount = 1,
-            .pCommandBuffers = &copyBuffer[0].get(),
+        copyBuffer[0]->copyBuffer(
+            srcBuffer.buffer.get(),
+            resources.getBuffer(vertexBuffer),
+            1,
+            &copyInfo);
+        copyInfo = {
+            .srcOffset = verticesSize,
+            .size = indicesSize,
         };
-        assert(
-            selectedConfig.queues.workQueueInfo.queue.submit(1, &submitInfo, VK_NULL_HANDLE)
-            == vk::Result::eSuccess);
+        copyBuffer[0]->copyBuffer(
+            srcBuffer.buffer.get(),
+            resources.getBuffer(indexBuffer),
+            1,
+            &copyInfo);
+        checker.recordUpload(copyBuffer[0].get(), srcBuffer.buffer.get(), checkerOffset);
+        // The last frame in flight resets its allocator only after waiting for the upload below,
+        // so the earlier frames still don't have to wait for it
+        FrameContext& uploadFrame = frameContexts.back();
+        checkNoError(mipGenerator.generate(
+            copyBuffer[0].get(),
+            checker,
+            uploadFrame.descriptorAllocator,
+            deletionQueue,
+            timeline.getLastSubmitted() + 1));
+        // Covers every later submission to the queue, so frames don't have to wait for the upload
+        vk::MemoryBarrier uploadBarrier = {
+            .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+            .dstAccessMask =
+                vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead,
+        };
+        copyBuffer[0]->pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eVertexInput,
+            vk::DependencyFlags(),
+            1,
+            &uploadBarrier,
+            0,
+            nullptr,
+            0,
+            nullptr);
+        checkResult(copyBuffer[0]->end());
+
+        auto uploadValue = expectResult(timeline.submit(
+            selectedConfig.queues.workQueueInfo.queue,
+            {.commandBuffers = {&copyBuffer[0].get(), 1}}));
+
+        uploadFrame.timelineValue = uploadValue;
+        deletionQueue.retire(std::move(srcBuffer), uploadValue);
+        // The upload pool is only used here, so its command buffers can be freed from any thread
+        deletionQueue.retire(std::move(copyBuffer), uploadValue);
+    }
+    resources.addImage(std::move(checker));
 
-        assert(selectedConfig.queues.workQueueInfo.queue.waitIdle() == vk::Result::eSuccess);
+    // Sprites circling around random points
+    SpriteBatch spriteBatch(jobSystem);
+    uint8_t spritePipelineId = spriteBatch.addPipeline(spritePipeline);
+    std::vector<Sprite> sprites(20000);
+    std::vector<glm::vec2> spriteOrigins(sprites.size());
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for(size_t i = 0; i < sprites.size(); ++i)
+        {
+            spriteOrigins[i] = {
+                unit(random) * (float)config.resolutionWidth,
+                unit(random) * (float)config.resolutionHeight,
+            };
+            sprites[i] = Sprite{
+                .position = spriteOrigins[i],
+                .size = {8.0f, 8.0f},
+                .rotation = 0.0f,
+                .uvRect = {0.0f, 0.0f, 1.0f, 1.0f},
+                .color = (uint32_t)random() | 0x80000000,
+                .texture = 0,
+                .pipeline = spritePipelineId,
+                .layer = 0,
+            };
+        }
+    }
+    auto startTime = std::chrono::steady_clock::now();
+
+    auto atlas = expectResult(TextureAtlas::Builder(selectedConfig.device)
+                                  .usingMemoryProperties(memoryProperties)
+                                  .withPageSize(1024)
+                                  .withMaxPages(2)
+                                  .build());
+    // Soft white dots of a few sizes, added to the atlas whenever they aren't in it
+    std::vector<uint32_t> dotSizes = {8, 16, 24, 32};
+    std::vector<std::vector<uint32_t>> dotTexels;
+    for(uint32_t size : dotSizes)
+    {
+        std::vector<uint32_t>& texels = dotTexels.emplace_back(size * size);
+        float radius = (float)size * 0.5f;
+        for(uint32_t y = 0; y < size; ++y)
+        {
+            for(uint32_t x = 0; x < size; ++x)
+            {
+                float distance = glm::length(glm::vec2(x, y) + 0.5f - radius) / radius;
+                auto alpha = (uint32_t)(std::clamp(1.0f - distance, 0.0f, 1.0f) * 255.0f);
+                texels[y * size + x] = (alpha << 24) | 0x00FFFFFF;
+            }
+        }
+    }
+    std::vector<AtlasRegionHandle> dotRegionHandles(dotSizes.size());
+    std::vector<TextureAtlas::Region> dotRegions(dotSizes.size());
+    // Bindless texture index of each atlas page
+    std::vector<uint32_t> atlasPageTextures;
+
+    constexpr vk::DeviceSize TextureStreamingBudget = 4 * 1024 * 1024;
+    // Streams every KTX2 file in textures/ in over the first frames
+    TextureStreamer textureStreamer(
+        selectedConfig.device,
+        selectedConfig.physicalDevice,
+        memoryProperties,
+        frameContexts[0].transientBuffer.getCapacity());
+    TextureResidency textureResidency(
+        textureStreamer,
+        TextureResidency::budgetFromMemoryProperties(memoryProperties, 0.5f));
+    std::vector<StreamedTextureHandle> streamedTextures;
+    std::error_code textureDirError;
+    for(const auto& entry : std::filesystem::directory_iterator("textures", textureDirError))
+    {
+        if(entry.path().extension() != ".ktx2")
+            continue;
+        // Starts with just the tail, the residency manager asks for more
+        auto textureVar = textureStreamer.load(entry.path(), UINT32_MAX);
+        if(std::holds_alternative<TextureStreamer::Error>(textureVar))
+        {
+            std::cout << "Failed to load " << entry.path() << std::endl;
+            continue;
+        }
+        streamedTextures.push_back(std::get<StreamedTextureHandle>(textureVar));
+        textureResidency.add(streamedTextures.back());
     }
 
+    // Meshes and textures cooked by asset_cook into assets/, uploaded over the first frames
+    AssetLoader assetLoader(selectedConfig.device, memoryProperties, resources, false);
+    std::vector<std::filesystem::path> pendingAssets;
+    std::vector<LoadedMesh> loadedMeshes;
+    std::vector<ImageHandle> loadedTextures;
+    std::error_code assetDirError;
+    for(const auto& entry : std::filesystem::directory_iterator("assets", assetDirError))
+    {
+        if(entry.path().extension() == ".mesh" || entry.path().extension() == ".texture")
+            pendingAssets.push_back(entry.path());
+    }
+
+    // OBJ and glTF scenes in meshes/ are parsed up front and uploaded over the following frames
+    constexpr vk::DeviceSize MeshUploadBudget = 8 * 1024 * 1024;
+    MeshUploader meshUploader(selectedConfig.device, memoryProperties, resources);
+    std::error_code meshDirError;
+    for(const auto& entry : std::filesystem::directory_iterator("meshes", meshDirError))
+    {
+        std::optional<MeshData> mesh;
+        if(entry.path().extension() == ".obj")
+        {
+            auto file = MappedFile::open(entry.path());
+            if(!file.has_value())
+                continue;
+            std::string_view text((const char*)file->getData().data(), file->getData().size());
+            auto meshVar = ObjLoader::parse(text, jobSystem);
+            if(std::holds_alternative<MeshData>(meshVar))
+                mesh = std::move(std::get<MeshData>(meshVar));
+        }
+        else if(entry.path().extension() == ".gltf")
+        {
+            auto meshVar = GltfLoader::load(entry.path(), jobSystem);
+            if(std::holds_alternative<MeshData>(meshVar))
+                mesh = std::move(std::get<MeshData>(meshVar));
+        }
+        else
+            continue;
+
+        if(!mesh.has_value() || mesh->indices.empty())
+        {
+            std::cout << "Failed to load " << entry.path() << std::endl;
+            continue;
+        }
+        // ObjLoader emits a vertex per face corner
+        mesh->vertices.resize(MeshOptimizer::deduplicateVertices(
+            mesh->vertices.data(),
+            (uint32_t)mesh->vertices.size(),
+            sizeof(MeshVertex),
+            std::span(mesh->indices)));
+        loadedMeshes.push_back(expectResult(meshUploader.add(std::move(mesh.value()))));
+    }
+
+    FrameStats frameStats(std::chrono::seconds(10));
+    frameStats.withExport(
+        "frame_stats.prom",
+        FrameStats::Format::Prometheus,
+        std::chrono::seconds(1));
+
+    PresentPacer presentPacer(
+        selectedConfig.device.get(),
+        selectedConfig.deviceFeatures.presentWait,
+        config.maxQueuedPresents);
+
     bool recreateSwapchain = false;
     uint32_t frame = 0;
-    uint32_t backbufferFrame = 0;
+    uint32_t frameIndex = 0;
     while(!mainWindow->shouldClose())
     {
+        if(auto latency = presentPacer.wait(selectedConfig.swapchainConfig.swapchain.get()))
+            frameStats.record(FrameStats::Metric::InputToPresent, latency.value());
+
         mainWindow->pollEvents();
+        presentPacer.markInput();
+        jobSystem.pumpMainThread();
+
+        deletionQueue.collect();
 
         if(windowResized || recreateSwapchain)
         {
-            assert(selectedConfig.device->waitIdle() == vk::Result::eSuccess);
-
-            // The GLFW window size and the surface capabilities extents tend to not match, so let's
-            // not even do that
-            auto val = selectedConfig.physicalDevice
-                           .getSurfaceCapabilitiesKHR(*selectedConfig.surfaceConfig.surface)
-                           .value;
-
-            auto clampedWidth = std::max(
-                val.minImageExtent.width,
-                std::min(val.maxImageExtent.width, config.resolutionWidth));
-            auto clampedHeight = std::max(
-                val.minImageExtent.height,
-                std::min(val.maxImageExtent.height, config.resolutionHeight));
-
-            config.resolutionWidth = clampedWidth;
-            config.resolutionHeight = clampedHeight;
-
             // I can't verify this because i3wm never minimizes, but vulkan-tutorial says this works
             // :)
             int width = 0;
@@ -352,13 +674,35 @@ int main()
 
             windowResized = false;
 
-            selectedConfig.pipelineConfig = {};
-            selectedConfig.swapchainConfig = {};
-
-            pipelineBuilder.build(selectedConfig);
-            swapchainBuilder.createFramebuffersFor(selectedConfig.pipelineConfig.renderPass);
+            // The GLFW window size and the surface capabilities extents tend to not match, so
+            // prefer the surface's current extent when it has one
+            auto val = selectedConfig.physicalDevice
+                           .getSurfaceCapabilitiesKHR(*selectedConfig.surfaceConfig.surface)
+                           .value;
+            if(val.currentExtent.width != UINT32_MAX)
+            {
+                width = (int)val.currentExtent.width;
+                height = (int)val.currentExtent.height;
+            }
 
-            assert(!swapchainBuilder.build(selectedConfig.swapchainConfig));
+            config.resolutionWidth = std::clamp(
+                (uint32_t)width,
+                val.minImageExtent.width,
+                val.maxImageExtent.width);
+            config.resolutionHeight = std::clamp(
+                (uint32_t)height,
+                val.minImageExtent.height,
+                val.maxImageExtent.height);
+
+            // The pipeline uses dynamic viewport/scissor and the render pass only depends on the
+            // format, so only the swapchain and its framebuffers are rebuilt. The old swapchain
+            // is chained into the new one and kept until a frame has been presented to the new one
+            oldSwapchains.push_back(std::move(selectedConfig.swapchainConfig));
+            checkNoError(swapchainBuilder.build(
+                selectedConfig.swapchainConfig,
+                oldSwapchains.back().swapchain.get()));
+            presentPacer.resetSwapchain();
+            imageTimelineValues.assign(selectedConfig.swapchainConfig.images.size(), 0);
 
             recreateSwapchain = false;
 
@@ -366,9 +710,17 @@ int main()
             continue;
         }
 
-        auto wffRes =
-            selectedConfig.device->waitForFences(fences[backbufferFrame].get(), true, UINT64_MAX);
-        assert(wffRes == vk::Result::eSuccess);
+        frameStats.markFrame();
+        if(auto exportError = frameStats.exportIfDue())
+            std::cout << exportError->FileWrite.message << std::endl;
+
+        FrameContext& frameContext = frameContexts[frameIndex];
+        {
+            auto timer = frameStats.time(FrameStats::Metric::FrameWait);
+            checkResult(timeline.wait(frameContext.timelineValue));
+        }
+        if(auto gpuTime = frameContext.readGpuTime())
+            frameStats.record(FrameStats::Metric::GpuTime, gpuTime.value());
 
 #define handleRetError(Fun)                                                            \
     {                                                                                  \
@@ -380,7 +732,7 @@ int main()
         }                                                                              \
         else                                                                           \
         {                                                                              \
-            assert(res == vk::Result::eSuccess);                                       \
+            checkResult(res);                                                          \
         }                                                                              \
     }
 
@@ -393,77 +745,224 @@ int main()
         }                                                                                  \
         else                                                                               \
         {                                                                                  \
-            assert((val) == vk::Result::eSuccess);                                         \
+            checkResult(val);                                                              \
         }                                                                                  \
     }
 
+        auto acquireStart = std::chrono::steady_clock::now();
         auto [acnRes, swapchainImageIndex] = selectedConfig.device->acquireNextImageKHR(
             *selectedConfig.swapchainConfig.swapchain,
             UINT64_MAX,
-            imageAvailableList[backbufferFrame].get(),
+            frameContext.imageAvailable.get(),
             VK_NULL_HANDLE);
-        handleError(acnRes);
+        frameStats.record(
+            FrameStats::Metric::AcquireWait,
+            std::chrono::steady_clock::now() - acquireStart);
+        // A suboptimal swapchain can still be presented to, so finish the frame and recreate it
+        // afterwards since the image has already been acquired
+        if(acnRes == vk::Result::eSuboptimalKHR)
+            recreateSwapchain = true;
+        else
+            handleError(acnRes);
+
+        checkResult(timeline.wait(imageTimelineValues[swapchainImageIndex]));
 
-        selectedConfig.device->resetFences(fences[backbufferFrame].get());
+        checkResult(frameContext.reset());
 
-        auto& commandBuffer = commandBuffers[backbufferFrame];
-        commandBuffer->reset();
-        vk::CommandBufferBeginInfo beginInfo = {};
-        assert(commandBuffer->begin(beginInfo) == vk::Result::eSuccess);
+        for(size_t i = 0; i < dotSizes.size(); ++i)
+        {
+            auto region = atlas.use(dotRegionHandles[i], frame);
+            if(!region.has_value())
+            {
+                dotRegionHandles[i] = expectResult(atlas.add(
+                    dotSizes[i],
+                    dotSizes[i],
+                    dotTexels[i].data(),
+                    frameContext.transientBuffer,
+                    frame));
+                region = atlas.use(dotRegionHandles[i], frame);
+            }
+            dotRegions[i] = region.value();
+        }
+        // Pages are created as they are needed
+        while(atlasPageTextures.size() < atlas.getPageCount())
+        {
+            auto page = (uint32_t)atlasPageTextures.size();
+            auto index = bindless.addTexture(atlas.getPageView(page), linearSampler.get());
+            checkTrue(index.has_value());
+            atlasPageTextures.push_back(index.value());
+        }
 
+        float time =
+            std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+        jobSystem.parallelFor((uint32_t)sprites.size(), 4096, [&](uint32_t begin, uint32_t end) {
+            for(uint32_t i = begin; i < end; ++i)
+            {
+                float angle = time + (float)i;
+                sprites[i].position =
+                    spriteOrigins[i] + glm::vec2(std::cos(angle), std::sin(angle)) * 32.0f;
+                sprites[i].rotation = angle;
+
+                const TextureAtlas::Region& region = dotRegions[i % dotRegions.size()];
+                sprites[i].texture = atlasPageTextures[region.page];
+                sprites[i].uvRect = region.uvRect;
+            }
+        });
+        spriteBatch.begin();
+        spriteBatch.submit(sprites);
+        if(!spriteBatch.prepare(frameContext.transientBuffer))
+            std::cout << "Sprites don't fit into the transient buffer" << std::endl;
+        vk::CommandBuffer commandBuffer = frameContext.commandRecorder.primary();
+        vk::CommandBufferBeginInfo beginInfo = {
+            .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+        };
+        checkResult(commandBuffer.begin(beginInfo));
+        frameContext.beginGpuTimer(commandBuffer);
+        atlas.recordUploads(commandBuffer);
+        for(StreamedTextureHandle texture : streamedTextures)
+            textureResidency.markUsed(texture, frame);
+        textureResidency.update(frame);
+        // Textures that can't grow right now keep their levels, the residency manager asks again
+        if(auto error = textureStreamer.update(
+               commandBuffer,
+               frameContext.transientBuffer,
+               TextureStreamingBudget,
+               deletionQueue,
+               timeline.getLastSubmitted() + 1))
+        {
+            checkTrue(error->type == TextureStreamer::ErrorType::CreateImage);
+            std::cout << "Failed to resize a streamed texture" << std::endl;
+        }
+        while(!pendingAssets.empty())
+        {
+            const std::filesystem::path& path = pendingAssets.back();
+            std::optional<AssetLoader::Error> error;
+            if(path.extension() == ".mesh")
+            {
+                auto meshVar =
+                    assetLoader.loadMesh(path, commandBuffer, frameContext.transientBuffer);
+                if(std::holds_alternative<LoadedMesh>(meshVar))
+                    loadedMeshes.push_back(std::get<LoadedMesh>(meshVar));
+                else
+                    error = std::get<AssetLoader::Error>(meshVar);
+            }
+            else
+            {
+                auto textureVar =
+                    assetLoader.loadTexture(path, commandBuffer, frameContext.transientBuffer);
+                if(std::holds_alternative<ImageHandle>(textureVar))
+                    loadedTextures.push_back(std::get<ImageHandle>(textureVar));
+                else
+                    error = std::get<AssetLoader::Error>(textureVar);
+            }
+            // The rest waits for the next frame's staging
+            if(error.has_value() && error->type == AssetLoader::ErrorType::StagingFull)
+                break;
+            // Dropped rather than retried, it would block every asset after it
+            if(error.has_value() && error->type == AssetLoader::ErrorType::TooLargeForStaging)
+                std::cout << path << " is too large for the staging buffer" << std::endl;
+            else if(error.has_value())
+                std::cout << "Failed to load " << path << std::endl;
+            pendingAssets.pop_back();
+        }
+        meshUploader.update(commandBuffer, frameContext.transientBuffer, MeshUploadBudget);
+
+        vk::Framebuffer framebuffer =
+            selectedConfig.swapchainConfig.framebuffers[swapchainImageIndex].get();
         vk::ClearValue clearValue = {std::array<float, 4>({0.0f, 0.0f, 0.0f, 1.0f})};
-        commandBuffer->beginRenderPass(
+        commandBuffer.beginRenderPass(
             {
                 .renderPass = selectedConfig.pipelineConfig.renderPass.get(),
-                .framebuffer =
-                    selectedConfig.swapchainConfig.framebuffers[swapchainImageIndex].get(),
-                .renderArea = selectedConfig.pipelineConfig.renderArea,
+                .framebuffer = framebuffer,
+                .renderArea = {.offset = {0, 0}, .extent = selectedConfig.swapchainConfig.extent},
                 .clearValueCount = 1,
                 .pClearValues = &clearValue,
             },
-            vk::SubpassContents::eInline);
-        commandBuffer->bindPipeline(
-            vk::PipelineBindPoint::eGraphics,
-            *selectedConfig.pipelineConfig.pipeline);
-        vk::DeviceSize offset = 0;
-        commandBuffer->bindVertexBuffers(0, 1, &vertexBuffer.buffer.get(), &offset);
-        commandBuffer->draw(vertices.size(), 1, 0, 0);
-        commandBuffer->endRenderPass();
-        assert(commandBuffer->end() == vk::Result::eSuccess);
-
-        vk::PipelineStageFlags waitDstStageMask[] = {
-            vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        };
-        assert(
-            selectedConfig.queues.workQueueInfo.queue.submit(
-                {{
-                    .waitSemaphoreCount = 1,
-                    .pWaitSemaphores = &imageAvailableList[backbufferFrame].get(),
-                    .pWaitDstStageMask = waitDstStageMask,
-                    .commandBufferCount = 1,
-                    .pCommandBuffers = &commandBuffer.get(),
-                    .signalSemaphoreCount = 1,
-                    .pSignalSemaphores = &renderFinishedList[backbufferFrame].get(),
-                }},
-                fences[backbufferFrame].get())
-            == vk::Result::eSuccess);
+            vk::SubpassContents::eSecondaryCommandBuffers);
+        checkResult(frameContext.commandRecorder.recordParallel(
+            {
+                .renderPass = selectedConfig.pipelineConfig.renderPass.get(),
+                .subpass = 0,
+                .framebuffer = framebuffer,
+            },
+            1,
+            [&](vk::CommandBuffer secondary, uint32_t) {
+                const vk::Extent2D& extent = selectedConfig.swapchainConfig.extent;
+                vk::Viewport viewport = {
+                    .x = 0.0f,
+                    .y = 0.0f,
+                    .width = (float)extent.width,
+                    .height = (float)extent.height,
+                    .minDepth = 0.0f,
+                    .maxDepth = 1.0f,
+                };
+                vk::Rect2D scissor = {.offset = {0, 0}, .extent = extent};
+                secondary.setViewport(0, 1, &viewport);
+                secondary.setScissor(0, 1, &scissor);
+                secondary.bindPipeline(
+                    vk::PipelineBindPoint::eGraphics,
+                    resources.getPipeline(pipeline));
+                Commands::VertexStream streams[] = {
+                    {.buffer = resources.getBuffer(vertexBuffer), .offset = 0},
+                };
+                Commands::bindVertexStreams(secondary, streams);
+                secondary.bindIndexBuffer(
+                    resources.getBuffer(indexBuffer),
+                    0,
+                    indexTypeOf<uint16_t>());
+                secondary.drawIndexed((uint32_t)indices.size(), 1, 0, 0, 0);
+
+                bindless.bind(
+                    secondary,
+                    vk::PipelineBindPoint::eGraphics,
+                    resources.getPipelineLayout(spritePipeline));
+                spriteBatch.record(secondary, resources, extent);
+            }));
+        commandBuffer.endRenderPass();
+        frameContext.endGpuTimer(commandBuffer);
+        checkResult(commandBuffer.end());
+
+        frameContext.timelineValue = expectResult(timeline.submit(
+            selectedConfig.queues.workQueueInfo.queue,
+            {
+                .commandBuffers = {&commandBuffer, 1},
+                .waitSemaphore = frameContext.imageAvailable.get(),
+                .waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                .signalSemaphore =
+                    selectedConfig.swapchainConfig.renderFinished[swapchainImageIndex].get(),
+            }));
+        imageTimelineValues[swapchainImageIndex] = frameContext.timelineValue;
 
         vk::PresentInfoKHR presentInfo = {
             .waitSemaphoreCount = 1,
-            .pWaitSemaphores = &renderFinishedList[backbufferFrame].get(),
+            .pWaitSemaphores =
+                &selectedConfig.swapchainConfig.renderFinished[swapchainImageIndex].get(),
             .swapchainCount = 1,
             .pSwapchains = &selectedConfig.swapchainConfig.swapchain.get(),
             .pImageIndices = &swapchainImageIndex,
             .pResults = nullptr,
         };
+        presentPacer.attach(presentInfo);
+
+        {
+            auto timer = frameStats.time(FrameStats::Metric::Present);
+            handleRetError(selectedConfig.queues.workQueueInfo.queue.presentKHR(presentInfo));
+        }
 
-        handleRetError(selectedConfig.queues.workQueueInfo.queue.presentKHR(presentInfo));
+        // Presents on the queue are processed in order and this frame waited for an image of the
+        // new swapchain, so once it completes the presentation engine has handed out a newer image
+        // than any old present. That is only a heuristic for the old presents' semaphore waits
+        // having finished, VK_EXT_swapchain_maintenance1 present fences would make it exact
+        for(SelectedConfig::SwapChain& oldSwapchain : oldSwapchains)
+            deletionQueue.retire(std::move(oldSwapchain), frameContext.timelineValue);
+        oldSwapchains.clear();
 
         frame++;
-        backbufferFrame = frame % config.backbufferCount;
+        frameIndex = frame % config.framesInFlight;
     }
 
-    assert(selectedConfig.device->waitIdle() == vk::Result::eSuccess);
+    checkResult(selectedConfig.device->waitIdle());
+    deletionQueue.flush();
 
     glfwTerminate();
     return 0;
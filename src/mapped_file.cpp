@@ -0,0 +1,103 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path& path)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        return std::nullopt;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return std::nullopt;
+    }
+
+    // The view keeps the mapping and the file alive on its own
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(!mapping)
+        return std::nullopt;
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(!data)
+        return std::nullopt;
+
+    return MappedFile((const std::byte*)data, (size_t)size.QuadPart);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0)
+        return std::nullopt;
+
+    struct stat status;
+    if(fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close(file);
+        return std::nullopt;
+    }
+
+    // The mapping keeps the file alive on its own
+    void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if(data == MAP_FAILED)
+        return std::nullopt;
+
+    return MappedFile((const std::byte*)data, (size_t)status.st_size);
+#endif
+}
+
+MappedFile::MappedFile(const std::byte* data, size_t size)
+    : data(data)
+    , size(size)
+{
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : data(std::exchange(other.data, nullptr))
+    , size(std::exchange(other.size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    if(!data)
+        return;
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+std::span<const std::byte> MappedFile::getData() const
+{
+    return {data, size};
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Pages are only read from disk once they are touched and the OS can drop them again under memory
+ * pressure, so large assets can be read piece by piece without holding a copy of the file.
+ */
+class MappedFile
+{
+  public:
+    // std::nullopt if the file can't be opened or mapped. Empty files can't be mapped
+    static std::optional<MappedFile> open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&&);
+    MappedFile& operator=(MappedFile&&);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    std::span<const std::byte> getData() const;
+
+  private:
+    MappedFile(const std::byte* data, size_t size);
+
+    const std::byte* data;
+    size_t size;
+};
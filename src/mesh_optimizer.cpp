@@ -0,0 +1,349 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+    // For every vertex, the triangles that use it
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> counts;
+        std::vector<uint32_t> triangles;
+    };
+
+    template<typename Index>
+    Adjacency buildAdjacency(std::span<const Index> indices, uint32_t vertexCount)
+    {
+        Adjacency adjacency;
+        adjacency.offsets.resize(vertexCount, 0);
+        adjacency.counts.resize(vertexCount, 0);
+        adjacency.triangles.resize(indices.size());
+
+        for(Index index : indices)
+            adjacency.counts[index]++;
+
+        uint32_t offset = 0;
+        for(uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            adjacency.offsets[vertex] = offset;
+            offset += adjacency.counts[vertex];
+        }
+
+        std::vector<uint32_t> fill = adjacency.offsets;
+        for(size_t i = 0; i < indices.size(); ++i)
+            adjacency.triangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+
+        return adjacency;
+    }
+
+    // Rewrites vertices and indices with `remap[old] = new`, where unmapped vertices are ~0u
+    template<typename Index>
+    void applyRemap(
+        void* vertices,
+        uint32_t vertexCount,
+        uint32_t stride,
+        std::span<Index> indices,
+        const std::vector<uint32_t>& remap,
+        uint32_t newVertexCount)
+    {
+        std::vector<uint8_t> copy((uint8_t*)vertices, (uint8_t*)vertices + vertexCount * stride);
+        for(uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            if(remap[vertex] != ~0u)
+            {
+                std::memcpy(
+                    (uint8_t*)vertices + remap[vertex] * stride,
+                    copy.data() + vertex * stride,
+                    stride);
+            }
+        }
+        assert(newVertexCount <= vertexCount);
+        (void)newVertexCount;
+
+        for(Index& index : indices)
+            index = (Index)remap[index];
+    }
+}
+
+namespace MeshOptimizer
+{
+    template<typename Index>
+    uint32_t deduplicateVertices(
+        void* vertices,
+        uint32_t vertexCount,
+        uint32_t stride,
+        std::span<Index> indices)
+    {
+        // Unique vertex bytes -> new index
+        std::unordered_map<std::string_view, uint32_t> unique;
+        unique.reserve(vertexCount);
+        std::vector<uint32_t> remap(vertexCount, ~0u);
+        uint32_t uniqueCount = 0;
+
+        // Walk in index order so the unique vertices also end up in order of first use
+        for(Index index : indices)
+        {
+            if(remap[index] != ~0u)
+                continue;
+
+            std::string_view bytes((const char*)vertices + index * stride, stride);
+            auto [iter, inserted] = unique.try_emplace(bytes, uniqueCount);
+            if(inserted)
+                uniqueCount++;
+            remap[index] = iter->second;
+        }
+
+        applyRemap(vertices, vertexCount, stride, indices, remap, uniqueCount);
+        return uniqueCount;
+    }
+
+    template<typename Index>
+    void optimizeVertexCache(std::span<Index> indices, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+        if(triangleCount == 0)
+            return;
+
+        Adjacency adjacency = buildAdjacency<Index>(indices, vertexCount);
+
+        // Number of triangles that still have to be emitted for each vertex
+        std::vector<uint32_t> live = adjacency.counts;
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+
+        std::vector<Index> output;
+        output.reserve(indices.size());
+
+        // Starting at cacheSize + 1 makes every vertex a miss initially
+        uint32_t time = cacheSize + 1;
+        uint32_t cursor = 0;
+        int64_t fanning = 0;
+
+        while(fanning >= 0)
+        {
+            candidates.clear();
+
+            uint32_t begin = adjacency.offsets[fanning];
+            uint32_t end = begin + adjacency.counts[fanning];
+            for(uint32_t i = begin; i < end; ++i)
+            {
+                uint32_t triangle = adjacency.triangles[i];
+                if(emitted[triangle])
+                    continue;
+
+                for(uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    Index vertex = indices[triangle * 3 + corner];
+                    output.push_back(vertex);
+                    deadEnd.push_back(vertex);
+                    candidates.push_back(vertex);
+                    live[vertex]--;
+
+                    if(time - cacheTime[vertex] > cacheSize)
+                        cacheTime[vertex] = time++;
+                }
+                emitted[triangle] = true;
+            }
+
+            // Prefer the candidate that is still in the cache and that will stay there while its
+            // remaining triangles are emitted
+            fanning = -1;
+            int64_t bestPriority = -1;
+            for(uint32_t vertex : candidates)
+            {
+                if(live[vertex] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                if(time - cacheTime[vertex] + 2 * live[vertex] <= cacheSize)
+                    priority = time - cacheTime[vertex];
+                if(priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    fanning = vertex;
+                }
+            }
+
+            // Dead end: go back through recently used vertices, then continue in input order
+            while(fanning < 0 && !deadEnd.empty())
+            {
+                uint32_t vertex = deadEnd.back();
+                deadEnd.pop_back();
+                if(live[vertex] > 0)
+                    fanning = vertex;
+            }
+            while(fanning < 0 && cursor < vertexCount)
+            {
+                if(live[cursor] > 0)
+                    fanning = cursor;
+                cursor++;
+            }
+        }
+
+        assert(output.size() == triangleCount * 3);
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    template<typename Index>
+    void optimizeOverdraw(
+        std::span<Index> indices,
+        const float* positions,
+        uint32_t vertexCount,
+        uint32_t positionStride,
+        uint32_t cacheSize)
+    {
+        uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+        if(triangleCount == 0)
+            return;
+
+        auto position = [positions, positionStride](Index vertex) {
+            const float* p = (const float*)((const uint8_t*)positions + vertex * positionStride);
+            return glm::vec3(p[0], p[1], p[2]);
+        };
+
+        // A triangle whose three vertices all miss the cache starts a new cluster. Reordering
+        // clusters loses whatever reuse there was across their boundaries, which is the price for
+        // less overdraw, but a boundary at a full miss keeps that loss small
+        std::vector<uint32_t> clusterStarts;
+        {
+            std::vector<uint32_t> cacheTime(vertexCount, 0);
+            uint32_t time = cacheSize + 1;
+            for(uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+            {
+                uint32_t misses = 0;
+                for(uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    Index vertex = indices[triangle * 3 + corner];
+                    if(time - cacheTime[vertex] > cacheSize)
+                    {
+                        cacheTime[vertex] = time++;
+                        misses++;
+                    }
+                }
+                if(misses == 3 || triangle == 0)
+                    clusterStarts.push_back(triangle);
+            }
+        }
+        clusterStarts.push_back(triangleCount);
+        uint32_t clusterCount = (uint32_t)clusterStarts.size() - 1;
+
+        glm::vec3 meshCentroid(0.0f);
+        for(Index index : indices)
+            meshCentroid += position(index);
+        meshCentroid /= (float)indices.size();
+
+        // Clusters facing away from the mesh center are likely to occlude the rest, so draw them
+        // first
+        std::vector<float> sortKeys(clusterCount);
+        for(uint32_t cluster = 0; cluster < clusterCount; ++cluster)
+        {
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for(uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1];
+                ++triangle)
+            {
+                glm::vec3 a = position(indices[triangle * 3 + 0]);
+                glm::vec3 b = position(indices[triangle * 3 + 1]);
+                glm::vec3 c = position(indices[triangle * 3 + 2]);
+                glm::vec3 faceNormal = glm::cross(b - a, c - a);
+                float faceArea = glm::length(faceNormal);
+
+                centroid += (a + b + c) * (faceArea / 3.0f);
+                normal += faceNormal;
+                area += faceArea;
+            }
+
+            float normalLength = glm::length(normal);
+            if(area == 0.0f || normalLength == 0.0f)
+            {
+                sortKeys[cluster] = 0.0f;
+                continue;
+            }
+            centroid /= area;
+            sortKeys[cluster] = glm::dot(centroid - meshCentroid, normal / normalLength);
+        }
+
+        std::vector<uint32_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) {
+            return sortKeys[a] > sortKeys[b];
+        });
+
+        std::vector<Index> output;
+        output.reserve(indices.size());
+        for(uint32_t cluster : order)
+        {
+            output.insert(
+                output.end(),
+                indices.begin() + clusterStarts[cluster] * 3,
+                indices.begin() + clusterStarts[cluster + 1] * 3);
+        }
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    template<typename Index>
+    uint32_t optimizeVertexFetch(
+        void* vertices,
+        uint32_t vertexCount,
+        uint32_t stride,
+        std::span<Index> indices)
+    {
+        std::vector<uint32_t> remap(vertexCount, ~0u);
+        uint32_t nextVertex = 0;
+        for(Index index : indices)
+        {
+            if(remap[index] == ~0u)
+                remap[index] = nextVertex++;
+        }
+
+        applyRemap(vertices, vertexCount, stride, indices, remap, nextVertex);
+        return nextVertex;
+    }
+
+    template<typename Index>
+    float averageCacheMissRatio(
+        const Index* indices,
+        uint32_t indexCount,
+        uint32_t vertexCount,
+        uint32_t cacheSize)
+    {
+        if(indexCount < 3)
+            return 0.0f;
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        uint32_t time = cacheSize + 1;
+        uint32_t misses = 0;
+        for(uint32_t i = 0; i < indexCount; ++i)
+        {
+            if(time - cacheTime[indices[i]] > cacheSize)
+            {
+                cacheTime[indices[i]] = time++;
+                misses++;
+            }
+        }
+        return (float)misses / (float)(indexCount / 3);
+    }
+
+#define INSTANTIATE(Index)                                                                        \
+    template uint32_t deduplicateVertices(void*, uint32_t, uint32_t, std::span<Index>);           \
+    template void optimizeVertexCache(std::span<Index>, uint32_t, uint32_t);                      \
+    template void optimizeOverdraw(std::span<Index>, const float*, uint32_t, uint32_t, uint32_t); \
+    template uint32_t optimizeVertexFetch(void*, uint32_t, uint32_t, std::span<Index>);           \
+    template float averageCacheMissRatio(const Index*, uint32_t, uint32_t, uint32_t);
+
+    INSTANTIATE(uint16_t)
+    INSTANTIATE(uint32_t)
+#undef INSTANTIATE
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief Offline-style mesh processing to cut vertex shader invocations and vertex fetch
+ * bandwidth. The usual order is `deduplicateVertices`, `optimizeVertexCache`, `optimizeOverdraw`
+ * and finally `optimizeVertexFetch`.
+ *
+ * Vertices are treated as opaque blobs of `stride` bytes, and every function works on both 16 and
+ * 32 bit indices.
+ */
+namespace MeshOptimizer
+{
+    // Matches the post-transform cache of most desktop GPUs closely enough
+    constexpr uint32_t DefaultCacheSize = 16;
+
+    /**
+     * @brief Merges byte-identical vertices, moving the unique ones to the front in order of first
+     * use and rewriting `indices`. Returns the new vertex count.
+     *
+     * Vertices are compared byte by byte, so padding in the vertex struct must be zeroed
+     */
+    template<typename Index>
+    uint32_t deduplicateVertices(
+        void* vertices,
+        uint32_t vertexCount,
+        uint32_t stride,
+        std::span<Index> indices);
+
+    /**
+     * @brief Reorders triangles for post-transform cache locality using Tipsify (Sander et al.,
+     * "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+     */
+    template<typename Index>
+    void optimizeVertexCache(
+        std::span<Index> indices,
+        uint32_t vertexCount,
+        uint32_t cacheSize = DefaultCacheSize);
+
+    /**
+     * @brief Splits cache-optimized triangles into clusters at cache boundaries and sorts the
+     * clusters so outward facing ones come first, which lowers overdraw without hurting the cache
+     * much. `positions` points at the xyz floats of vertex 0, `positionStride` is in bytes
+     */
+    template<typename Index>
+    void optimizeOverdraw(
+        std::span<Index> indices,
+        const float* positions,
+        uint32_t vertexCount,
+        uint32_t positionStride,
+        uint32_t cacheSize = DefaultCacheSize);
+
+    /**
+     * @brief Reorders vertices in order of first use so vertex fetch reads memory mostly linearly,
+     * and rewrites `indices`. Unreferenced vertices are dropped; returns the new vertex count
+     */
+    template<typename Index>
+    uint32_t optimizeVertexFetch(
+        void* vertices,
+        uint32_t vertexCount,
+        uint32_t stride,
+        std::span<Index> indices);
+
+    // Average cache misses per triangle with a FIFO cache, between 0.5 (ideal) and 3
+    template<typename Index>
+    float averageCacheMissRatio(
+        const Index* indices,
+        uint32_t indexCount,
+        uint32_t vertexCount,
+        uint32_t cacheSize = DefaultCacheSize);
+}
@@ -0,0 +1,295 @@
+#include "obj_loader.h"
+
+#include <charconv>
+#include <optional>
+
+namespace
+{
+    constexpr uint32_t Missing = UINT32_MAX;
+    constexpr uint32_t Invalid = UINT32_MAX - 1;
+
+    // Large enough that a chunk takes a while to parse, small enough to balance over the threads
+    constexpr size_t ChunkSize = 1024 * 1024;
+
+    struct Corner
+    {
+        uint32_t position;
+        // Missing or Invalid for both
+        uint32_t uv;
+        uint32_t normal;
+    };
+
+    struct Chunk
+    {
+        std::string_view text;
+
+        // Counted by the first pass
+        uint32_t lineCount = 0;
+        uint32_t positionCount = 0;
+        uint32_t uvCount = 0;
+        uint32_t normalCount = 0;
+
+        // Sums of the counts of every earlier chunk
+        uint32_t firstLine = 0;
+        uint32_t firstPosition = 0;
+        uint32_t firstUv = 0;
+        uint32_t firstNormal = 0;
+
+        // Three per triangle with absolute indices, filled by the second pass
+        std::vector<Corner> corners;
+        uint32_t firstVertex = 0;
+        std::optional<ObjLoader::Error> error;
+    };
+
+    std::string_view nextLine(std::string_view& text)
+    {
+        size_t lineEnd = text.find('\n');
+        std::string_view line = text.substr(0, lineEnd);
+        text.remove_prefix(lineEnd == std::string_view::npos ? text.size() : lineEnd + 1);
+        if(!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        return line;
+    }
+
+    void skipSpaces(std::string_view& text)
+    {
+        while(!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+    }
+
+    std::string_view takeKeyword(std::string_view& line)
+    {
+        skipSpaces(line);
+        std::string_view keyword = line.substr(0, line.find_first_of(" \t"));
+        line.remove_prefix(keyword.size());
+        return keyword;
+    }
+
+    std::optional<float> parseFloat(std::string_view& text)
+    {
+        skipSpaces(text);
+        float value;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if(error != std::errc())
+            return std::nullopt;
+        text.remove_prefix(end - text.data());
+        return value;
+    }
+
+    // 1-based and negative (relative to the end) indices to 0-based, Invalid if out of range
+    uint32_t parseIndex(std::string_view& text, size_t count)
+    {
+        int64_t value;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if(error != std::errc())
+            return Invalid;
+        text.remove_prefix(end - text.data());
+
+        int64_t index = value < 0 ? (int64_t)count + value : value - 1;
+        return index >= 0 && index < (int64_t)count ? (uint32_t)index : Invalid;
+    }
+
+    // Splits `text` into pieces of about ChunkSize that end at line ends
+    std::vector<Chunk> split(std::string_view text)
+    {
+        std::vector<Chunk> chunks;
+        while(!text.empty())
+        {
+            size_t end = text.size() > ChunkSize ? text.find('\n', ChunkSize) : text.npos;
+            end = end == text.npos ? text.size() : end + 1;
+            chunks.emplace_back().text = text.substr(0, end);
+            text.remove_prefix(end);
+        }
+        return chunks;
+    }
+
+    void count(Chunk& chunk)
+    {
+        for(std::string_view text = chunk.text; !text.empty();)
+        {
+            std::string_view line = nextLine(text);
+            std::string_view keyword = takeKeyword(line);
+            chunk.lineCount++;
+            if(keyword == "v")
+                chunk.positionCount++;
+            else if(keyword == "vt")
+                chunk.uvCount++;
+            else if(keyword == "vn")
+                chunk.normalCount++;
+        }
+    }
+
+    void parseChunk(
+        Chunk& chunk,
+        std::vector<glm::vec3>& positions,
+        std::vector<glm::vec2>& uvs,
+        std::vector<glm::vec3>& normals)
+    {
+        ObjLoader::Error error = {};
+        uint32_t lineNumber = chunk.firstLine;
+        // Elements defined so far, which are all a face can refer to
+        uint32_t positionCount = chunk.firstPosition;
+        uint32_t uvCount = chunk.firstUv;
+        uint32_t normalCount = chunk.firstNormal;
+        std::vector<Corner> face;
+
+        for(std::string_view text = chunk.text; !text.empty();)
+        {
+            std::string_view line = nextLine(text);
+            std::string_view keyword = takeKeyword(line);
+            lineNumber++;
+
+            if(keyword == "v" || keyword == "vn")
+            {
+                auto x = parseFloat(line);
+                auto y = parseFloat(line);
+                auto z = parseFloat(line);
+                if(!x || !y || !z)
+                {
+                    error.type = ObjLoader::ErrorType::InvalidNumber;
+                    error.InvalidNumber.line = lineNumber;
+                    chunk.error = error;
+                    return;
+                }
+                if(keyword == "v")
+                    positions[positionCount++] = {x.value(), y.value(), z.value()};
+                else
+                    normals[normalCount++] = {x.value(), y.value(), z.value()};
+            }
+            else if(keyword == "vt")
+            {
+                auto u = parseFloat(line);
+                auto v = parseFloat(line);
+                if(!u || !v)
+                {
+                    error.type = ObjLoader::ErrorType::InvalidNumber;
+                    error.InvalidNumber.line = lineNumber;
+                    chunk.error = error;
+                    return;
+                }
+                uvs[uvCount++] = {u.value(), 1.0f - v.value()};
+            }
+            else if(keyword == "f")
+            {
+                face.clear();
+                bool valid = true;
+                for(skipSpaces(line); valid && !line.empty(); skipSpaces(line))
+                {
+                    // v, v/vt, v//vn or v/vt/vn
+                    Corner corner = {parseIndex(line, positionCount), Missing, Missing};
+                    if(!line.empty() && line.front() == '/')
+                    {
+                        line.remove_prefix(1);
+                        if(!line.empty() && line.front() != '/')
+                            corner.uv = parseIndex(line, uvCount);
+                        if(!line.empty() && line.front() == '/')
+                        {
+                            line.remove_prefix(1);
+                            corner.normal = parseIndex(line, normalCount);
+                        }
+                    }
+                    valid = corner.position != Invalid && corner.uv != Invalid
+                            && corner.normal != Invalid;
+                    face.push_back(corner);
+                }
+
+                if(!valid || face.size() < 3)
+                {
+                    error.type = ObjLoader::ErrorType::InvalidIndex;
+                    error.InvalidIndex.line = lineNumber;
+                    chunk.error = error;
+                    return;
+                }
+                for(size_t i = 1; i + 1 < face.size(); ++i)
+                {
+                    chunk.corners.push_back(face[0]);
+                    chunk.corners.push_back(face[i]);
+                    chunk.corners.push_back(face[i + 1]);
+                }
+            }
+        }
+    }
+
+    void buildVertices(
+        const Chunk& chunk,
+        const std::vector<glm::vec3>& positions,
+        const std::vector<glm::vec2>& uvs,
+        const std::vector<glm::vec3>& normals,
+        MeshData& mesh)
+    {
+        uint32_t vertex = chunk.firstVertex;
+        for(size_t i = 0; i < chunk.corners.size(); i += 3)
+        {
+            const Corner* triangle = &chunk.corners[i];
+            glm::vec3 faceNormal = glm::cross(
+                positions[triangle[1].position] - positions[triangle[0].position],
+                positions[triangle[2].position] - positions[triangle[0].position]);
+            float length = glm::length(faceNormal);
+            faceNormal = length > 0.0f ? faceNormal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+            for(uint32_t j = 0; j < 3; ++j, ++vertex)
+            {
+                const Corner& corner = triangle[j];
+                mesh.indices[vertex] = vertex;
+                mesh.vertices[vertex] = packMeshVertex(
+                    positions[corner.position],
+                    corner.normal != Missing ? normals[corner.normal] : faceNormal,
+                    corner.uv != Missing ? uvs[corner.uv] : glm::vec2(0.0f));
+            }
+        }
+    }
+}
+
+namespace ObjLoader
+{
+    std::variant<MeshData, Error> parse(std::string_view text, JobSystem& jobSystem)
+    {
+        // Faces can only refer to elements defined before them, so once every chunk knows how
+        // many come before it they can all be parsed independently
+        std::vector<Chunk> chunks = split(text);
+        jobSystem.parallelFor((uint32_t)chunks.size(), 1, [&](uint32_t begin, uint32_t end) {
+            for(uint32_t i = begin; i < end; ++i)
+                count(chunks[i]);
+        });
+
+        Chunk totals;
+        for(Chunk& chunk : chunks)
+        {
+            chunk.firstLine = totals.lineCount;
+            chunk.firstPosition = totals.positionCount;
+            chunk.firstUv = totals.uvCount;
+            chunk.firstNormal = totals.normalCount;
+            totals.lineCount += chunk.lineCount;
+            totals.positionCount += chunk.positionCount;
+            totals.uvCount += chunk.uvCount;
+            totals.normalCount += chunk.normalCount;
+        }
+
+        std::vector<glm::vec3> positions(totals.positionCount);
+        std::vector<glm::vec2> uvs(totals.uvCount);
+        std::vector<glm::vec3> normals(totals.normalCount);
+        jobSystem.parallelFor((uint32_t)chunks.size(), 1, [&](uint32_t begin, uint32_t end) {
+            for(uint32_t i = begin; i < end; ++i)
+                parseChunk(chunks[i], positions, uvs, normals);
+        });
+
+        uint32_t vertexCount = 0;
+        for(Chunk& chunk : chunks)
+        {
+            // The first error in the file, like a sequential parse would report
+            if(chunk.error.has_value())
+                return chunk.error.value();
+            chunk.firstVertex = vertexCount;
+            vertexCount += (uint32_t)chunk.corners.size();
+        }
+
+        MeshData mesh;
+        mesh.vertices.resize(vertexCount);
+        mesh.indices.resize(vertexCount);
+        jobSystem.parallelFor((uint32_t)chunks.size(), 1, [&](uint32_t begin, uint32_t end) {
+            for(uint32_t i = begin; i < end; ++i)
+                buildVertices(chunks[i], positions, uvs, normals, mesh);
+        });
+        return mesh;
+    }
+}
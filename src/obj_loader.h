@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <variant>
+
+#include "job_system.h"
+#include "mesh_data.h"
+
+/**
+ * @brief Reads the geometry of Wavefront OBJ files: positions, texture coordinates, normals and
+ * faces, which are triangulated as fans. Materials, groups and everything else are ignored.
+ *
+ * Every face corner becomes its own vertex, so run MeshOptimizer::deduplicateVertices on the
+ * result. Faces without normals get their face normal and v is flipped to Vulkan's top-left
+ * origin.
+ *
+ * The text is split into chunks of whole lines that are parsed on the JobSystem: one pass counts
+ * the elements in every chunk, which gives each chunk the indices its elements start at, then a
+ * second pass parses all chunks at once and a third writes the vertices.
+ */
+namespace ObjLoader
+{
+    enum class ErrorType
+    {
+        InvalidNumber,
+        // A face refers to a position, uv or normal that doesn't exist
+        InvalidIndex,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                uint32_t line;
+            } InvalidNumber;
+            struct
+            {
+                uint32_t line;
+            } InvalidIndex;
+        };
+    };
+
+    std::variant<MeshData, Error> parse(std::string_view text, JobSystem& jobSystem);
+}
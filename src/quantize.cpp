@@ -0,0 +1,181 @@
+#include "quantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__F16C__) || defined(__SSE2__) || defined(_M_X64)
+    #include <immintrin.h>
+#endif
+
+namespace Quantize
+{
+    uint16_t toHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t exponent = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+
+        // NaN and infinity
+        if(exponent == 0xff)
+            return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+        int32_t halfExponent = (int32_t)exponent - 127 + 15;
+        if(halfExponent >= 0x1f)
+            return (uint16_t)(sign | 0x7c00);
+
+        if(halfExponent <= 0)
+        {
+            // Denormal or zero
+            if(halfExponent < -10)
+                return (uint16_t)sign;
+
+            mantissa |= 0x800000;
+            uint32_t shift = (uint32_t)(14 - halfExponent);
+            uint32_t half = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if(remainder > halfway || (remainder == halfway && (half & 1)))
+                half++;
+            return (uint16_t)(sign | half);
+        }
+
+        uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+        uint32_t remainder = mantissa & 0x1fff;
+        // Rounding can carry into the exponent, which correctly rounds up to the next power of two
+        // or infinity
+        if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+            half++;
+        return (uint16_t)(sign | half);
+    }
+
+    float fromHalf(uint16_t value)
+    {
+        uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1f;
+        uint32_t mantissa = value & 0x3ff;
+
+        uint32_t bits;
+        if(exponent == 0x1f)
+        {
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        }
+        else if(exponent == 0)
+        {
+            if(mantissa == 0)
+            {
+                bits = sign;
+            }
+            else
+            {
+                // Denormal, normalize it
+                exponent = 127 - 15 + 1;
+                while(!(mantissa & 0x400))
+                {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+            }
+        }
+        else
+        {
+            bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        }
+
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    uint8_t toUnorm8(float value)
+    {
+        return (uint8_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+    }
+
+    int8_t toSnorm8(float value)
+    {
+        return (int8_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f);
+    }
+
+    uint16_t toUnorm16(float value)
+    {
+        return (uint16_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f);
+    }
+
+    int16_t toSnorm16(float value)
+    {
+        return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    uint32_t toSnorm10x3(glm::vec3 value, float w)
+    {
+        auto snorm10 = [](float component) {
+            int32_t quantized = (int32_t)std::lround(std::clamp(component, -1.0f, 1.0f) * 511.0f);
+            return (uint32_t)quantized & 0x3ff;
+        };
+        uint32_t alpha = (uint32_t)std::lround(std::clamp(w, -1.0f, 1.0f)) & 0x3;
+        return snorm10(value.x) | (snorm10(value.y) << 10) | (snorm10(value.z) << 20)
+               | (alpha << 30);
+    }
+
+    uint32_t toUnorm10x3(glm::vec3 value, float w)
+    {
+        auto unorm10 = [](float component) {
+            return (uint32_t)std::lround(std::clamp(component, 0.0f, 1.0f) * 1023.0f);
+        };
+        uint32_t alpha = (uint32_t)std::lround(std::clamp(w, 0.0f, 1.0f) * 3.0f);
+        return unorm10(value.x) | (unorm10(value.y) << 10) | (unorm10(value.z) << 20)
+               | (alpha << 30);
+    }
+
+    void toHalf(const float* source, uint16_t* destination, size_t count)
+    {
+        size_t i = 0;
+#if defined(__F16C__)
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256 values = _mm256_loadu_ps(source + i);
+            __m128i halves = _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128((__m128i*)(destination + i), halves);
+        }
+#endif
+        for(; i < count; ++i)
+            destination[i] = toHalf(source[i]);
+    }
+
+    void toUnorm8(const float* source, uint8_t* destination, size_t count)
+    {
+        size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        for(; i + 16 <= count; i += 16)
+        {
+            __m128i quantized[4];
+            for(int part = 0; part < 4; ++part)
+            {
+                __m128 values = _mm_loadu_ps(source + i + part * 4);
+                values = _mm_mul_ps(_mm_min_ps(_mm_max_ps(values, zero), one), scale);
+                // Rounds half away from zero like the scalar lround, adding 0.5 before truncating
+                // would round 0.49999997 up
+                __m128i truncated = _mm_cvttps_epi32(values);
+                __m128 fraction = _mm_sub_ps(values, _mm_cvtepi32_ps(truncated));
+                // All ones, i.e. -1, where the fraction rounds up
+                __m128i roundUp = _mm_castps_si128(_mm_cmpge_ps(fraction, half));
+                quantized[part] = _mm_sub_epi32(truncated, roundUp);
+            }
+            __m128i low = _mm_packs_epi32(quantized[0], quantized[1]);
+            __m128i high = _mm_packs_epi32(quantized[2], quantized[3]);
+            _mm_storeu_si128((__m128i*)(destination + i), _mm_packus_epi16(low, high));
+        }
+#endif
+        for(; i < count; ++i)
+            destination[i] = toUnorm8(source[i]);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/**
+ * @brief CPU-side conversion of float vertex data into the packed formats PipelineBuilder
+ * understands, e.g. when converting meshes on load.
+ *
+ * Out of range inputs are clamped. The array versions use F16C/SSE2 when the compiler targets them
+ * (see ENABLE_NATIVE_ARCH in CMakeLists.txt) and fall back to the scalar ones otherwise.
+ */
+namespace Quantize
+{
+    // vk::Format::eR16Sfloat, round to nearest even
+    uint16_t toHalf(float value);
+    float fromHalf(uint16_t value);
+
+    // vk::Format::eR8Unorm/eR8Snorm/eR16Unorm/eR16Snorm, round to nearest
+    uint8_t toUnorm8(float value);
+    int8_t toSnorm8(float value);
+    uint16_t toUnorm16(float value);
+    int16_t toSnorm16(float value);
+
+    // vk::Format::eA2B10G10R10SnormPack32, meant for normals and tangents. `w` is -1, 0 or 1, e.g.
+    // the tangent handedness
+    uint32_t toSnorm10x3(glm::vec3 value, float w = 0.0f);
+    // vk::Format::eA2B10G10R10UnormPack32
+    uint32_t toUnorm10x3(glm::vec3 value, float w = 0.0f);
+
+    void toHalf(const float* source, uint16_t* destination, size_t count);
+    void toUnorm8(const float* source, uint8_t* destination, size_t count);
+}
@@ -4,4 +4,7 @@ namespace ShaderPaths
 {
     std::filesystem::path Simple2D = "shaders/simple2d.vert.spv";
     std::filesystem::path ColorPassthrough = "shaders/color_passthrough.frag.spv";
+    std::filesystem::path Sprite = "shaders/sprite.vert.spv";
+    std::filesystem::path SpriteFrag = "shaders/sprite.frag.spv";
+    std::filesystem::path MipDownsample = "shaders/mip_downsample.comp.spv";
 }
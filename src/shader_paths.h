@@ -6,4 +6,7 @@ namespace ShaderPaths
 {
     extern std::filesystem::path Simple2D;
     extern std::filesystem::path ColorPassthrough;
+    extern std::filesystem::path Sprite;
+    extern std::filesystem::path SpriteFrag;
+    extern std::filesystem::path MipDownsample;
 }
@@ -53,6 +53,7 @@ std::optional<ShaderRegistry::Error> ShaderRegistry::loadVertexShader(
     }
     else
     {
+        std::lock_guard lock(mutex);
         vertexShaders.insert(std::make_pair(
             path,
             Shader{
@@ -73,6 +74,7 @@ std::optional<ShaderRegistry::Error> ShaderRegistry::loadFragmentShader(
     }
     else
     {
+        std::lock_guard lock(mutex);
         fragmentShaders.insert(std::make_pair(
             path,
             Shader{
@@ -81,8 +83,30 @@ std::optional<ShaderRegistry::Error> ShaderRegistry::loadFragmentShader(
         return std::nullopt;
     }
 }
+
+std::optional<ShaderRegistry::Error> ShaderRegistry::loadComputeShader(
+    const vk::UniqueDevice& device,
+    const std::filesystem::path& path)
+{
+    auto var = createShader(device, path);
+    if(std::holds_alternative<Error>(var))
+    {
+        return std::get<Error>(var);
+    }
+    else
+    {
+        std::lock_guard lock(mutex);
+        computeShaders.insert(std::make_pair(
+            path,
+            Shader{
+                .shaderModule = std::get<vk::UniqueShaderModule>(std::move(var)),
+            }));
+        return std::nullopt;
+    }
+}
 const Shader* ShaderRegistry::getVertexShader(const std::filesystem::path& path) const
 {
+    std::lock_guard lock(mutex);
     auto var = vertexShaders.find(path);
     if(var != vertexShaders.end())
     {
@@ -95,6 +119,7 @@ const Shader* ShaderRegistry::getVertexShader(const std::filesystem::path& path)
 }
 const Shader* ShaderRegistry::getFragmentShader(const std::filesystem::path& path) const
 {
+    std::lock_guard lock(mutex);
     auto var = fragmentShaders.find(path);
     if(var != fragmentShaders.end())
     {
@@ -105,3 +130,16 @@ const Shader* ShaderRegistry::getFragmentShader(const std::filesystem::path& pat
         return nullptr;
     }
 }
+const Shader* ShaderRegistry::getComputeShader(const std::filesystem::path& path) const
+{
+    std::lock_guard lock(mutex);
+    auto var = computeShaders.find(path);
+    if(var != computeShaders.end())
+    {
+        return &var->second;
+    }
+    else
+    {
+        return nullptr;
+    }
+}
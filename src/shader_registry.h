@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <map>
+#include <mutex>
 #include <optional>
 
 #include <vulkan/vulkan_raii.hpp>
@@ -16,6 +17,9 @@ class ShaderRegistry
     // Using const char* might not be optimal but it is fine for now
     std::map<std::filesystem::path, Shader> vertexShaders;
     std::map<std::filesystem::path, Shader> fragmentShaders;
+    std::map<std::filesystem::path, Shader> computeShaders;
+    // Shaders can be loaded from several jobs at once
+    mutable std::mutex mutex;
 
   public:
     enum class ErrorType
@@ -44,7 +48,11 @@ class ShaderRegistry
     std::optional<Error> loadFragmentShader(
         const vk::UniqueDevice& device,
         const std::filesystem::path& path);
+    std::optional<Error> loadComputeShader(
+        const vk::UniqueDevice& device,
+        const std::filesystem::path& path);
 
     const Shader* getVertexShader(const std::filesystem::path& path) const;
     const Shader* getFragmentShader(const std::filesystem::path& path) const;
+    const Shader* getComputeShader(const std::filesystem::path& path) const;
 };
\ No newline at end of file
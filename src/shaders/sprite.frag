@@ -0,0 +1,20 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 uv;
+layout(location = 1) in vec4 color;
+
+// The bindless textures, see BindlessDescriptors
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform PushConstants
+{
+    layout(offset = 8) uint textureIndex;
+} pushConstants;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = texture(textures[pushConstants.textureIndex], uv) * color;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#version 450
+
+// Per instance, see SpriteBatch::Instance
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 size;
+layout(location = 2) in float rotation;
+layout(location = 3) in vec4 uvRect;
+layout(location = 4) in vec4 color;
+
+layout(push_constant) uniform PushConstants
+{
+    vec2 inverseScreenSize;
+    // Only used by sprite.frag
+    uint textureIndex;
+} pushConstants;
+
+layout(location = 0) out vec2 outUv;
+layout(location = 1) out vec4 outColor;
+
+void main()
+{
+    // Drawn as a 4 vertex triangle strip without a vertex buffer
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+
+    float s = sin(rotation);
+    float c = cos(rotation);
+    vec2 local = (corner - 0.5) * size;
+    vec2 pixel = position + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    outUv = mix(uvRect.xy, uvRect.zw, corner);
+    outColor = color;
+    gl_Position = vec4(pixel * pushConstants.inverseScreenSize * 2.0 - 1.0, 0.0, 1.0);
+}
\ No newline at end of file
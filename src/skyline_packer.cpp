@@ -0,0 +1,187 @@
+#include "skyline_packer.h"
+
+#include <algorithm>
+#include <cassert>
+
+SkylinePacker::SkylinePacker(uint32_t width, uint32_t height)
+    : width(width)
+    , height(height)
+    , usedArea(0)
+{
+    reset();
+}
+
+std::optional<PackedRect> SkylinePacker::insert(uint32_t width, uint32_t height)
+{
+    if(width == 0 || height == 0 || width > this->width || height > this->height)
+        return std::nullopt;
+
+    auto rect = insertIntoFreeRect(width, height);
+    if(!rect.has_value())
+        rect = insertIntoSkyline(width, height);
+
+    if(rect.has_value())
+        usedArea += (uint64_t)width * height;
+    return rect;
+}
+
+void SkylinePacker::release(const PackedRect& rect)
+{
+    assert(usedArea >= (uint64_t)rect.width * rect.height);
+    usedArea -= (uint64_t)rect.width * rect.height;
+    freeRects.push_back(rect);
+}
+
+void SkylinePacker::reset()
+{
+    skyline.assign(1, Segment{.x = 0, .y = 0, .width = width});
+    freeRects.clear();
+    usedArea = 0;
+}
+
+uint32_t SkylinePacker::getWidth() const
+{
+    return width;
+}
+
+uint32_t SkylinePacker::getHeight() const
+{
+    return height;
+}
+
+float SkylinePacker::getOccupancy() const
+{
+    return (float)((double)usedArea / ((double)width * height));
+}
+
+std::optional<PackedRect> SkylinePacker::insertIntoFreeRect(uint32_t width, uint32_t height)
+{
+    // Best area fit
+    size_t best = freeRects.size();
+    uint64_t bestArea = UINT64_MAX;
+    for(size_t i = 0; i < freeRects.size(); ++i)
+    {
+        const PackedRect& free = freeRects[i];
+        uint64_t area = (uint64_t)free.width * free.height;
+        if(free.width >= width && free.height >= height && area < bestArea)
+        {
+            best = i;
+            bestArea = area;
+        }
+    }
+    if(best == freeRects.size())
+        return std::nullopt;
+
+    PackedRect free = freeRects[best];
+    freeRects[best] = freeRects.back();
+    freeRects.pop_back();
+
+    // Split along the shorter leftover side, which keeps the bigger of the two remainders as
+    // square as possible
+    uint32_t leftoverWidth = free.width - width;
+    uint32_t leftoverHeight = free.height - height;
+    PackedRect right = {.x = free.x + width, .y = free.y, .width = leftoverWidth, .height = 0};
+    PackedRect below = {.x = free.x, .y = free.y + height, .width = 0, .height = leftoverHeight};
+    if(leftoverWidth < leftoverHeight)
+    {
+        right.height = height;
+        below.width = free.width;
+    }
+    else
+    {
+        right.height = free.height;
+        below.width = width;
+    }
+    if(right.width > 0 && right.height > 0)
+        freeRects.push_back(right);
+    if(below.width > 0 && below.height > 0)
+        freeRects.push_back(below);
+
+    return PackedRect{.x = free.x, .y = free.y, .width = width, .height = height};
+}
+
+std::optional<PackedRect> SkylinePacker::insertIntoSkyline(uint32_t width, uint32_t height)
+{
+    size_t bestIndex = skyline.size();
+    uint32_t bestY = UINT32_MAX;
+    uint32_t bestWidth = UINT32_MAX;
+    for(size_t i = 0; i < skyline.size(); ++i)
+    {
+        auto y = fitSegment(i, width, height);
+        if(!y.has_value())
+            continue;
+
+        if(y.value() < bestY || (y.value() == bestY && skyline[i].width < bestWidth))
+        {
+            bestIndex = i;
+            bestY = y.value();
+            bestWidth = skyline[i].width;
+        }
+    }
+    if(bestIndex == skyline.size())
+        return std::nullopt;
+
+    PackedRect rect = {.x = skyline[bestIndex].x, .y = bestY, .width = width, .height = height};
+
+    // Replace everything under the new rectangle with one segment on top of it
+    skyline.insert(
+        skyline.begin() + (ptrdiff_t)bestIndex,
+        Segment{.x = rect.x, .y = rect.y + height, .width = width});
+    size_t next = bestIndex + 1;
+    while(next < skyline.size())
+    {
+        Segment& segment = skyline[next];
+        uint32_t rectEnd = rect.x + width;
+        if(segment.x >= rectEnd)
+            break;
+
+        uint32_t segmentEnd = segment.x + segment.width;
+        if(segmentEnd <= rectEnd)
+        {
+            skyline.erase(skyline.begin() + (ptrdiff_t)next);
+            continue;
+        }
+        segment.width = segmentEnd - rectEnd;
+        segment.x = rectEnd;
+        break;
+    }
+
+    // Neighbours at the same height become one segment
+    for(size_t i = 0; i + 1 < skyline.size();)
+    {
+        if(skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + (ptrdiff_t)i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return rect;
+}
+
+std::optional<uint32_t> SkylinePacker::fitSegment(
+    size_t index,
+    uint32_t width,
+    uint32_t height) const
+{
+    uint32_t x = skyline[index].x;
+    if(x + width > this->width)
+        return std::nullopt;
+
+    // The rectangle rests on the highest segment it spans
+    uint32_t y = 0;
+    uint32_t remaining = width;
+    for(size_t i = index; remaining > 0; ++i)
+    {
+        assert(i < skyline.size());
+        y = std::max(y, skyline[i].y);
+        if(y + height > this->height)
+            return std::nullopt;
+        remaining -= std::min(remaining, skyline[i].width);
+    }
+    return y;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+struct PackedRect
+{
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+/**
+ * @brief Incremental rectangle packer for atlas pages.
+ *
+ * New rectangles go on top of a skyline (the top edge of everything placed so far) at the lowest
+ * position they fit, ties going to the narrowest segment. Released rectangles can't be given back
+ * to the skyline, so they are kept in a free list that is searched first and split
+ * guillotine-style when a smaller rectangle is placed in one. Free rectangles are never merged;
+ * once everything on a page has been released it should be `reset` instead.
+ */
+class SkylinePacker
+{
+  public:
+    SkylinePacker(uint32_t width, uint32_t height);
+
+    std::optional<PackedRect> insert(uint32_t width, uint32_t height);
+    void release(const PackedRect& rect);
+    void reset();
+
+    uint32_t getWidth() const;
+    uint32_t getHeight() const;
+    // Fraction of the area that is currently in use
+    float getOccupancy() const;
+
+  private:
+    struct Segment
+    {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+    };
+
+    uint32_t width;
+    uint32_t height;
+    uint64_t usedArea;
+
+    // Sorted by x and covering the whole width
+    std::vector<Segment> skyline;
+    std::vector<PackedRect> freeRects;
+
+    std::optional<PackedRect> insertIntoFreeRect(uint32_t width, uint32_t height);
+    std::optional<PackedRect> insertIntoSkyline(uint32_t width, uint32_t height);
+    // Lowest y a rectangle starting at segment `index` can be placed at, if it fits
+    std::optional<uint32_t> fitSegment(size_t index, uint32_t width, uint32_t height) const;
+};
@@ -0,0 +1,254 @@
+#include "sprite_batch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
+
+#include "quantize.h"
+#include "vulkan/commands.h"
+
+namespace
+{
+    constexpr uint32_t TextureBits = 20;
+    constexpr uint32_t PipelineShift = TextureBits;
+    constexpr uint32_t LayerShift = 24;
+    // Sprites whose keys only differ in the layer can share a draw
+    constexpr uint32_t DrawKeyMask = (1u << LayerShift) - 1;
+
+    // Big enough that a job is worth scheduling, small enough to spread a few thousand sprites
+    constexpr uint32_t JobBatchSize = 4096;
+
+    uint32_t sortKey(const Sprite& sprite)
+    {
+        return ((uint32_t)sprite.layer << LayerShift) | ((uint32_t)sprite.pipeline << PipelineShift)
+               | (sprite.texture & (SpriteBatch::MaxTextures - 1));
+    }
+
+    SpriteBatch::Instance pack(const Sprite& sprite)
+    {
+        return SpriteBatch::Instance{
+            .position = {sprite.position.x, sprite.position.y},
+            .size = {Quantize::toHalf(sprite.size.x), Quantize::toHalf(sprite.size.y)},
+            .rotation = sprite.rotation,
+            .uvRect =
+                {
+                    Quantize::toUnorm16(sprite.uvRect.x),
+                    Quantize::toUnorm16(sprite.uvRect.y),
+                    Quantize::toUnorm16(sprite.uvRect.z),
+                    Quantize::toUnorm16(sprite.uvRect.w),
+                },
+            .color = sprite.color,
+        };
+    }
+}
+
+SpriteBatch::SpriteBatch(JobSystem& jobSystem)
+    : jobSystem(&jobSystem)
+{
+}
+
+uint8_t SpriteBatch::addPipeline(PipelineHandle pipeline)
+{
+    assert(pipelines.size() < MaxPipelines);
+    pipelines.push_back(pipeline);
+    return (uint8_t)(pipelines.size() - 1);
+}
+
+void SpriteBatch::begin()
+{
+    packed.clear();
+    keys.clear();
+    draws.clear();
+    instances.reset();
+}
+
+void SpriteBatch::submit(const Sprite& sprite)
+{
+    assert(sprite.pipeline < pipelines.size());
+    packed.push_back(pack(sprite));
+    keys.push_back(sortKey(sprite));
+}
+
+void SpriteBatch::submit(std::span<const Sprite> sprites)
+{
+    size_t first = packed.size();
+    packed.resize(first + sprites.size());
+    keys.resize(first + sprites.size());
+
+    jobSystem->parallelFor(
+        (uint32_t)sprites.size(),
+        JobBatchSize,
+        [&](uint32_t begin, uint32_t end) {
+            for(uint32_t i = begin; i < end; ++i)
+            {
+                assert(sprites[i].pipeline < pipelines.size());
+                packed[first + i] = pack(sprites[i]);
+                keys[first + i] = sortKey(sprites[i]);
+            }
+        });
+}
+
+bool SpriteBatch::prepare(TransientBuffer& transientBuffer)
+{
+    draws.clear();
+    instances.reset();
+
+    uint32_t count = getSpriteCount();
+    if(count == 0)
+        return true;
+
+    instances = transientBuffer.allocate(count * sizeof(Instance), alignof(Instance));
+    if(!instances.has_value())
+        return false;
+
+    // The transient buffer is usually write-combined memory, so it's only ever written
+    // sequentially
+    auto* out = (Instance*)instances->data;
+    if(!sort())
+    {
+        std::memcpy(out, packed.data(), count * sizeof(Instance));
+    }
+    else
+    {
+        jobSystem->parallelFor(count, JobBatchSize, [&](uint32_t begin, uint32_t end) {
+            for(uint32_t i = begin; i < end; ++i)
+                out[i] = packed[order[i]];
+        });
+    }
+
+    // `keys` is sorted now, so every run of equal pipeline and texture is one draw
+    for(uint32_t first = 0; first < count;)
+    {
+        uint32_t drawKey = keys[first] & DrawKeyMask;
+        uint32_t end = first + 1;
+        while(end < count && (keys[end] & DrawKeyMask) == drawKey)
+            ++end;
+
+        draws.push_back(Draw{
+            .pipeline = (uint8_t)(drawKey >> PipelineShift),
+            .texture = drawKey & (MaxTextures - 1),
+            .firstInstance = first,
+            .instanceCount = end - first,
+        });
+        first = end;
+    }
+    return true;
+}
+
+void SpriteBatch::record(
+    vk::CommandBuffer commandBuffer,
+    const GpuResources& resources,
+    vk::Extent2D screenSize) const
+{
+    if(draws.empty())
+        return;
+
+    Commands::VertexStream stream = {.buffer = instances->buffer, .offset = instances->offset};
+    Commands::bindVertexStreams(commandBuffer, {&stream, 1});
+
+    PushConstants pushConstants = {
+        .inverseScreenSize = {1.0f / (float)screenSize.width, 1.0f / (float)screenSize.height},
+        .textureIndex = 0,
+    };
+
+    std::optional<uint8_t> boundPipeline;
+    std::optional<uint32_t> boundTexture;
+    for(const Draw& draw : draws)
+    {
+        if(draw.pipeline != boundPipeline)
+        {
+            PipelineHandle pipeline = pipelines[draw.pipeline];
+            commandBuffer.bindPipeline(
+                vk::PipelineBindPoint::eGraphics,
+                resources.getPipeline(pipeline));
+            // The layouts don't have to be compatible, in which case push constants and
+            // descriptor sets are lost with the switch
+            pushConstants.textureIndex = draw.texture;
+            Commands::pushConstants(
+                commandBuffer,
+                resources.getPipelineLayout(pipeline),
+                PushConstantStages,
+                pushConstants);
+            boundPipeline = draw.pipeline;
+            boundTexture = draw.texture;
+        }
+        else if(draw.texture != boundTexture)
+        {
+            // Only the index changes, no descriptor set is bound per texture
+            Commands::pushConstants(
+                commandBuffer,
+                resources.getPipelineLayout(pipelines[draw.pipeline]),
+                PushConstantStages,
+                draw.texture,
+                (uint32_t)offsetof(PushConstants, textureIndex));
+            boundTexture = draw.texture;
+        }
+        commandBuffer.draw(4, draw.instanceCount, 0, draw.firstInstance);
+    }
+}
+
+uint32_t SpriteBatch::getSpriteCount() const
+{
+    return (uint32_t)packed.size();
+}
+
+uint32_t SpriteBatch::getDrawCount() const
+{
+    return (uint32_t)draws.size();
+}
+
+bool SpriteBatch::sort()
+{
+    // Common when sprites are submitted grouped by texture already
+    if(std::is_sorted(keys.begin(), keys.end()))
+        return false;
+
+    // LSD radix sort of (key, sprite index) pairs, 8 bits per pass. It's stable, which keeps the
+    // submission order of sprites with equal keys
+    uint32_t count = getSpriteCount();
+    order.resize(count);
+    std::iota(order.begin(), order.end(), 0u);
+    keysScratch.resize(count);
+    orderScratch.resize(count);
+
+    // All histograms are built in a single pass over the keys
+    uint32_t histograms[4][256] = {};
+    for(uint32_t key : keys)
+    {
+        ++histograms[0][key & 0xFF];
+        ++histograms[1][(key >> 8) & 0xFF];
+        ++histograms[2][(key >> 16) & 0xFF];
+        ++histograms[3][key >> 24];
+    }
+
+    for(uint32_t pass = 0; pass < 4; ++pass)
+    {
+        uint32_t shift = pass * 8;
+        uint32_t* histogram = histograms[pass];
+        // Every key has the same byte here, e.g. everything is in layer 0, so the pass would
+        // only copy
+        if(histogram[(keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for(uint32_t bucket = 0; bucket < 256; ++bucket)
+        {
+            uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t key = keys[i];
+            uint32_t destination = histogram[(key >> shift) & 0xFF]++;
+            keysScratch[destination] = key;
+            orderScratch[destination] = order[i];
+        }
+        keys.swap(keysScratch);
+        order.swap(orderScratch);
+    }
+    return true;
+}
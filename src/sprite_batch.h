@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include "job_system.h"
+#include "vulkan/gpu_resources.h"
+#include "vulkan/transient_buffer.h"
+#include "vulkan/vertex_layout.h"
+
+struct Sprite
+{
+    // Center, in pixels from the top left corner
+    glm::vec2 position;
+    // In pixels, negative sizes mirror the sprite
+    glm::vec2 size;
+    // Radians, clockwise on screen
+    float rotation;
+    // u0, v0, u1, v1
+    glm::vec4 uvRect;
+    // RGBA8 with R in the lowest byte
+    uint32_t color;
+    // Index into the bindless textures, see BindlessDescriptors. Only the low 20 bits are used
+    uint32_t texture;
+    // Index returned by SpriteBatch::addPipeline
+    uint8_t pipeline;
+    // Lower layers are drawn first
+    uint8_t layer;
+};
+
+/**
+ * @brief Turns any number of sprites into a handful of instanced draws.
+ *
+ * Sprites are packed into 28 byte instances as they are submitted and sorted by layer, then
+ * pipeline, then texture with a stable radix sort, so sprites within the same layer that share a
+ * pipeline and texture keep their submission order while everything else in the layer is free to
+ * be reordered. The sorted instances are copied into the frame's TransientBuffer and every run of
+ * sprites with the same pipeline and texture becomes one draw of a 4 vertex triangle strip, with
+ * the corners generated from gl_VertexIndex in sprite.vert.
+ *
+ * Usage per frame: `begin`, `submit` from one thread, `prepare` once everything is submitted and
+ * `record` inside the render pass.
+ */
+class SpriteBatch
+{
+  public:
+    struct Instance
+    {
+        float position[2];
+        // Half floats
+        uint16_t size[2];
+        float rotation;
+        // Unorm16, enough for exact texel coordinates in textures up to 64k
+        uint16_t uvRect[4];
+        uint32_t color;
+    };
+
+    static constexpr auto InstanceLayout = makeVertexLayout<Instance>(
+        {
+            VERTEX_ATTRIBUTE(Instance, position, vk::Format::eR32G32Sfloat),
+            VERTEX_ATTRIBUTE(Instance, size, vk::Format::eR16G16Sfloat),
+            VERTEX_ATTRIBUTE(Instance, rotation, vk::Format::eR32Sfloat),
+            VERTEX_ATTRIBUTE(Instance, uvRect, vk::Format::eR16G16B16A16Unorm),
+            VERTEX_ATTRIBUTE(Instance, color, vk::Format::eR8G8B8A8Unorm),
+        },
+        vk::VertexInputRate::eInstance);
+
+    // Pipelines are expected to use these in PushConstantStages
+    struct PushConstants
+    {
+        glm::vec2 inverseScreenSize;
+        // Pushed again before the draws of each texture
+        uint32_t textureIndex;
+    };
+
+    static constexpr vk::ShaderStageFlags PushConstantStages =
+        vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+    static constexpr uint32_t MaxPipelines = 16;
+    static constexpr uint32_t MaxTextures = 1u << 20;
+
+    SpriteBatch(JobSystem& jobSystem);
+
+    // Returns the value for Sprite::pipeline. Pipelines must be compatible with InstanceLayout,
+    // a triangle strip topology and PushConstants
+    uint8_t addPipeline(PipelineHandle pipeline);
+
+    void begin();
+    void submit(const Sprite& sprite);
+    // Packs large spans on the JobSystem
+    void submit(std::span<const Sprite> sprites);
+
+    /**
+     * @brief Sorts the submitted sprites and writes their instances into `transientBuffer`.
+     * Returns false if the buffer is too small, in which case nothing is drawn
+     */
+    bool prepare(TransientBuffer& transientBuffer);
+    // Viewport, scissor and the bindless texture set have to be bound already
+    void record(
+        vk::CommandBuffer commandBuffer,
+        const GpuResources& resources,
+        vk::Extent2D screenSize) const;
+
+    uint32_t getSpriteCount() const;
+    uint32_t getDrawCount() const;
+
+  private:
+    struct Draw
+    {
+        uint8_t pipeline;
+        uint32_t texture;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    JobSystem* jobSystem;
+    std::vector<PipelineHandle> pipelines;
+
+    // In submission order. Packing right away halves the memory that has to be gathered in sorted
+    // order, which is what `prepare` spends most of its time on
+    std::vector<Instance> packed;
+    // `order` holds indices into `packed` in draw order after `prepare`
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> keysScratch;
+    std::vector<uint32_t> orderScratch;
+
+    std::vector<Draw> draws;
+    std::optional<TransientBuffer::Allocation> instances;
+
+    // Returns false if the keys were already sorted, in which case `order` isn't filled
+    bool sort();
+};
@@ -0,0 +1,116 @@
+#include "tga.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr size_t HeaderSize = 18;
+
+    uint32_t readTexel(const uint8_t* pixel, uint32_t bytesPerPixel)
+    {
+        switch(bytesPerPixel)
+        {
+            // Gray
+            case 1: return 0xFF000000 | pixel[0] * 0x00010101u;
+            // BGR
+            case 3: return 0xFF000000 | pixel[0] << 16 | pixel[1] << 8 | pixel[2];
+            // BGRA
+            default: return (uint32_t)pixel[3] << 24 | pixel[0] << 16 | pixel[1] << 8 | pixel[2];
+        }
+    }
+}
+
+namespace Tga
+{
+    std::variant<Image, Error> parse(std::span<const std::byte> file)
+    {
+        Error error = {};
+        if(file.size() < HeaderSize)
+        {
+            error.type = ErrorType::Truncated;
+            return error;
+        }
+
+        const auto* bytes = (const uint8_t*)file.data();
+        uint8_t idLength = bytes[0];
+        uint8_t colorMapType = bytes[1];
+        uint8_t imageType = bytes[2];
+        uint32_t width = bytes[12] | bytes[13] << 8;
+        uint32_t height = bytes[14] | bytes[15] << 8;
+        uint32_t bytesPerPixel = bytes[16] / 8;
+        bool topToBottom = bytes[17] & 0x20;
+        bool rightToLeft = bytes[17] & 0x10;
+
+        error.type = ErrorType::Unsupported;
+        bool rle = imageType == 10 || imageType == 11;
+        bool gray = imageType == 3 || imageType == 11;
+        if(colorMapType != 0 || !(imageType == 2 || imageType == 3 || rle))
+        {
+            error.Unsupported.message = "Only true color and grayscale images are supported";
+            return error;
+        }
+        if(gray ? bytesPerPixel != 1 : bytesPerPixel != 3 && bytesPerPixel != 4)
+        {
+            error.Unsupported.message = "Unsupported bits per pixel";
+            return error;
+        }
+        if(width == 0 || height == 0 || rightToLeft)
+        {
+            error.Unsupported.message = "Empty or mirrored images";
+            return error;
+        }
+
+        Image image = {
+            .width = width,
+            .height = height,
+            .texels = std::vector<uint32_t>((size_t)width * height),
+        };
+
+        // Decoded in file order, rows are flipped below
+        error.type = ErrorType::Truncated;
+        const uint8_t* data = bytes + HeaderSize + idLength;
+        const uint8_t* end = bytes + file.size();
+        if(data > end)
+            return error;
+        size_t texelCount = image.texels.size();
+        for(size_t i = 0; i < texelCount;)
+        {
+            uint32_t runLength = 1;
+            bool repeat = false;
+            if(rle)
+            {
+                if(data >= end)
+                    return error;
+                repeat = *data & 0x80;
+                runLength = (*data & 0x7F) + 1u;
+                data++;
+                if(runLength > texelCount - i)
+                    return error;
+            }
+
+            size_t readBytes = repeat ? bytesPerPixel : (size_t)runLength * bytesPerPixel;
+            if((size_t)(end - data) < readBytes)
+                return error;
+            for(uint32_t j = 0; j < runLength; ++j)
+            {
+                const uint8_t* pixel = repeat ? data : data + j * bytesPerPixel;
+                image.texels[i + j] = readTexel(pixel, bytesPerPixel);
+            }
+            data += readBytes;
+            i += runLength;
+        }
+
+        if(!topToBottom)
+        {
+            for(uint32_t y = 0; y < height / 2; ++y)
+            {
+                std::swap_ranges(
+                    image.texels.begin() + (size_t)y * width,
+                    image.texels.begin() + (size_t)(y + 1) * width,
+                    image.texels.begin() + (size_t)(height - 1 - y) * width);
+            }
+        }
+
+        return image;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief Decodes TGA images, uncompressed or RLE, in 8 bit grayscale or 24/32 bit color, which
+ * covers what image editors export by default.
+ */
+namespace Tga
+{
+    struct Image
+    {
+        uint32_t width;
+        uint32_t height;
+        // RGBA8 with red in the lowest byte, top row first
+        std::vector<uint32_t> texels;
+    };
+
+    enum class ErrorType
+    {
+        Truncated,
+        Unsupported,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                const char* message;
+            } Unsupported;
+        };
+    };
+
+    std::variant<Image, Error> parse(std::span<const std::byte> file);
+}
@@ -0,0 +1,262 @@
+// Converts source assets into the GPU ready format in asset_format.h:
+//
+//     asset_cook <input.obj|input.gltf|input.tga> <output>
+//
+// Meshes are deduplicated, optimized for the vertex cache, overdraw and vertex fetch and stored as
+// MeshVertex with 16 bit indices where they fit. Images get a full mip chain, filtered in linear
+// space, and are stored as R8G8B8A8Srgb.
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include "../asset_format.h"
+#include "../gltf_loader.h"
+#include "../job_system.h"
+#include "../mapped_file.h"
+#include "../mesh_optimizer.h"
+#include "../obj_loader.h"
+#include "../tga.h"
+
+namespace
+{
+    float srgbToLinear(uint32_t value)
+    {
+        float c = (float)value / 255.0f;
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    uint32_t linearToSrgb(float c)
+    {
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        return (uint32_t)std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f);
+    }
+
+    // 2x2 box filter, the last row/column is repeated for odd sizes
+    std::vector<uint32_t> downsample(const std::vector<uint32_t>& texels, uint32_t w, uint32_t h)
+    {
+        uint32_t nextWidth = std::max(w / 2, 1u);
+        uint32_t nextHeight = std::max(h / 2, 1u);
+        std::vector<uint32_t> next((size_t)nextWidth * nextHeight);
+        for(uint32_t y = 0; y < nextHeight; ++y)
+        {
+            for(uint32_t x = 0; x < nextWidth; ++x)
+            {
+                float color[4] = {};
+                for(uint32_t i = 0; i < 4; ++i)
+                {
+                    uint32_t sourceX = std::min(x * 2 + (i & 1), w - 1);
+                    uint32_t sourceY = std::min(y * 2 + (i >> 1), h - 1);
+                    uint32_t texel = texels[(size_t)sourceY * w + sourceX];
+                    for(uint32_t c = 0; c < 3; ++c)
+                        color[c] += srgbToLinear((texel >> (c * 8)) & 0xFF) * 0.25f;
+                    color[3] += (float)(texel >> 24) / 255.0f * 0.25f;
+                }
+
+                uint32_t alpha = (uint32_t)std::lround(color[3] * 255.0f);
+                next[(size_t)y * nextWidth + x] = linearToSrgb(color[0])
+                                                  | linearToSrgb(color[1]) << 8
+                                                  | linearToSrgb(color[2]) << 16 | alpha << 24;
+            }
+        }
+        return next;
+    }
+
+    template<typename Index>
+    void addIndices(AssetFormat::Writer& writer, const std::vector<uint32_t>& indices)
+    {
+        std::vector<Index> narrowed(indices.begin(), indices.end());
+        writer.addSection(AssetFormat::SectionType::Indices, std::as_bytes(std::span(narrowed)));
+    }
+
+    std::optional<MeshData> loadObj(std::span<const std::byte> file, JobSystem& jobSystem)
+    {
+        std::string_view text((const char*)file.data(), file.size());
+        auto meshVar = ObjLoader::parse(text, jobSystem);
+        if(std::holds_alternative<ObjLoader::Error>(meshVar))
+        {
+            const auto& error = std::get<ObjLoader::Error>(meshVar);
+            if(error.type == ObjLoader::ErrorType::InvalidNumber)
+                std::cerr << "Invalid number in line " << error.InvalidNumber.line << std::endl;
+            else
+                std::cerr << "Invalid index in line " << error.InvalidIndex.line << std::endl;
+            return std::nullopt;
+        }
+        return std::move(std::get<MeshData>(meshVar));
+    }
+
+    std::optional<MeshData> loadGltf(const std::filesystem::path& input, JobSystem& jobSystem)
+    {
+        auto meshVar = GltfLoader::load(input, jobSystem);
+        if(std::holds_alternative<GltfLoader::Error>(meshVar))
+        {
+            const auto& error = std::get<GltfLoader::Error>(meshVar);
+            if(error.type == GltfLoader::ErrorType::FileNotFound)
+                std::cerr << "A buffer of the glTF file is missing" << std::endl;
+            else if(error.type == GltfLoader::ErrorType::InvalidJson)
+                std::cerr << "The glTF file isn't valid JSON" << std::endl;
+            else if(error.type == GltfLoader::ErrorType::InvalidGltf)
+                std::cerr << "Invalid glTF: " << error.InvalidGltf.message << std::endl;
+            else
+                std::cerr << "Unsupported glTF: " << error.Unsupported.message << std::endl;
+            return std::nullopt;
+        }
+        return std::move(std::get<MeshData>(meshVar));
+    }
+
+    bool cookMesh(MeshData& mesh, const std::filesystem::path& output)
+    {
+        if(mesh.indices.empty())
+        {
+            std::cerr << "The mesh has no faces" << std::endl;
+            return false;
+        }
+
+        auto stride = (uint32_t)sizeof(MeshVertex);
+        uint32_t vertexCount = MeshOptimizer::deduplicateVertices(
+            mesh.vertices.data(),
+            (uint32_t)mesh.vertices.size(),
+            stride,
+            std::span(mesh.indices));
+        MeshOptimizer::optimizeVertexCache(std::span(mesh.indices), vertexCount);
+        MeshOptimizer::optimizeOverdraw(
+            std::span(mesh.indices),
+            &mesh.vertices[0].position.x,
+            vertexCount,
+            stride);
+        vertexCount = MeshOptimizer::optimizeVertexFetch(
+            mesh.vertices.data(),
+            vertexCount,
+            stride,
+            std::span(mesh.indices));
+        mesh.vertices.resize(vertexCount);
+
+        glm::vec3 boundsMin = mesh.vertices[0].position;
+        glm::vec3 boundsMax = mesh.vertices[0].position;
+        for(const MeshVertex& vertex : mesh.vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+
+        bool smallIndices = vertexCount <= 1 << 16;
+        AssetFormat::Writer writer;
+        writer.addSection(
+            AssetFormat::SectionType::MeshInfo,
+            AssetFormat::MeshInfo{
+                .vertexCount = vertexCount,
+                .indexCount = (uint32_t)mesh.indices.size(),
+                .vertexStride = stride,
+                .indexSize = smallIndices ? 2u : 4u,
+                .boundsMin = {boundsMin.x, boundsMin.y, boundsMin.z},
+                .boundsMax = {boundsMax.x, boundsMax.y, boundsMax.z},
+            });
+        writer.addSection(
+            AssetFormat::SectionType::Vertices,
+            std::as_bytes(std::span(mesh.vertices)));
+        if(smallIndices)
+            addIndices<uint16_t>(writer, mesh.indices);
+        else
+            addIndices<uint32_t>(writer, mesh.indices);
+
+        std::cout << vertexCount << " vertices, " << mesh.indices.size() / 3 << " triangles, ACMR "
+                  << MeshOptimizer::averageCacheMissRatio(
+                         mesh.indices.data(),
+                         (uint32_t)mesh.indices.size(),
+                         vertexCount)
+                  << std::endl;
+        return writer.write(output);
+    }
+
+    bool cookTexture(std::span<const std::byte> file, const std::filesystem::path& output)
+    {
+        auto imageVar = Tga::parse(file);
+        if(std::holds_alternative<Tga::Error>(imageVar))
+        {
+            const auto& error = std::get<Tga::Error>(imageVar);
+            if(error.type == Tga::ErrorType::Unsupported)
+                std::cerr << "Unsupported TGA: " << error.Unsupported.message << std::endl;
+            else
+                std::cerr << "Truncated TGA" << std::endl;
+            return false;
+        }
+        Tga::Image& image = std::get<Tga::Image>(imageVar);
+
+        std::vector<std::vector<uint32_t>> levels;
+        levels.push_back(std::move(image.texels));
+        for(uint32_t w = image.width, h = image.height; w > 1 || h > 1;)
+        {
+            levels.push_back(downsample(levels.back(), w, h));
+            w = std::max(w / 2, 1u);
+            h = std::max(h / 2, 1u);
+        }
+
+        AssetFormat::Writer writer;
+        writer.addSection(
+            AssetFormat::SectionType::TextureInfo,
+            AssetFormat::TextureInfo{
+                .format = VK_FORMAT_R8G8B8A8_SRGB,
+                .width = image.width,
+                .height = image.height,
+                .levelCount = (uint32_t)levels.size(),
+            });
+        for(const std::vector<uint32_t>& level : levels)
+        {
+            writer.addSection(
+                AssetFormat::SectionType::TextureLevel,
+                std::as_bytes(std::span(level)));
+        }
+
+        std::cout << image.width << "x" << image.height << ", " << levels.size() << " levels"
+                  << std::endl;
+        return writer.write(output);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc != 3)
+    {
+        std::cerr << "Usage: asset_cook <input.obj|input.gltf|input.tga> <output>" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path input = argv[1];
+    std::filesystem::path output = argv[2];
+    auto file = MappedFile::open(input);
+    if(!file.has_value())
+    {
+        std::cerr << "Can't open " << input << std::endl;
+        return 1;
+    }
+
+    JobSystem jobSystem(0, false);
+    bool cooked;
+    if(input.extension() == ".obj" || input.extension() == ".gltf")
+    {
+        auto mesh = input.extension() == ".obj" ? loadObj(file->getData(), jobSystem)
+                                                : loadGltf(input, jobSystem);
+        cooked = mesh.has_value() && cookMesh(mesh.value(), output);
+    }
+    else if(input.extension() == ".tga")
+        cooked = cookTexture(file->getData(), output);
+    else
+    {
+        std::cerr << "Unknown asset type " << input.extension() << std::endl;
+        return 1;
+    }
+
+    if(!cooked)
+    {
+        std::cerr << "Failed to cook " << input << std::endl;
+        return 1;
+    }
+    return 0;
+}
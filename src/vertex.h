@@ -2,8 +2,67 @@
 
 #include <glm/glm.hpp>
 
+#include "quantize.h"
+#include "vulkan/vertex_layout.h"
+
 struct TriangleVertex
 {
     glm::vec2 position;
     glm::vec3 color;
-};
\ No newline at end of file
+};
+
+constexpr auto TriangleVertexLayout = makeVertexLayout<TriangleVertex>({
+    VERTEX_ATTRIBUTE(TriangleVertex, position, vk::Format::eR32G32Sfloat),
+    VERTEX_ATTRIBUTE(TriangleVertex, color, vk::Format::eR32G32B32Sfloat),
+});
+
+// 8 bytes instead of 20: vk::Format::eR16G16Sfloat position and eR8G8B8A8Unorm color
+struct PackedTriangleVertex
+{
+    uint16_t position[2];
+    uint8_t color[4];
+};
+
+constexpr auto PackedTriangleVertexLayout = makeVertexLayout<PackedTriangleVertex>({
+    VERTEX_ATTRIBUTE(PackedTriangleVertex, position, vk::Format::eR16G16Sfloat),
+    VERTEX_ATTRIBUTE(PackedTriangleVertex, color, vk::Format::eR8G8B8A8Unorm),
+});
+
+inline PackedTriangleVertex packVertex(const TriangleVertex& vertex)
+{
+    return PackedTriangleVertex{
+        .position = {Quantize::toHalf(vertex.position.x), Quantize::toHalf(vertex.position.y)},
+        .color =
+            {
+                Quantize::toUnorm8(vertex.color.r),
+                Quantize::toUnorm8(vertex.color.g),
+                Quantize::toUnorm8(vertex.color.b),
+                255,
+            },
+    };
+}
+
+// 20 bytes: vk::Format::eR32G32B32Sfloat position, eA2B10G10R10UnormPack32 normal and
+// eR16G16Sfloat uv. The SNORM variant isn't a mandatory vertex buffer format, so the normal is
+// stored as n * 0.5 + 0.5 and shaders unpack it with n * 2 - 1
+struct MeshVertex
+{
+    glm::vec3 position;
+    uint32_t normal;
+    uint16_t uv[2];
+};
+
+constexpr auto MeshVertexLayout = makeVertexLayout<MeshVertex>({
+    VERTEX_ATTRIBUTE(MeshVertex, position, vk::Format::eR32G32B32Sfloat),
+    VERTEX_ATTRIBUTE(MeshVertex, normal, vk::Format::eA2B10G10R10UnormPack32),
+    VERTEX_ATTRIBUTE(MeshVertex, uv, vk::Format::eR16G16Sfloat),
+});
+
+inline MeshVertex packMeshVertex(glm::vec3 position, glm::vec3 normal, glm::vec2 uv)
+{
+    return MeshVertex{
+        .position = position,
+        .normal = Quantize::toUnorm10x3(normal * 0.5f + 0.5f),
+        .uv = {Quantize::toHalf(uv.x), Quantize::toHalf(uv.y)},
+    };
+}
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include "asset_loader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "../mapped_file.h"
+#include "commands.h"
+
+namespace
+{
+    constexpr vk::DeviceSize StagingAlignment = 16;
+
+    AssetLoader::Error invalidFile(const AssetFormat::Error& formatError)
+    {
+        AssetLoader::Error error = {};
+        error.type = AssetLoader::ErrorType::InvalidFile;
+        error.InvalidFile.error = formatError;
+        return error;
+    }
+
+    AssetLoader::Error missingSection(AssetFormat::SectionType type)
+    {
+        AssetFormat::Error formatError = {};
+        formatError.type = AssetFormat::ErrorType::MissingSection;
+        formatError.MissingSection.type = type;
+        return invalidFile(formatError);
+    }
+
+    AssetLoader::Error truncated()
+    {
+        AssetFormat::Error formatError = {};
+        formatError.type = AssetFormat::ErrorType::Truncated;
+        return invalidFile(formatError);
+    }
+}
+
+AssetLoader::AssetLoader(
+    const vk::UniqueDevice& device,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    GpuResources& resources,
+    bool verifyChecksums)
+    : device(device)
+    , memoryProperties(memoryProperties)
+    , resources(resources)
+    , verifyChecksums(verifyChecksums)
+{
+}
+
+std::variant<LoadedMesh, AssetLoader::Error> AssetLoader::loadMesh(
+    const std::filesystem::path& path,
+    vk::CommandBuffer commandBuffer,
+    TransientBuffer& staging)
+{
+    Error error = {};
+
+    auto file = MappedFile::open(path);
+    if(!file.has_value())
+    {
+        error.type = ErrorType::FileNotFound;
+        return error;
+    }
+    auto readerVar = AssetFormat::Reader::open(file->getData(), verifyChecksums);
+    if(std::holds_alternative<AssetFormat::Error>(readerVar))
+        return invalidFile(std::get<AssetFormat::Error>(readerVar));
+    const AssetFormat::Reader& reader = std::get<AssetFormat::Reader>(readerVar);
+
+    auto info = reader.getStruct<AssetFormat::MeshInfo>(AssetFormat::SectionType::MeshInfo);
+    if(!info.has_value())
+        return missingSection(AssetFormat::SectionType::MeshInfo);
+    auto vertices = reader.getSection(AssetFormat::SectionType::Vertices);
+    auto indices = reader.getSection(AssetFormat::SectionType::Indices);
+    if(vertices.empty())
+        return missingSection(AssetFormat::SectionType::Vertices);
+    if(indices.empty())
+        return missingSection(AssetFormat::SectionType::Indices);
+    if((info->indexSize != 2 && info->indexSize != 4)
+       || vertices.size() != (size_t)info->vertexCount * info->vertexStride
+       || indices.size() != (size_t)info->indexCount * info->indexSize)
+        return truncated();
+
+    // Both sections go into one allocation so a mesh is either staged completely or not at all
+    vk::DeviceSize indexOffset = (vertices.size() + 3) & ~(vk::DeviceSize)3;
+    auto allocationVar = allocateStaging(staging, indexOffset + indices.size());
+    if(std::holds_alternative<Error>(allocationVar))
+        return std::get<Error>(allocationVar);
+    const TransientBuffer::Allocation& allocation =
+        std::get<TransientBuffer::Allocation>(allocationVar);
+    std::memcpy(allocation.data, vertices.data(), vertices.size());
+    std::memcpy((std::byte*)allocation.data + indexOffset, indices.data(), indices.size());
+
+    auto vertexBuilder = Buffer::Builder(device);
+    vertexBuilder.withVertexBufferFormat()
+        .withTransferDestFormat(memoryProperties)
+        .withSize((uint32_t)vertices.size());
+    auto vertexBufferVar = createBuffer(vertexBuilder);
+    if(std::holds_alternative<Error>(vertexBufferVar))
+        return std::get<Error>(vertexBufferVar);
+    auto indexBuilder = Buffer::Builder(device);
+    indexBuilder.withIndexBufferFormat()
+        .withTransferDestFormat(memoryProperties)
+        .withSize((uint32_t)indices.size());
+    auto indexBufferVar = createBuffer(indexBuilder);
+    if(std::holds_alternative<Error>(indexBufferVar))
+        return std::get<Error>(indexBufferVar);
+    Buffer& vertexBuffer = std::get<Buffer>(vertexBufferVar);
+    Buffer& indexBuffer = std::get<Buffer>(indexBufferVar);
+
+    vk::BufferCopy vertexCopy = {
+        .srcOffset = allocation.offset,
+        .dstOffset = 0,
+        .size = vertices.size(),
+    };
+    commandBuffer.copyBuffer(allocation.buffer, vertexBuffer.buffer.get(), 1, &vertexCopy);
+    vk::BufferCopy indexCopy = {
+        .srcOffset = allocation.offset + indexOffset,
+        .dstOffset = 0,
+        .size = indices.size(),
+    };
+    commandBuffer.copyBuffer(allocation.buffer, indexBuffer.buffer.get(), 1, &indexCopy);
+
+    vk::MemoryBarrier barrier = {
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead,
+    };
+    commandBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eVertexInput,
+        vk::DependencyFlags(),
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+
+    return LoadedMesh{
+        .vertexBuffer = resources.addBuffer(std::move(vertexBuffer)),
+        .indexBuffer = resources.addBuffer(std::move(indexBuffer)),
+        .indexType = info->indexSize == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32,
+        .info = info.value(),
+    };
+}
+
+std::variant<ImageHandle, AssetLoader::Error> AssetLoader::loadTexture(
+    const std::filesystem::path& path,
+    vk::CommandBuffer commandBuffer,
+    TransientBuffer& staging)
+{
+    Error error = {};
+
+    auto file = MappedFile::open(path);
+    if(!file.has_value())
+    {
+        error.type = ErrorType::FileNotFound;
+        return error;
+    }
+    auto readerVar = AssetFormat::Reader::open(file->getData(), verifyChecksums);
+    if(std::holds_alternative<AssetFormat::Error>(readerVar))
+        return invalidFile(std::get<AssetFormat::Error>(readerVar));
+    const AssetFormat::Reader& reader = std::get<AssetFormat::Reader>(readerVar);
+
+    auto info = reader.getStruct<AssetFormat::TextureInfo>(AssetFormat::SectionType::TextureInfo);
+    if(!info.has_value())
+        return missingSection(AssetFormat::SectionType::TextureInfo);
+    auto levels = reader.getSections(AssetFormat::SectionType::TextureLevel);
+    if(levels.empty())
+        return missingSection(AssetFormat::SectionType::TextureLevel);
+
+    if(info->width == 0 || info->height == 0 || info->levelCount != levels.size()
+       || info->levelCount > fullMipLevelCount(info->width, info->height))
+        return truncated();
+    // asset_cook only writes RGBA8, which the level sizes below rely on
+    auto format = (vk::Format)info->format;
+    if(format != vk::Format::eR8G8B8A8Srgb && format != vk::Format::eR8G8B8A8Unorm)
+    {
+        error.type = ErrorType::UnsupportedFormat;
+        error.UnsupportedFormat.format = format;
+        return error;
+    }
+    vk::DeviceSize totalSize = 0;
+    for(uint32_t level = 0; level < info->levelCount; ++level)
+    {
+        vk::DeviceSize width = std::max(info->width >> level, 1u);
+        vk::DeviceSize height = std::max(info->height >> level, 1u);
+        if(levels[level].size() != width * height * 4)
+            return truncated();
+        totalSize += levels[level].size();
+    }
+
+    auto allocationVar = allocateStaging(staging, totalSize);
+    if(std::holds_alternative<Error>(allocationVar))
+        return std::get<Error>(allocationVar);
+    const TransientBuffer::Allocation& allocation =
+        std::get<TransientBuffer::Allocation>(allocationVar);
+
+    auto imageVar = Image::Builder(device)
+                        .withExtent(info->width, info->height)
+                        .withFormat(format)
+                        .withMipLevels(info->levelCount)
+                        .withTransferDestUsage()
+                        .withSampledUsage()
+                        .withMemoryProperties(memoryProperties)
+                        .build();
+    if(std::holds_alternative<Image::Builder::Error>(imageVar))
+    {
+        error.type = ErrorType::CreateImage;
+        error.CreateImage.error = std::get<Image::Builder::Error>(imageVar);
+        return error;
+    }
+    Image& image = std::get<Image>(imageVar);
+
+    std::vector<vk::BufferImageCopy> copies;
+    copies.reserve(levels.size());
+    vk::DeviceSize offset = 0;
+    for(uint32_t level = 0; level < info->levelCount; ++level)
+    {
+        std::memcpy(
+            (std::byte*)allocation.data + offset,
+            levels[level].data(),
+            levels[level].size());
+        copies.push_back({
+            .bufferOffset = allocation.offset + offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource =
+                {
+                    .aspectMask = vk::ImageAspectFlagBits::eColor,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            .imageOffset = {0, 0, 0},
+            .imageExtent =
+                {
+                    std::max(info->width >> level, 1u),
+                    std::max(info->height >> level, 1u),
+                    1,
+                },
+        });
+        offset += levels[level].size();
+    }
+
+    Commands::transitionImageLayout(
+        commandBuffer,
+        image.image.get(),
+        vk::ImageLayout::eUndefined,
+        vk::ImageLayout::eTransferDstOptimal,
+        image.allLevels());
+    commandBuffer.copyBufferToImage(
+        allocation.buffer,
+        image.image.get(),
+        vk::ImageLayout::eTransferDstOptimal,
+        (uint32_t)copies.size(),
+        copies.data());
+    Commands::transitionImageLayout(
+        commandBuffer,
+        image.image.get(),
+        vk::ImageLayout::eTransferDstOptimal,
+        vk::ImageLayout::eShaderReadOnlyOptimal,
+        image.allLevels());
+
+    return resources.addImage(std::move(image));
+}
+
+std::variant<TransientBuffer::Allocation, AssetLoader::Error> AssetLoader::allocateStaging(
+    TransientBuffer& staging,
+    vk::DeviceSize size) const
+{
+    Error error = {};
+    if(size > staging.getCapacity())
+    {
+        error.type = ErrorType::TooLargeForStaging;
+        error.TooLargeForStaging.size = size;
+        return error;
+    }
+
+    auto allocation = staging.allocate(size, StagingAlignment);
+    if(!allocation.has_value())
+    {
+        error.type = ErrorType::StagingFull;
+        return error;
+    }
+    return allocation.value();
+}
+
+std::variant<Buffer, AssetLoader::Error> AssetLoader::createBuffer(Buffer::Builder& builder) const
+{
+    Error error = {};
+
+    auto bufferVar = builder.build();
+    if(std::holds_alternative<Buffer::Builder::Error>(bufferVar))
+    {
+        error.type = ErrorType::CreateBuffer;
+        error.CreateBuffer.error = std::get<Buffer::Builder::Error>(bufferVar);
+        return error;
+    }
+    Buffer& buffer = std::get<Buffer>(bufferVar);
+
+    vk::Result bbmRes = device->bindBufferMemory(buffer.buffer.get(), buffer.memory.get(), 0);
+    if(bbmRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::BindBufferMemory;
+        error.BindBufferMemory.result = bbmRes;
+        return error;
+    }
+    return std::move(buffer);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <filesystem>
+#include <variant>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../asset_format.h"
+#include "gpu_resources.h"
+#include "transient_buffer.h"
+
+struct LoadedMesh
+{
+    BufferHandle vertexBuffer;
+    BufferHandle indexBuffer;
+    vk::IndexType indexType;
+    AssetFormat::MeshInfo info;
+};
+
+/**
+ * @brief Loads files written by asset_cook.
+ *
+ * Cooked sections are already in the layout the GPU uses, so a load maps the file, copies the
+ * sections into the frame's TransientBuffer and records the copies into device local buffers or
+ * images. Nothing is parsed or converted and the file is unmapped again when the load returns.
+ *
+ * The recorded copies are followed by barriers for vertex input and shader reads, so the results
+ * can be used by anything recorded after them.
+ */
+class AssetLoader
+{
+  public:
+    enum class ErrorType
+    {
+        FileNotFound,
+        InvalidFile,
+        // Try again with the next frame's staging
+        StagingFull,
+        // Bigger than the whole staging buffer, so it won't fit in any frame either
+        TooLargeForStaging,
+        // Only RGBA8 textures can be loaded
+        UnsupportedFormat,
+        CreateBuffer,
+        BindBufferMemory,
+        CreateImage,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                AssetFormat::Error error;
+            } InvalidFile;
+            struct
+            {
+                vk::DeviceSize size;
+            } TooLargeForStaging;
+            struct
+            {
+                vk::Format format;
+            } UnsupportedFormat;
+            struct
+            {
+                Buffer::Builder::Error error;
+            } CreateBuffer;
+            struct
+            {
+                vk::Result result;
+            } BindBufferMemory;
+            struct
+            {
+                Image::Builder::Error error;
+            } CreateImage;
+        };
+    };
+
+    // Checksums cost a pass over every byte, so only verify them while assets are changing
+    AssetLoader(
+        const vk::UniqueDevice& device,
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+        GpuResources& resources,
+        bool verifyChecksums);
+
+    std::variant<LoadedMesh, Error> loadMesh(
+        const std::filesystem::path& path,
+        vk::CommandBuffer commandBuffer,
+        TransientBuffer& staging);
+    std::variant<ImageHandle, Error> loadTexture(
+        const std::filesystem::path& path,
+        vk::CommandBuffer commandBuffer,
+        TransientBuffer& staging);
+
+  private:
+    const vk::UniqueDevice& device;
+    vk::PhysicalDeviceMemoryProperties memoryProperties;
+    GpuResources& resources;
+    bool verifyChecksums;
+
+    // StagingFull or TooLargeForStaging if `size` bytes can't be staged
+    std::variant<TransientBuffer::Allocation, Error> allocateStaging(
+        TransientBuffer& staging,
+        vk::DeviceSize size) const;
+    // Builds and binds the memory of a transfer destination from `builder`
+    std::variant<Buffer, Error> createBuffer(Buffer::Builder& builder) const;
+};
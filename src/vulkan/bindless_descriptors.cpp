@@ -0,0 +1,247 @@
+#include "bindless_descriptors.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr vk::ShaderStageFlags BindlessStages = vk::ShaderStageFlagBits::eVertex
+                                                    | vk::ShaderStageFlagBits::eFragment
+                                                    | vk::ShaderStageFlagBits::eCompute;
+}
+
+std::variant<BindlessDescriptors, BindlessDescriptors::Error> BindlessDescriptors::create(
+    const vk::UniqueDevice& device,
+    vk::PhysicalDevice physicalDevice,
+    GpuTimeline& timeline,
+    uint32_t maxTextures,
+    uint32_t maxBuffers)
+{
+    Error error = {};
+
+    vk::PhysicalDeviceVulkan12Properties properties12 = {};
+    vk::PhysicalDeviceProperties2 properties = {.pNext = &properties12};
+    physicalDevice.getProperties2(&properties);
+    // Combined image samplers count as both a sampler and a sampled image
+    uint32_t textureCount = std::min({
+        maxTextures,
+        properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+        properties12.maxDescriptorSetUpdateAfterBindSamplers,
+        properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+    });
+    uint32_t bufferCount = std::min({
+        maxBuffers,
+        properties12.maxDescriptorSetUpdateAfterBindStorageBuffers,
+        properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+    });
+
+    vk::DescriptorBindingFlags bindingFlags =
+        vk::DescriptorBindingFlagBits::ePartiallyBound
+        | vk::DescriptorBindingFlagBits::eUpdateAfterBind
+        | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+    auto createSetLayout = [&](vk::DescriptorType type, uint32_t count) {
+        vk::DescriptorSetLayoutBinding binding = {
+            .binding = 0,
+            .descriptorType = type,
+            .descriptorCount = count,
+            .stageFlags = BindlessStages,
+            .pImmutableSamplers = nullptr,
+        };
+        vk::DescriptorSetLayoutBindingFlagsCreateInfo flagsInfo = {
+            .bindingCount = 1,
+            .pBindingFlags = &bindingFlags,
+        };
+        return device->createDescriptorSetLayoutUnique({
+            .pNext = &flagsInfo,
+            .flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+            .bindingCount = 1,
+            .pBindings = &binding,
+        });
+    };
+    auto [ctslRes, textureSetLayout] =
+        createSetLayout(vk::DescriptorType::eCombinedImageSampler, textureCount);
+    auto [cbslRes, bufferSetLayout] =
+        createSetLayout(vk::DescriptorType::eStorageBuffer, bufferCount);
+    if(ctslRes != vk::Result::eSuccess || cbslRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::CreateSetLayout;
+        error.CreateSetLayout.result = ctslRes != vk::Result::eSuccess ? ctslRes : cbslRes;
+        return error;
+    }
+
+    std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+        vk::DescriptorPoolSize{
+            .type = vk::DescriptorType::eCombinedImageSampler,
+            .descriptorCount = textureCount,
+        },
+        vk::DescriptorPoolSize{
+            .type = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = bufferCount,
+        },
+    };
+    auto [cdpRes, pool] = device->createDescriptorPoolUnique({
+        .flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+        .maxSets = 2,
+        .poolSizeCount = (uint32_t)poolSizes.size(),
+        .pPoolSizes = poolSizes.data(),
+    });
+    if(cdpRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::CreatePool;
+        error.CreatePool.result = cdpRes;
+        return error;
+    }
+
+    std::array<vk::DescriptorSetLayout, 2> layouts = {};
+    layouts[TextureSet] = textureSetLayout.get();
+    layouts[BufferSet] = bufferSetLayout.get();
+    auto [adsRes, descriptorSets] = device->allocateDescriptorSets({
+        .descriptorPool = pool.get(),
+        .descriptorSetCount = (uint32_t)layouts.size(),
+        .pSetLayouts = layouts.data(),
+    });
+    if(adsRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::AllocateSets;
+        error.AllocateSets.result = adsRes;
+        return error;
+    }
+
+    std::array<vk::UniqueDescriptorSetLayout, 2> setLayouts;
+    setLayouts[TextureSet] = std::move(textureSetLayout);
+    setLayouts[BufferSet] = std::move(bufferSetLayout);
+    return BindlessDescriptors(
+        device.get(),
+        timeline,
+        std::move(setLayouts),
+        std::move(pool),
+        {descriptorSets[0], descriptorSets[1]},
+        textureCount,
+        bufferCount);
+}
+
+BindlessDescriptors::BindlessDescriptors(
+    vk::Device device,
+    GpuTimeline& timeline,
+    std::array<vk::UniqueDescriptorSetLayout, 2>&& setLayouts,
+    vk::UniqueDescriptorPool&& pool,
+    std::array<vk::DescriptorSet, 2> sets,
+    uint32_t textureCapacity,
+    uint32_t bufferCapacity)
+    : device(device)
+    , timeline(timeline)
+    , setLayouts(std::move(setLayouts))
+    , pool(std::move(pool))
+    , sets(sets)
+    , textures({.capacity = textureCapacity, .next = 0, .free = {}, .retired = {}})
+    , buffers({.capacity = bufferCapacity, .next = 0, .free = {}, .retired = {}})
+{
+}
+
+std::optional<uint32_t> BindlessDescriptors::addTexture(vk::ImageView view, vk::Sampler sampler)
+{
+    auto index = allocate(textures);
+    if(!index.has_value())
+        return std::nullopt;
+
+    vk::DescriptorImageInfo imageInfo = {
+        .sampler = sampler,
+        .imageView = view,
+        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+    };
+    vk::WriteDescriptorSet write = {
+        .dstSet = sets[TextureSet],
+        .dstBinding = 0,
+        .dstArrayElement = index.value(),
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        .pImageInfo = &imageInfo,
+    };
+    device.updateDescriptorSets(1, &write, 0, nullptr);
+    return index;
+}
+
+std::optional<uint32_t> BindlessDescriptors::addBuffer(
+    vk::Buffer buffer,
+    vk::DeviceSize offset,
+    vk::DeviceSize range)
+{
+    auto index = allocate(buffers);
+    if(!index.has_value())
+        return std::nullopt;
+
+    vk::DescriptorBufferInfo bufferInfo = {
+        .buffer = buffer,
+        .offset = offset,
+        .range = range,
+    };
+    vk::WriteDescriptorSet write = {
+        .dstSet = sets[BufferSet],
+        .dstBinding = 0,
+        .dstArrayElement = index.value(),
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eStorageBuffer,
+        .pBufferInfo = &bufferInfo,
+    };
+    device.updateDescriptorSets(1, &write, 0, nullptr);
+    return index;
+}
+
+void BindlessDescriptors::removeTexture(uint32_t index, uint64_t timelineValue)
+{
+    textures.retired.push_back({.index = index, .timelineValue = timelineValue});
+}
+
+void BindlessDescriptors::removeBuffer(uint32_t index, uint64_t timelineValue)
+{
+    buffers.retired.push_back({.index = index, .timelineValue = timelineValue});
+}
+
+void BindlessDescriptors::bind(
+    vk::CommandBuffer commandBuffer,
+    vk::PipelineBindPoint bindPoint,
+    vk::PipelineLayout layout) const
+{
+    commandBuffer.bindDescriptorSets(
+        bindPoint,
+        layout,
+        0,
+        (uint32_t)sets.size(),
+        sets.data(),
+        0,
+        nullptr);
+}
+
+std::array<vk::DescriptorSetLayout, 2> BindlessDescriptors::getSetLayouts() const
+{
+    return {setLayouts[0].get(), setLayouts[1].get()};
+}
+
+uint32_t BindlessDescriptors::getTextureCapacity() const
+{
+    return textures.capacity;
+}
+
+uint32_t BindlessDescriptors::getBufferCapacity() const
+{
+    return buffers.capacity;
+}
+
+std::optional<uint32_t> BindlessDescriptors::allocate(Slots& slots)
+{
+    while(!slots.retired.empty() && timeline.isComplete(slots.retired.front().timelineValue))
+    {
+        slots.free.push_back(slots.retired.front().index);
+        slots.retired.pop_front();
+    }
+
+    if(!slots.free.empty())
+    {
+        uint32_t index = slots.free.back();
+        slots.free.pop_back();
+        return index;
+    }
+    if(slots.next == slots.capacity)
+        return std::nullopt;
+    return slots.next++;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "gpu_timeline.h"
+
+/**
+ * @brief One large descriptor set per resource type, indexed by shaders with integers that are
+ * usually passed as push constants.
+ *
+ * Set `TextureSet` is an array of combined image samplers and set `BufferSet` an array of storage
+ * buffers, both at binding 0 and both bound once per command buffer instead of per draw. The sets
+ * are update-after-bind and partially bound, so slots can be written while the sets are bound in
+ * command buffers that are still executing, as long as those don't use the slots. That's why a
+ * removed slot is only handed out again once the timeline has passed its last use.
+ *
+ * The device needs the descriptorIndexing, runtimeDescriptorArray, descriptorBindingPartiallyBound,
+ * descriptorBindingUpdateUnusedWhilePending, descriptorBindingSampledImageUpdateAfterBind and
+ * descriptorBindingStorageBufferUpdateAfterBind Vulkan 1.2 features.
+ */
+class BindlessDescriptors
+{
+  public:
+    enum class ErrorType
+    {
+        CreateSetLayout,
+        CreatePool,
+        AllocateSets,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                vk::Result result;
+            } CreateSetLayout;
+            struct
+            {
+                vk::Result result;
+            } CreatePool;
+            struct
+            {
+                vk::Result result;
+            } AllocateSets;
+        };
+    };
+
+    // Set numbers in shaders
+    static constexpr uint32_t TextureSet = 0;
+    static constexpr uint32_t BufferSet = 1;
+
+    // The counts are clamped to the device's update-after-bind limits
+    static std::variant<BindlessDescriptors, Error> create(
+        const vk::UniqueDevice& device,
+        vk::PhysicalDevice physicalDevice,
+        GpuTimeline& timeline,
+        uint32_t maxTextures,
+        uint32_t maxBuffers);
+
+    // Returns the index for shaders, or nothing if every slot is taken. `view` is sampled in
+    // ShaderReadOnlyOptimal
+    std::optional<uint32_t> addTexture(vk::ImageView view, vk::Sampler sampler);
+    std::optional<uint32_t> addBuffer(
+        vk::Buffer buffer,
+        vk::DeviceSize offset = 0,
+        vk::DeviceSize range = VK_WHOLE_SIZE);
+
+    // The slot is reused once `timelineValue`, the last submission that uses it, has completed
+    void removeTexture(uint32_t index, uint64_t timelineValue);
+    void removeBuffer(uint32_t index, uint64_t timelineValue);
+
+    // Binds both sets. `layout` has to be created with `getSetLayouts` in this order
+    void bind(
+        vk::CommandBuffer commandBuffer,
+        vk::PipelineBindPoint bindPoint,
+        vk::PipelineLayout layout) const;
+
+    std::array<vk::DescriptorSetLayout, 2> getSetLayouts() const;
+    uint32_t getTextureCapacity() const;
+    uint32_t getBufferCapacity() const;
+
+  private:
+    struct RetiredSlot
+    {
+        uint32_t index;
+        uint64_t timelineValue;
+    };
+
+    struct Slots
+    {
+        uint32_t capacity;
+        // Every slot from here on has never been used
+        uint32_t next;
+        std::vector<uint32_t> free;
+        // In the order they were removed, which is also timeline order
+        std::deque<RetiredSlot> retired;
+    };
+
+    BindlessDescriptors(
+        vk::Device device,
+        GpuTimeline& timeline,
+        std::array<vk::UniqueDescriptorSetLayout, 2>&& setLayouts,
+        vk::UniqueDescriptorPool&& pool,
+        std::array<vk::DescriptorSet, 2> sets,
+        uint32_t textureCapacity,
+        uint32_t bufferCapacity);
+
+    vk::Device device;
+    GpuTimeline& timeline;
+    std::array<vk::UniqueDescriptorSetLayout, 2> setLayouts;
+    vk::UniqueDescriptorPool pool;
+    std::array<vk::DescriptorSet, 2> sets;
+
+    Slots textures;
+    Slots buffers;
+
+    std::optional<uint32_t> allocate(Slots& slots);
+};
@@ -19,6 +19,12 @@ Builder& Builder::withVertexBufferFormat()
     return *this;
 }
 
+Builder& Builder::withIndexBufferFormat()
+{
+    bufferInfo.usage |= vk::BufferUsageFlagBits::eIndexBuffer;
+    return *this;
+}
+
 Builder::Self& Buffer::Builder::withTransferSourceFormat(
     const vk::PhysicalDeviceMemoryProperties& memoryProperties)
 {
@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <optional>
+#include <type_traits>
 #include <variant>
 #include <vulkan/vulkan_raii.hpp>
 
@@ -50,6 +51,7 @@ struct Buffer
 
         Self& withSize(uint32_t);
         Self& withVertexBufferFormat();
+        Self& withIndexBufferFormat();
         Self& withTransferSourceFormat(const vk::PhysicalDeviceMemoryProperties&);
         Self& withTransferDestFormat(const vk::PhysicalDeviceMemoryProperties&);
         Self& withMapFunctionality(const vk::PhysicalDeviceMemoryProperties&);
@@ -74,4 +76,13 @@ struct Buffer
     uint32_t size;
     vk::UniqueBuffer buffer;
     vk::UniqueDeviceMemory memory;
-};
\ No newline at end of file
+};
+
+template<typename Index>
+constexpr vk::IndexType indexTypeOf()
+{
+    static_assert(
+        std::is_same_v<Index, uint16_t> || std::is_same_v<Index, uint32_t>,
+        "Only 16 and 32 bit indices are supported");
+    return std::is_same_v<Index, uint16_t> ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "command_recorder.h"
+
+#include <cassert>
+
+using Builder = CommandRecorder::Builder;
+
+Builder::Builder(const vk::UniqueDevice& device)
+    : device(device)
+    , jobSystem(nullptr)
+    , queueFamilyIndex(0)
+{
+}
+
+Builder& Builder::usingJobSystem(JobSystem& jobSystem)
+{
+    this->jobSystem = &jobSystem;
+    return *this;
+}
+
+Builder& Builder::withQueueFamily(uint32_t index)
+{
+    this->queueFamilyIndex = index;
+    return *this;
+}
+
+std::variant<CommandRecorder, vk::Result> Builder::build() const
+{
+    assert(jobSystem);
+    uint32_t threadCount = jobSystem->getThreadCount();
+
+    std::vector<ThreadPool> pools;
+    pools.reserve(threadCount);
+    for(uint32_t i = 0; i < threadCount; ++i)
+    {
+        auto [ccpRes, pool] = device->createCommandPoolUnique({
+            .flags = vk::CommandPoolCreateFlagBits::eTransient,
+            .queueFamilyIndex = queueFamilyIndex,
+        });
+        if(ccpRes != vk::Result::eSuccess)
+            return ccpRes;
+
+        pools.push_back(ThreadPool{
+            .pool = std::move(pool),
+            .secondaries = {},
+            .usedSecondaries = 0,
+        });
+    }
+
+    // The primary command buffer is always recorded on the main thread
+    auto [acbRes, commandBuffers] = device->allocateCommandBuffers({
+        .commandPool = pools[0].pool.get(),
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1,
+    });
+    if(acbRes != vk::Result::eSuccess)
+        return acbRes;
+
+    return CommandRecorder(device.get(), *jobSystem, std::move(pools), commandBuffers[0]);
+}
+
+CommandRecorder::CommandRecorder(
+    vk::Device device,
+    JobSystem& jobSystem,
+    std::vector<ThreadPool>&& pools,
+    vk::CommandBuffer primaryCommandBuffer)
+    : device(device)
+    , jobSystem(&jobSystem)
+    , pools(std::move(pools))
+    , primaryCommandBuffer(primaryCommandBuffer)
+{
+}
+
+vk::Result CommandRecorder::reset()
+{
+    for(ThreadPool& threadPool : pools)
+    {
+        auto res = device.resetCommandPool(threadPool.pool.get(), vk::CommandPoolResetFlags());
+        if(res != vk::Result::eSuccess)
+            return res;
+        threadPool.usedSecondaries = 0;
+    }
+    return vk::Result::eSuccess;
+}
+
+vk::CommandBuffer CommandRecorder::primary() const
+{
+    return primaryCommandBuffer;
+}
+
+vk::Result CommandRecorder::recordParallel(
+    const vk::CommandBufferInheritanceInfo& inheritance,
+    uint32_t taskCount,
+    const RecordFunction& record)
+{
+    if(taskCount == 0)
+        return vk::Result::eSuccess;
+
+    recorded.resize(taskCount);
+    results.assign(taskCount, vk::Result::eSuccess);
+
+    auto recordTask = [&](uint32_t task) {
+        // Jobs never migrate between threads, so this pool is only used by this thread
+        ThreadPool& threadPool = pools[jobSystem->currentThreadIndex()];
+
+        vk::CommandBuffer commandBuffer;
+        auto res = acquireSecondary(threadPool, commandBuffer);
+        if(res != vk::Result::eSuccess)
+        {
+            results[task] = res;
+            return;
+        }
+
+        vk::CommandBufferBeginInfo beginInfo = {
+            .flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue
+                     | vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+            .pInheritanceInfo = &inheritance,
+        };
+        res = commandBuffer.begin(beginInfo);
+        if(res != vk::Result::eSuccess)
+        {
+            results[task] = res;
+            return;
+        }
+
+        record(commandBuffer, task);
+
+        results[task] = commandBuffer.end();
+        recorded[task] = commandBuffer;
+    };
+
+    if(taskCount == 1)
+    {
+        recordTask(0);
+    }
+    else
+    {
+        JobSystem::Counter counter;
+        for(uint32_t task = 0; task < taskCount; ++task)
+            jobSystem->run([&recordTask, task]() { recordTask(task); }, &counter);
+        jobSystem->wait(counter);
+    }
+
+    for(vk::Result res : results)
+    {
+        if(res != vk::Result::eSuccess)
+            return res;
+    }
+
+    primaryCommandBuffer.executeCommands(taskCount, recorded.data());
+    return vk::Result::eSuccess;
+}
+
+vk::Result CommandRecorder::acquireSecondary(
+    ThreadPool& threadPool,
+    vk::CommandBuffer& commandBuffer)
+{
+    if(threadPool.usedSecondaries == threadPool.secondaries.size())
+    {
+        // Grow in small batches since most frames use about as many buffers as the last one
+        auto [acbRes, commandBuffers] = device.allocateCommandBuffers({
+            .commandPool = threadPool.pool.get(),
+            .level = vk::CommandBufferLevel::eSecondary,
+            .commandBufferCount = 4,
+        });
+        if(acbRes != vk::Result::eSuccess)
+            return acbRes;
+
+        threadPool.secondaries.insert(
+            threadPool.secondaries.end(),
+            commandBuffers.begin(),
+            commandBuffers.end());
+    }
+
+    commandBuffer = threadPool.secondaries[threadPool.usedSecondaries++];
+    return vk::Result::eSuccess;
+}
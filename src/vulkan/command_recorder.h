@@ -0,0 +1,89 @@
+#pragma once
+
+#include <functional>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../job_system.h"
+
+/**
+ * @brief Records a frame's secondary command buffers on the JobSystem's threads.
+ *
+ * There is one CommandRecorder per frame in flight (see FrameContext), and every job thread has its
+ * own transient command pool in it, so no pool is ever touched by two threads. All of a frame's
+ * command buffers are reset with one `resetCommandPool` per pool in `reset` instead of one reset
+ * per buffer.
+ */
+class CommandRecorder
+{
+  public:
+    class Builder
+    {
+        using Self = Builder;
+
+      public:
+        Builder(const vk::UniqueDevice&);
+
+        Self& usingJobSystem(JobSystem&);
+        Self& withQueueFamily(uint32_t);
+
+        std::variant<CommandRecorder, vk::Result> build() const;
+
+      private:
+        const vk::UniqueDevice& device;
+        JobSystem* jobSystem;
+
+        uint32_t queueFamilyIndex;
+    };
+
+    // Called once per task, possibly from several threads at once. `commandBuffer` is already
+    // begun and is ended after the function returns
+    using RecordFunction = std::function<void(vk::CommandBuffer commandBuffer, uint32_t task)>;
+
+    /**
+     * @brief Resets every command pool. The GPU must be done with the previous submission
+     */
+    vk::Result reset();
+
+    // In the initial state after `reset`
+    vk::CommandBuffer primary() const;
+
+    /**
+     * @brief Records `taskCount` secondary command buffers in parallel, continuing the render pass
+     * described by `inheritance`, and executes them from the primary command buffer in task order.
+     *
+     * The primary command buffer must be inside a render pass begun with
+     * vk::SubpassContents::eSecondaryCommandBuffers.
+     */
+    vk::Result recordParallel(
+        const vk::CommandBufferInheritanceInfo& inheritance,
+        uint32_t taskCount,
+        const RecordFunction& record);
+
+  private:
+    struct ThreadPool
+    {
+        vk::UniqueCommandPool pool;
+        // Owned by `pool`, reused after every reset
+        std::vector<vk::CommandBuffer> secondaries;
+        uint32_t usedSecondaries;
+    };
+
+    CommandRecorder(
+        vk::Device device,
+        JobSystem& jobSystem,
+        std::vector<ThreadPool>&& pools,
+        vk::CommandBuffer primaryCommandBuffer);
+
+    vk::Device device;
+    JobSystem* jobSystem;
+
+    // Indexed by JobSystem::currentThreadIndex
+    std::vector<ThreadPool> pools;
+    vk::CommandBuffer primaryCommandBuffer;
+    std::vector<vk::CommandBuffer> recorded;
+    std::vector<vk::Result> results;
+
+    vk::Result acquireSecondary(ThreadPool& threadPool, vk::CommandBuffer& commandBuffer);
+};
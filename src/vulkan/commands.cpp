@@ -0,0 +1,106 @@
+#include "commands.h"
+
+#include <array>
+#include <cassert>
+
+namespace
+{
+    struct LayoutUsage
+    {
+        vk::PipelineStageFlags stages;
+        vk::AccessFlags access;
+    };
+
+    LayoutUsage layoutUsage(vk::ImageLayout layout)
+    {
+        switch(layout)
+        {
+            case vk::ImageLayout::eUndefined:
+                return {vk::PipelineStageFlagBits::eTopOfPipe, vk::AccessFlags()};
+            case vk::ImageLayout::eTransferDstOptimal:
+                return {vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite};
+            case vk::ImageLayout::eTransferSrcOptimal:
+                return {vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead};
+            // Every stage BindlessDescriptors exposes its textures to
+            case vk::ImageLayout::eShaderReadOnlyOptimal:
+                return {
+                    vk::PipelineStageFlagBits::eVertexShader
+                        | vk::PipelineStageFlagBits::eFragmentShader
+                        | vk::PipelineStageFlagBits::eComputeShader,
+                    vk::AccessFlagBits::eShaderRead};
+            case vk::ImageLayout::eGeneral:
+                return {
+                    vk::PipelineStageFlagBits::eComputeShader,
+                    vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite};
+            case vk::ImageLayout::eColorAttachmentOptimal:
+                return {
+                    vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                    vk::AccessFlagBits::eColorAttachmentRead
+                        | vk::AccessFlagBits::eColorAttachmentWrite};
+            case vk::ImageLayout::ePresentSrcKHR:
+                return {vk::PipelineStageFlagBits::eBottomOfPipe, vk::AccessFlags()};
+            default:
+                // Correct for anything, just slow
+                return {
+                    vk::PipelineStageFlagBits::eAllCommands,
+                    vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite};
+        }
+    }
+}
+
+namespace Commands
+{
+    void bindVertexStreams(
+        vk::CommandBuffer commandBuffer,
+        std::span<const VertexStream> streams,
+        uint32_t firstBinding)
+    {
+        assert(streams.size() <= MaxVertexStreams);
+
+        std::array<vk::Buffer, MaxVertexStreams> buffers;
+        std::array<vk::DeviceSize, MaxVertexStreams> offsets;
+        for(size_t i = 0; i < streams.size(); ++i)
+        {
+            buffers[i] = streams[i].buffer;
+            offsets[i] = streams[i].offset;
+        }
+
+        commandBuffer.bindVertexBuffers(
+            firstBinding,
+            (uint32_t)streams.size(),
+            buffers.data(),
+            offsets.data());
+    }
+
+    void transitionImageLayout(
+        vk::CommandBuffer commandBuffer,
+        vk::Image image,
+        vk::ImageLayout oldLayout,
+        vk::ImageLayout newLayout,
+        const vk::ImageSubresourceRange& subresources)
+    {
+        LayoutUsage before = layoutUsage(oldLayout);
+        LayoutUsage after = layoutUsage(newLayout);
+
+        vk::ImageMemoryBarrier barrier = {
+            .srcAccessMask = before.access,
+            .dstAccessMask = after.access,
+            .oldLayout = oldLayout,
+            .newLayout = newLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = subresources,
+        };
+        commandBuffer.pipelineBarrier(
+            before.stages,
+            after.stages,
+            vk::DependencyFlags(),
+            0,
+            nullptr,
+            0,
+            nullptr,
+            1,
+            &barrier);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <span>
+#include <type_traits>
+#include <vulkan/vulkan.hpp>
+
+/**
+ * @brief Small wrappers for recording commands that take parallel arrays in Vulkan
+ */
+namespace Commands
+{
+    struct VertexStream
+    {
+        vk::Buffer buffer;
+        vk::DeviceSize offset;
+    };
+
+    // Vulkan guarantees at least this many bindings
+    constexpr uint32_t MaxVertexStreams = 16;
+
+    /**
+     * @brief Binds `streams` to consecutive bindings starting at `firstBinding` with a single
+     * vkCmdBindVertexBuffers, matching the streams added with PipelineBuilder::withVertexStream
+     */
+    void bindVertexStreams(
+        vk::CommandBuffer commandBuffer,
+        std::span<const VertexStream> streams,
+        uint32_t firstBinding = 0);
+
+    /**
+     * @brief Pushes `constants` at `offset`, e.g. the whole struct a range was declared with
+     * through PipelineBuilder::withPushConstants<T> or a single member of it at its offsetof.
+     * `stages` has to be the stages of that range
+     */
+    template<typename T>
+    void pushConstants(
+        vk::CommandBuffer commandBuffer,
+        vk::PipelineLayout layout,
+        vk::ShaderStageFlags stages,
+        const T& constants,
+        uint32_t offset = 0)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(sizeof(T) % 4 == 0, "Push constant sizes are multiples of 4");
+        commandBuffer.pushConstants(layout, stages, offset, sizeof(T), &constants);
+    }
+
+    /**
+     * @brief Records an image barrier from `oldLayout` to `newLayout` with the stages and accesses
+     * that go with each layout: transfers for the transfer layouts, fragment and compute shader
+     * reads for ShaderReadOnlyOptimal and compute shader storage access for General
+     */
+    void transitionImageLayout(
+        vk::CommandBuffer commandBuffer,
+        vk::Image image,
+        vk::ImageLayout oldLayout,
+        vk::ImageLayout newLayout,
+        const vk::ImageSubresourceRange& subresources);
+}
@@ -0,0 +1,52 @@
+#include "deletion_queue.h"
+
+DeletionQueue::DeletionQueue(GpuTimeline& timeline, JobSystem* jobSystem)
+    : timeline(timeline)
+    , jobSystem(jobSystem)
+{
+}
+
+DeletionQueue::~DeletionQueue()
+{
+    flush();
+}
+
+void DeletionQueue::collect()
+{
+    std::vector<Entry> batch;
+    for(Entry& entry : entries)
+    {
+        if(timeline.isComplete(entry.timelineValue))
+            batch.push_back(std::move(entry));
+    }
+    if(batch.empty())
+        return;
+
+    std::erase_if(entries, [](const Entry& entry) { return !entry.object; });
+    destroy(std::move(batch));
+}
+
+void DeletionQueue::flush()
+{
+    if(jobSystem)
+        jobSystem->wait(destroying);
+    entries.clear();
+}
+
+size_t DeletionQueue::getPendingCount() const
+{
+    return entries.size();
+}
+
+void DeletionQueue::destroy(std::vector<Entry>&& batch)
+{
+    if(!jobSystem)
+    {
+        batch.clear();
+        return;
+    }
+
+    // Jobs have to be copyable
+    auto shared = std::make_shared<std::vector<Entry>>(std::move(batch));
+    jobSystem->run([shared]() { shared->clear(); }, &destroying);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "../job_system.h"
+#include "gpu_timeline.h"
+
+/**
+ * @brief Holds on to objects the GPU might still be using and destroys them once the GpuTimeline
+ * has passed the value that last used them.
+ *
+ * Anything movable can be retired: vk::Unique* handles, a Buffer, a whole swapchain config. With a
+ * JobSystem the destruction of each batch happens on a job instead of on the calling thread. Only
+ * retire objects that can be destroyed from any thread, i.e. not command buffers whose pool is
+ * still in use.
+ */
+class DeletionQueue
+{
+  public:
+    // `jobSystem` is optional
+    DeletionQueue(GpuTimeline& timeline, JobSystem* jobSystem = nullptr);
+    // Destroys everything that is left, so the device must be idle by then
+    ~DeletionQueue();
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+    template<typename T>
+    void retire(T&& object, uint64_t timelineValue)
+    {
+        entries.push_back(Entry{
+            .timelineValue = timelineValue,
+            .object = std::make_unique<Holder<std::decay_t<T>>>(std::forward<T>(object)),
+        });
+    }
+
+    // Retires `object` until everything submitted so far has completed
+    template<typename T>
+    void retire(T&& object)
+    {
+        retire(std::forward<T>(object), timeline.getLastSubmitted());
+    }
+
+    // Destroys everything whose timeline value has completed. Call once per frame
+    void collect();
+    // Destroys everything right away. The device must be idle
+    void flush();
+
+    size_t getPendingCount() const;
+
+  private:
+    struct HolderBase
+    {
+        virtual ~HolderBase() = default;
+    };
+
+    template<typename T>
+    struct Holder : HolderBase
+    {
+        template<typename U>
+        Holder(U&& object)
+            : object(std::forward<U>(object))
+        {
+        }
+
+        T object;
+    };
+
+    struct Entry
+    {
+        uint64_t timelineValue;
+        std::unique_ptr<HolderBase> object;
+    };
+
+    void destroy(std::vector<Entry>&& batch);
+
+    GpuTimeline& timeline;
+    JobSystem* jobSystem;
+    // Background destruction jobs that haven't finished yet
+    JobSystem::Counter destroying;
+
+    std::vector<Entry> entries;
+};
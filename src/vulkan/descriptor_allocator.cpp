@@ -0,0 +1,116 @@
+#include "descriptor_allocator.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    struct PoolRatio
+    {
+        vk::DescriptorType type;
+        // Descriptors of `type` per set. Sets that need more of one type just fill a pool sooner
+        uint32_t perSet;
+    };
+
+    // Every type DescriptorCache can write
+    constexpr std::array<PoolRatio, 9> PoolRatios = {{
+        {vk::DescriptorType::eSampler, 1},
+        {vk::DescriptorType::eCombinedImageSampler, 4},
+        {vk::DescriptorType::eSampledImage, 2},
+        {vk::DescriptorType::eStorageImage, 1},
+        {vk::DescriptorType::eInputAttachment, 1},
+        {vk::DescriptorType::eUniformBuffer, 2},
+        {vk::DescriptorType::eUniformBufferDynamic, 1},
+        {vk::DescriptorType::eStorageBuffer, 2},
+        {vk::DescriptorType::eStorageBufferDynamic, 1},
+    }};
+}
+
+DescriptorAllocator::DescriptorAllocator(vk::Device device, uint32_t setsPerPool)
+    : device(device)
+    , setsPerPool(std::max(setsPerPool, 1u))
+    , currentPoolUsed(false)
+{
+}
+
+std::variant<vk::DescriptorSet, vk::Result> DescriptorAllocator::allocate(
+    vk::DescriptorSetLayout layout)
+{
+    if(usedPools.empty())
+    {
+        vk::Result res = nextPool();
+        if(res != vk::Result::eSuccess)
+            return res;
+    }
+
+    vk::DescriptorSetAllocateInfo allocateInfo = {
+        .descriptorPool = usedPools.back().get(),
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+    vk::DescriptorSet set;
+    vk::Result adsRes = device.allocateDescriptorSets(&allocateInfo, &set);
+    // A set that doesn't fit into an empty pool won't fit into the next one either, so only
+    // move on from pools that have handed out sets
+    if((adsRes == vk::Result::eErrorOutOfPoolMemory || adsRes == vk::Result::eErrorFragmentedPool)
+       && currentPoolUsed)
+    {
+        vk::Result res = nextPool();
+        if(res != vk::Result::eSuccess)
+            return res;
+        allocateInfo.descriptorPool = usedPools.back().get();
+        adsRes = device.allocateDescriptorSets(&allocateInfo, &set);
+    }
+    if(adsRes != vk::Result::eSuccess)
+        return adsRes;
+    currentPoolUsed = true;
+    return set;
+}
+
+void DescriptorAllocator::reset()
+{
+    for(vk::UniqueDescriptorPool& pool : usedPools)
+    {
+        // Can't fail, newer vulkan.hpp versions return void here
+        (void)device.resetDescriptorPool(pool.get());
+        freePools.push_back(std::move(pool));
+    }
+    usedPools.clear();
+}
+
+uint32_t DescriptorAllocator::getPoolCount() const
+{
+    return (uint32_t)(usedPools.size() + freePools.size());
+}
+
+vk::Result DescriptorAllocator::nextPool()
+{
+    if(!freePools.empty())
+    {
+        usedPools.push_back(std::move(freePools.back()));
+        freePools.pop_back();
+        currentPoolUsed = false;
+        return vk::Result::eSuccess;
+    }
+
+    std::array<vk::DescriptorPoolSize, PoolRatios.size()> poolSizes;
+    for(size_t i = 0; i < PoolRatios.size(); ++i)
+    {
+        poolSizes[i] = vk::DescriptorPoolSize{
+            .type = PoolRatios[i].type,
+            .descriptorCount = PoolRatios[i].perSet * setsPerPool,
+        };
+    }
+    auto [cdpRes, pool] = device.createDescriptorPoolUnique({
+        .maxSets = setsPerPool,
+        .poolSizeCount = (uint32_t)poolSizes.size(),
+        .pPoolSizes = poolSizes.data(),
+    });
+    if(cdpRes != vk::Result::eSuccess)
+        return cdpRes;
+
+    usedPools.push_back(std::move(pool));
+    currentPoolUsed = false;
+    setsPerPool = std::min(setsPerPool * 2, MaxSetsPerPool);
+    return vk::Result::eSuccess;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+/**
+ * @brief Allocates descriptor sets from pools that are only ever reset as a whole.
+ *
+ * Sets come from the current pool until it runs out, then from a recycled pool or a new one that
+ * is twice as big as the last, up to MaxSetsPerPool. The pools are created without
+ * FREE_DESCRIPTOR_SET, so the driver can hand out sets by bumping an offset, and `reset` frees
+ * everything with one vkResetDescriptorPool per pool used since the last reset while keeping the
+ * pools for reuse.
+ *
+ * There is one per frame in flight in FrameContext for sets that only live for a frame, such as the
+ * ones of MipGenerator's compute path, and DescriptorCache keeps one for sets that are never freed.
+ * Not thread safe.
+ */
+class DescriptorAllocator
+{
+  public:
+    static constexpr uint32_t DefaultSetsPerPool = 64;
+    static constexpr uint32_t MaxSetsPerPool = 4096;
+
+    DescriptorAllocator(vk::Device device, uint32_t setsPerPool = DefaultSetsPerPool);
+
+    std::variant<vk::DescriptorSet, vk::Result> allocate(vk::DescriptorSetLayout layout);
+
+    // Frees every set allocated so far. None of them may still be in use by the GPU
+    void reset();
+
+    uint32_t getPoolCount() const;
+
+  private:
+    vk::Device device;
+    // Size of the next pool that has to be created
+    uint32_t setsPerPool;
+    // Whether the last of usedPools has handed out any sets
+    bool currentPoolUsed;
+    // The last one is the one sets are allocated from
+    std::vector<vk::UniqueDescriptorPool> usedPools;
+    std::vector<vk::UniqueDescriptorPool> freePools;
+
+    // Makes a recycled or new pool the current one
+    vk::Result nextPool();
+};
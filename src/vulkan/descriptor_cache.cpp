@@ -0,0 +1,165 @@
+#include "descriptor_cache.h"
+
+#include <cassert>
+
+namespace
+{
+    bool isImageDescriptor(vk::DescriptorType type)
+    {
+        return type == vk::DescriptorType::eSampler
+               || type == vk::DescriptorType::eCombinedImageSampler
+               || type == vk::DescriptorType::eSampledImage
+               || type == vk::DescriptorType::eStorageImage
+               || type == vk::DescriptorType::eInputAttachment;
+    }
+
+    bool isBufferDescriptor(vk::DescriptorType type)
+    {
+        return type == vk::DescriptorType::eUniformBuffer
+               || type == vk::DescriptorType::eUniformBufferDynamic
+               || type == vk::DescriptorType::eStorageBuffer
+               || type == vk::DescriptorType::eStorageBufferDynamic;
+    }
+
+    template<typename Handle>
+    uint64_t handleBits(Handle handle)
+    {
+        return (uint64_t)(typename Handle::CType)handle;
+    }
+
+    // FNV-1a over the values that make a binding unique
+    class Hasher
+    {
+      public:
+        void add(uint64_t value)
+        {
+            for(int i = 0; i < 8; ++i)
+            {
+                hash ^= (value >> (i * 8)) & 0xFF;
+                hash *= 0x100000001B3;
+            }
+        }
+
+        uint64_t get() const
+        {
+            return hash;
+        }
+
+      private:
+        uint64_t hash = 0xCBF29CE484222325;
+    };
+}
+
+using Bindings = DescriptorCache::Bindings;
+
+Bindings& Bindings::withImage(
+    uint32_t binding,
+    vk::DescriptorType type,
+    vk::ImageView view,
+    vk::Sampler sampler,
+    vk::ImageLayout layout)
+{
+    assert(isImageDescriptor(type));
+    bindings.push_back({
+        .binding = binding,
+        .type = type,
+        .image = {.sampler = sampler, .imageView = view, .imageLayout = layout},
+        .buffer = {},
+    });
+    return *this;
+}
+
+Bindings& Bindings::withBuffer(
+    uint32_t binding,
+    vk::DescriptorType type,
+    vk::Buffer buffer,
+    vk::DeviceSize offset,
+    vk::DeviceSize range)
+{
+    assert(isBufferDescriptor(type));
+    bindings.push_back({
+        .binding = binding,
+        .type = type,
+        .image = {},
+        .buffer = {.buffer = buffer, .offset = offset, .range = range},
+    });
+    return *this;
+}
+
+DescriptorCache::DescriptorCache(vk::Device device)
+    : device(device)
+    , allocator(device)
+    , setCount(0)
+{
+}
+
+std::variant<vk::DescriptorSet, vk::Result> DescriptorCache::get(
+    vk::DescriptorSetLayout layout,
+    const Bindings& bindings)
+{
+    Hasher hasher;
+    hasher.add(handleBits(layout));
+    for(const Bindings::Binding& binding : bindings.bindings)
+    {
+        hasher.add(binding.binding);
+        hasher.add((uint64_t)binding.type);
+        if(isImageDescriptor(binding.type))
+        {
+            hasher.add(handleBits(binding.image.imageView));
+            hasher.add(handleBits(binding.image.sampler));
+            hasher.add((uint64_t)binding.image.imageLayout);
+        }
+        else
+        {
+            hasher.add(handleBits(binding.buffer.buffer));
+            hasher.add(binding.buffer.offset);
+            hasher.add(binding.buffer.range);
+        }
+    }
+
+    std::vector<Entry>& bucket = entries[hasher.get()];
+    for(const Entry& entry : bucket)
+    {
+        if(entry.layout == layout && entry.bindings == bindings.bindings)
+            return entry.set;
+    }
+
+    auto setVar = allocator.allocate(layout);
+    if(std::holds_alternative<vk::Result>(setVar))
+        return std::get<vk::Result>(setVar);
+    vk::DescriptorSet set = std::get<vk::DescriptorSet>(setVar);
+
+    std::vector<vk::WriteDescriptorSet> writes;
+    writes.reserve(bindings.bindings.size());
+    for(const Bindings::Binding& binding : bindings.bindings)
+    {
+        bool image = isImageDescriptor(binding.type);
+        writes.push_back({
+            .dstSet = set,
+            .dstBinding = binding.binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = binding.type,
+            .pImageInfo = image ? &binding.image : nullptr,
+            .pBufferInfo = image ? nullptr : &binding.buffer,
+            .pTexelBufferView = nullptr,
+        });
+    }
+    device.updateDescriptorSets((uint32_t)writes.size(), writes.data(), 0, nullptr);
+
+    bucket.push_back({.layout = layout, .bindings = bindings.bindings, .set = set});
+    setCount++;
+    return set;
+}
+
+void DescriptorCache::clear()
+{
+    entries.clear();
+    allocator.reset();
+    setCount = 0;
+}
+
+size_t DescriptorCache::getSetCount() const
+{
+    return setCount;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "descriptor_allocator.h"
+
+/**
+ * @brief Descriptor sets that are written once and shared by everything that binds the same
+ * resources with the same layout, e.g. the textures and uniform buffer of a material.
+ *
+ * `get` looks the layout and bindings up and only allocates and writes a set the first time it sees
+ * them, so repeated requests cost a hash and a compare. Cached sets live until `clear`, which means
+ * the resources they reference have to outlive the cache or be cleared out of it once the GPU is
+ * done with them.
+ */
+class DescriptorCache
+{
+  public:
+    // One descriptor per binding, in the order they are written. Texel buffers aren't supported
+    class Bindings
+    {
+        using Self = Bindings&;
+
+      public:
+        Self withImage(
+            uint32_t binding,
+            vk::DescriptorType type,
+            vk::ImageView view,
+            vk::Sampler sampler,
+            vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+        Self withBuffer(
+            uint32_t binding,
+            vk::DescriptorType type,
+            vk::Buffer buffer,
+            vk::DeviceSize offset = 0,
+            vk::DeviceSize range = VK_WHOLE_SIZE);
+
+      private:
+        friend class DescriptorCache;
+
+        struct Binding
+        {
+            uint32_t binding;
+            vk::DescriptorType type;
+            // Only the one that matches `type` is used
+            vk::DescriptorImageInfo image;
+            vk::DescriptorBufferInfo buffer;
+
+            bool operator==(const Binding&) const = default;
+        };
+
+        std::vector<Binding> bindings;
+    };
+
+    DescriptorCache(vk::Device device);
+
+    std::variant<vk::DescriptorSet, vk::Result> get(
+        vk::DescriptorSetLayout layout,
+        const Bindings& bindings);
+
+    // Frees every cached set. None of them may still be in use by the GPU
+    void clear();
+
+    size_t getSetCount() const;
+
+  private:
+    struct Entry
+    {
+        vk::DescriptorSetLayout layout;
+        std::vector<Bindings::Binding> bindings;
+        vk::DescriptorSet set;
+    };
+
+    vk::Device device;
+    DescriptorAllocator allocator;
+    // Keyed by the hash of layout and bindings, with every entry that has that hash
+    std::unordered_map<uint64_t, std::vector<Entry>> entries;
+    size_t setCount;
+};
@@ -1,8 +1,13 @@
 
 #include "device_builder.h"
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <type_traits>
 #include <utility>
 
 #include "../stl_utils.h"
+#include "dispatch.h"
 
 struct ValidatedExtension
 {
@@ -26,11 +31,46 @@ vk::Result visitExtensionProperties(
     return vk::Result::eSuccess;
 }
 
+// Where the last VkBool32 of each feature struct ends. sizeof would include the tail padding
+template<typename Features>
+constexpr size_t FeaturesEnd = 0;
+template<>
+constexpr size_t FeaturesEnd<vk::PhysicalDeviceVulkan12Features> =
+    offsetof(vk::PhysicalDeviceVulkan12Features, subgroupBroadcastDynamicId) + sizeof(vk::Bool32);
+
+// The feature structs are an sType, a pNext and nothing but VkBool32s after that
+template<typename Features>
+auto featureBools(Features& features)
+{
+    using Plain = std::remove_const_t<Features>;
+    using Bool = std::conditional_t<std::is_const_v<Features>, const vk::Bool32, vk::Bool32>;
+    static_assert(FeaturesEnd<Plain> != 0, "FeaturesEnd is missing for this struct");
+    constexpr size_t offset = offsetof(Plain, pNext) + sizeof(void*);
+    constexpr size_t count = (FeaturesEnd<Plain> - offset) / sizeof(vk::Bool32);
+    return std::span<Bool>((Bool*)((char*)&features + offset), count);
+}
+
+template<typename Features>
+bool supportsFeatures(const Features& required, const Features& supported)
+{
+    auto requiredBools = featureBools(required);
+    auto supportedBools = featureBools(supported);
+    for(size_t i = 0; i < requiredBools.size(); ++i)
+    {
+        if(requiredBools[i] && !supportedBools[i])
+            return false;
+    }
+    return true;
+}
+
 DeviceBuilder::DeviceBuilder(
     const vk::UniqueInstance& instance,
     const vk::UniqueSurfaceKHR& surface)
     : instance(instance)
     , surface(surface)
+    , requiredFeatures12()
+    , presentWait(false)
+    , textureCompression(false)
 {
 }
 
@@ -61,6 +101,39 @@ DeviceBuilder& DeviceBuilder::withRequiredExtension(const char* name)
     return *this;
 }
 
+DeviceBuilder& DeviceBuilder::withOptionalExtension(const char* name)
+{
+    optionalExtensions.push_back(name);
+    return *this;
+}
+
+DeviceBuilder& DeviceBuilder::withOptionalPresentWait()
+{
+    optionalExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+    optionalExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    presentWait = true;
+    return *this;
+}
+
+DeviceBuilder& DeviceBuilder::withOptionalTextureCompression()
+{
+    textureCompression = true;
+    return *this;
+}
+
+DeviceBuilder& DeviceBuilder::withRequiredVulkan12Features(
+    const vk::PhysicalDeviceVulkan12Features& features)
+{
+    auto requiredBools = featureBools(requiredFeatures12);
+    auto bools = featureBools(features);
+    for(size_t i = 0; i < bools.size(); ++i)
+    {
+        if(bools[i])
+            requiredBools[i] = VK_TRUE;
+    }
+    return *this;
+}
+
 std::optional<DeviceBuilder::Error> DeviceBuilder::build(SelectedConfig& config)
 {
     Error error = {};
@@ -101,6 +174,20 @@ std::optional<DeviceBuilder::Error> DeviceBuilder::build(SelectedConfig& config)
             if(!hasSwapchainSupport)
                 continue;
 
+            if(physicalDevice.getProperties().apiVersion < VK_API_VERSION_1_2)
+                continue;
+
+            vk::PhysicalDeviceVulkan12Features supportedFeatures12 = {};
+            vk::PhysicalDeviceFeatures2 supportedFeatures = {.pNext = &supportedFeatures12};
+            physicalDevice.getFeatures2(&supportedFeatures);
+            if(!supportsFeatures(requiredFeatures12, supportedFeatures12))
+                continue;
+            // Descriptor indexing is used with indices from push constants, see below
+            if(requiredFeatures12.descriptorIndexing
+               && (!supportedFeatures.features.shaderSampledImageArrayDynamicIndexing
+                   || !supportedFeatures.features.shaderStorageBufferArrayDynamicIndexing))
+                continue;
+
             if(deviceSelector)
             {
                 auto resultVar = deviceSelector(physicalDeviceOpt, physicalDevice);
@@ -269,14 +356,72 @@ std::optional<DeviceBuilder::Error> DeviceBuilder::build(SelectedConfig& config)
         .pQueuePriorities = &queuePriority,
     };
 
+    std::vector<const char*> enabledExtensions = requiredExtensions;
+    auto hasExtension = [&enabledExtensions](const char* name) {
+        return std::any_of(entire_collection(enabledExtensions), [name](const char* enabled) {
+            return std::strcmp(enabled, name) == 0;
+        });
+    };
+    auto veRes = visitExtensionProperties(
+        physicalDevice,
+        [this, &enabledExtensions, &hasExtension](vk::ExtensionProperties prop) {
+            for(const char* name : optionalExtensions)
+            {
+                if(std::strcmp(name, prop.extensionName) == 0 && !hasExtension(name))
+                    enabledExtensions.push_back(name);
+            }
+        });
+    if(veRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::Fatal;
+        error.Fatal.result = veRes;
+        error.Fatal.message = "Error during extension selection";
+        return error;
+    }
+
+    vk::PhysicalDeviceVulkan12Features enabledFeatures12 = requiredFeatures12;
+    enabledFeatures12.pNext = nullptr;
+
+    vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+    vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+    bool enablePresentWait = presentWait && hasExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME)
+                             && hasExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    if(enablePresentWait)
+    {
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        vk::PhysicalDeviceFeatures2 supportedFeatures = {.pNext = &presentIdFeatures};
+        physicalDevice.getFeatures2(&supportedFeatures);
+
+        enablePresentWait = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+        if(enablePresentWait)
+            enabledFeatures12.pNext = &presentIdFeatures;
+    }
+
+    vk::PhysicalDeviceFeatures enabledFeatures = {};
+    vk::PhysicalDeviceFeatures supportedFeatures = physicalDevice.getFeatures();
+    if(textureCompression)
+    {
+        enabledFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+        enabledFeatures.textureCompressionETC2 = supportedFeatures.textureCompressionETC2;
+        enabledFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+    }
+    // Descriptor indexing is mostly used with indices from push constants, which needs these.
+    // Devices without them were skipped during selection
+    if(requiredFeatures12.descriptorIndexing)
+    {
+        enabledFeatures.shaderSampledImageArrayDynamicIndexing = true;
+        enabledFeatures.shaderStorageBufferArrayDynamicIndexing = true;
+    }
+
     vk::DeviceCreateInfo deviceCreateInfo = {
+        .pNext = &enabledFeatures12,
         .queueCreateInfoCount = 1,
         .pQueueCreateInfos = &queueInfo,
         .enabledLayerCount = 0,
         .ppEnabledLayerNames = nullptr,
-        .enabledExtensionCount = (uint32_t)requiredExtensions.size(),
-        .ppEnabledExtensionNames = requiredExtensions.data(),
-        .pEnabledFeatures = nullptr,
+        .enabledExtensionCount = (uint32_t)enabledExtensions.size(),
+        .ppEnabledExtensionNames = enabledExtensions.data(),
+        .pEnabledFeatures = &enabledFeatures,
     };
 
     auto [cdRes, device] = physicalDevice.createDeviceUnique(deviceCreateInfo);
@@ -287,10 +432,15 @@ std::optional<DeviceBuilder::Error> DeviceBuilder::build(SelectedConfig& config)
         return error;
     }
 
+    Dispatch::initDevice(device.get());
     config.device = std::move(device);
     config.queues.workQueueInfo.index = queueFamilyPropertiesIndex;
     config.queues.workQueueInfo.properties = queueFamilyProperties;
     config.physicalDevice = physicalDevice;
+    config.deviceFeatures.presentWait = enablePresentWait;
+    config.deviceFeatures.textureCompressionBC = enabledFeatures.textureCompressionBC;
+    config.deviceFeatures.textureCompressionETC2 = enabledFeatures.textureCompressionETC2;
+    config.deviceFeatures.textureCompressionASTC = enabledFeatures.textureCompressionASTC_LDR;
 
     return std::nullopt;
 }
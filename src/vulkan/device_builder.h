@@ -67,6 +67,17 @@ class DeviceBuilder
     DeviceBuilder& selectQueueFamily(QueueFamilySelector selector);
 
     DeviceBuilder& withRequiredExtension(const char* name);
+    // Devices that don't support every enabled feature in `features` are skipped. Requires a
+    // Vulkan 1.2 instance. descriptorIndexing also requires the dynamic indexing features of
+    // sampled image and storage buffer arrays
+    DeviceBuilder& withRequiredVulkan12Features(const vk::PhysicalDeviceVulkan12Features& features);
+    // Enabled if the selected device supports it, but doesn't affect device selection
+    DeviceBuilder& withOptionalExtension(const char* name);
+    // VK_KHR_present_id + VK_KHR_present_wait and their features. Whether they ended up enabled
+    // is stored in SelectedConfig::deviceFeatures
+    DeviceBuilder& withOptionalPresentWait();
+    // Enables BC, ETC2 and ASTC LDR sampling where supported, see SelectedConfig::deviceFeatures
+    DeviceBuilder& withOptionalTextureCompression();
 
     std::optional<Error> build(SelectedConfig&);
 
@@ -75,6 +86,10 @@ class DeviceBuilder
     const vk::UniqueSurfaceKHR& surface;
 
     std::vector<const char*> requiredExtensions;
+    std::vector<const char*> optionalExtensions;
+    vk::PhysicalDeviceVulkan12Features requiredFeatures12;
+    bool presentWait;
+    bool textureCompression;
 
     DeviceSelector deviceSelector;
     DeviceSelectorAfterFiltering gpuSelector;
@@ -0,0 +1,21 @@
+#include "dispatch.h"
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace Dispatch
+{
+    void initLoader()
+    {
+        VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+    }
+
+    void initInstance(vk::Instance instance)
+    {
+        VULKAN_HPP_DEFAULT_DISPATCHER.init(instance);
+    }
+
+    void initDevice(vk::Device device)
+    {
+        VULKAN_HPP_DEFAULT_DISPATCHER.init(device);
+    }
+}
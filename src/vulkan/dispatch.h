@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+/**
+ * All vulkan.hpp calls go through VULKAN_HPP_DEFAULT_DISPATCHER (VULKAN_HPP_DISPATCH_LOADER_DYNAMIC
+ * is set in CMakeLists.txt). Once `initDevice` has been called, every device, queue and command
+ * buffer function points straight into the driver instead of through the loader's trampolines.
+ *
+ * Only one device is supported since the dispatcher is global.
+ */
+namespace Dispatch
+{
+    // Global functions such as vkCreateInstance. Called by InstanceBuilder::build
+    void initLoader();
+    // Instance functions, including extensions like VK_EXT_debug_utils. Called by
+    // InstanceBuilder::build
+    void initInstance(vk::Instance instance);
+    // Device functions, resolved with vkGetDeviceProcAddr. Called by DeviceBuilder::build
+    void initDevice(vk::Device device);
+}
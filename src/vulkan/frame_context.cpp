@@ -0,0 +1,163 @@
+#include "frame_context.h"
+
+#include <algorithm>
+#include <cassert>
+
+using Builder = FrameContext::Builder;
+
+Builder::Builder(const vk::UniqueDevice& device)
+    : device(device)
+    , jobSystem(nullptr)
+    , queueFamilyIndex(0)
+    , transientBufferSize(0)
+    , memoryProperties()
+    , timestampValidBits(0)
+{
+}
+
+Builder& Builder::usingJobSystem(JobSystem& jobSystem)
+{
+    this->jobSystem = &jobSystem;
+    return *this;
+}
+
+Builder& Builder::withQueueFamily(uint32_t index)
+{
+    this->queueFamilyIndex = index;
+    return *this;
+}
+
+Builder& Builder::withTransientBufferSize(
+    uint32_t size,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties)
+{
+    this->transientBufferSize = size;
+    this->memoryProperties = memoryProperties;
+    return *this;
+}
+
+Builder& Builder::withGpuTimer(float timestampPeriod, uint32_t timestampValidBits)
+{
+    if(timestampValidBits != 0)
+        this->timestampPeriod = timestampPeriod;
+    this->timestampValidBits = timestampValidBits;
+    return *this;
+}
+
+std::variant<FrameContext, Builder::Error> Builder::build() const
+{
+    assert(jobSystem);
+    Error error = {};
+
+    auto recorderVar = CommandRecorder::Builder(device)
+                           .usingJobSystem(*jobSystem)
+                           .withQueueFamily(queueFamilyIndex)
+                           .build();
+    if(std::holds_alternative<vk::Result>(recorderVar))
+    {
+        error.type = ErrorType::CreateCommandRecorder;
+        error.CreateCommandRecorder.result = std::get<vk::Result>(recorderVar);
+        return error;
+    }
+
+    // Vulkan doesn't allow 0-sized buffers
+    auto transientVar =
+        TransientBuffer::create(device, std::max(transientBufferSize, 1u), memoryProperties);
+    if(std::holds_alternative<Buffer::Builder::Error>(transientVar))
+    {
+        error.type = ErrorType::CreateTransientBuffer;
+        error.CreateTransientBuffer.error = std::get<Buffer::Builder::Error>(transientVar);
+        return error;
+    }
+
+    auto [csRes, imageAvailable] = device->createSemaphoreUnique({});
+    if(csRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::CreateSync;
+        error.CreateSync.result = csRes;
+        return error;
+    }
+
+    vk::UniqueQueryPool timestampQueries;
+    if(timestampPeriod.has_value())
+    {
+        auto [cqpRes, queryPool] = device->createQueryPoolUnique({
+            .queryType = vk::QueryType::eTimestamp,
+            .queryCount = 2,
+        });
+        if(cqpRes != vk::Result::eSuccess)
+        {
+            error.type = ErrorType::CreateQueryPool;
+            error.CreateQueryPool.result = cqpRes;
+            return error;
+        }
+        timestampQueries = std::move(queryPool);
+    }
+
+    return FrameContext{
+        .commandRecorder = std::get<CommandRecorder>(std::move(recorderVar)),
+        .transientBuffer = std::get<TransientBuffer>(std::move(transientVar)),
+        .descriptorAllocator = DescriptorAllocator(device.get()),
+        .imageAvailable = std::move(imageAvailable),
+        .timelineValue = 0,
+        .device = device.get(),
+        .timestampQueries = std::move(timestampQueries),
+        .timestampPeriod = timestampPeriod.value_or(0.0f),
+        .timestampMask =
+            timestampValidBits >= 64 ? UINT64_MAX : ((uint64_t)1 << timestampValidBits) - 1,
+        .timestampsWritten = false,
+    };
+}
+
+vk::Result FrameContext::reset()
+{
+    transientBuffer.reset();
+    descriptorAllocator.reset();
+    return commandRecorder.reset();
+}
+
+void FrameContext::beginGpuTimer(vk::CommandBuffer commandBuffer)
+{
+    if(!timestampQueries)
+        return;
+
+    commandBuffer.resetQueryPool(timestampQueries.get(), 0, 2);
+    commandBuffer.writeTimestamp(
+        vk::PipelineStageFlagBits::eTopOfPipe,
+        timestampQueries.get(),
+        0);
+}
+
+void FrameContext::endGpuTimer(vk::CommandBuffer commandBuffer)
+{
+    if(!timestampQueries)
+        return;
+
+    commandBuffer.writeTimestamp(
+        vk::PipelineStageFlagBits::eBottomOfPipe,
+        timestampQueries.get(),
+        1);
+    timestampsWritten = true;
+}
+
+std::optional<std::chrono::nanoseconds> FrameContext::readGpuTime()
+{
+    if(!timestampQueries || !timestampsWritten)
+        return std::nullopt;
+
+    uint64_t timestamps[2];
+    auto res = device.getQueryPoolResults(
+        timestampQueries.get(),
+        0,
+        2,
+        sizeof(timestamps),
+        timestamps,
+        sizeof(uint64_t),
+        vk::QueryResultFlagBits::e64);
+    if(res != vk::Result::eSuccess)
+        return std::nullopt;
+
+    // Only the valid bits count, the difference is still right if they wrapped in between
+    auto ticks = (double)((timestamps[1] - timestamps[0]) & timestampMask);
+    return std::chrono::nanoseconds((int64_t)(ticks * timestampPeriod));
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <variant>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../job_system.h"
+#include "buffer.h"
+#include "command_recorder.h"
+#include "descriptor_allocator.h"
+#include "transient_buffer.h"
+
+/**
+ * @brief Everything that belongs to one frame in flight.
+ *
+ * The number of frames in flight is UserConfig::framesInFlight and is independent of the number of
+ * swapchain images; anything that is tied to a swapchain image (framebuffers, "render finished"
+ * semaphores) lives in SelectedConfig::SwapChain instead.
+ */
+struct FrameContext
+{
+    class Builder
+    {
+        using Self = Builder;
+
+      public:
+        Builder(const vk::UniqueDevice&);
+
+        Self& usingJobSystem(JobSystem&);
+        Self& withQueueFamily(uint32_t);
+        Self& withTransientBufferSize(uint32_t, const vk::PhysicalDeviceMemoryProperties&);
+        // `timestampPeriod` comes from vk::PhysicalDeviceLimits. Queries are skipped if the queue
+        // doesn't support timestamps
+        Self& withGpuTimer(float timestampPeriod, uint32_t timestampValidBits);
+
+        enum class ErrorType
+        {
+            CreateSync,
+            CreateCommandRecorder,
+            CreateTransientBuffer,
+            CreateQueryPool,
+        };
+
+        struct Error
+        {
+            ErrorType type;
+            union
+            {
+                struct
+                {
+                    vk::Result result;
+                } CreateSync;
+                struct
+                {
+                    vk::Result result;
+                } CreateCommandRecorder;
+                struct
+                {
+                    Buffer::Builder::Error error;
+                } CreateTransientBuffer;
+                struct
+                {
+                    vk::Result result;
+                } CreateQueryPool;
+            };
+        };
+
+        std::variant<FrameContext, Error> build() const;
+
+      private:
+        const vk::UniqueDevice& device;
+        JobSystem* jobSystem;
+
+        uint32_t queueFamilyIndex;
+        uint32_t transientBufferSize;
+        vk::PhysicalDeviceMemoryProperties memoryProperties;
+        std::optional<float> timestampPeriod;
+        uint32_t timestampValidBits;
+    };
+
+    /**
+     * @brief Prepares the frame for recording: resets command pools, descriptor pools, the
+     * transient buffer and the GPU timer. The frame's previous submission must have completed
+     */
+    vk::Result reset();
+
+    // Record at the start and end of the primary command buffer
+    void beginGpuTimer(vk::CommandBuffer commandBuffer);
+    void endGpuTimer(vk::CommandBuffer commandBuffer);
+    // GPU time of this frame's previous submission. Call after it has completed and before `reset`
+    std::optional<std::chrono::nanoseconds> readGpuTime();
+
+    CommandRecorder commandRecorder;
+    TransientBuffer transientBuffer;
+    // Sets that only live for this frame. Only use it from the thread that records the primary
+    DescriptorAllocator descriptorAllocator;
+    vk::UniqueSemaphore imageAvailable;
+    // GpuTimeline value of the frame's last submission, 0 before the first one
+    uint64_t timelineValue;
+
+    vk::Device device;
+    vk::UniqueQueryPool timestampQueries;
+    float timestampPeriod;
+    // Of the bits the queue family's timestamps actually have
+    uint64_t timestampMask;
+    bool timestampsWritten;
+};
@@ -0,0 +1,59 @@
+#include "gpu_resources.h"
+
+#include <cassert>
+
+BufferHandle GpuResources::addBuffer(Buffer&& buffer)
+{
+    return buffers.create(
+        std::move(buffer.buffer),
+        std::move(buffer.memory),
+        BufferInfo{.size = buffer.size});
+}
+
+vk::Buffer GpuResources::getBuffer(BufferHandle handle) const
+{
+    const vk::UniqueBuffer* buffer = buffers.get<vk::UniqueBuffer>(handle);
+    assert(buffer);
+    return buffer->get();
+}
+
+ImageHandle GpuResources::addImage(Image&& image)
+{
+    return images.create(
+        std::move(image.image),
+        std::move(image.memory),
+        std::move(image.view),
+        ImageInfo{
+            .extent = image.extent,
+            .format = image.format,
+            .mipLevels = image.mipLevels,
+        });
+}
+
+vk::ImageView GpuResources::getImageView(ImageHandle handle) const
+{
+    const vk::UniqueImageView* view = images.get<vk::UniqueImageView>(handle);
+    assert(view);
+    return view->get();
+}
+
+PipelineHandle GpuResources::addPipeline(
+    vk::UniquePipeline&& pipeline,
+    vk::UniquePipelineLayout&& layout)
+{
+    return pipelines.create(std::move(pipeline), std::move(layout));
+}
+
+vk::Pipeline GpuResources::getPipeline(PipelineHandle handle) const
+{
+    const vk::UniquePipeline* pipeline = pipelines.get<vk::UniquePipeline>(handle);
+    assert(pipeline);
+    return pipeline->get();
+}
+
+vk::PipelineLayout GpuResources::getPipelineLayout(PipelineHandle handle) const
+{
+    const vk::UniquePipelineLayout* layout = pipelines.get<vk::UniquePipelineLayout>(handle);
+    assert(layout);
+    return layout->get();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../handle_pool.h"
+#include "buffer.h"
+#include "image.h"
+
+struct BufferTag;
+struct ImageTag;
+struct PipelineTag;
+
+using BufferHandle = Handle<BufferTag>;
+using ImageHandle = Handle<ImageTag>;
+using PipelineHandle = Handle<PipelineTag>;
+
+struct BufferInfo
+{
+    uint32_t size;
+};
+
+struct ImageInfo
+{
+    vk::Extent3D extent;
+    vk::Format format;
+    uint32_t mipLevels;
+};
+
+using BufferPool = HandlePool<BufferTag, vk::UniqueBuffer, vk::UniqueDeviceMemory, BufferInfo>;
+using ImagePool = HandlePool<
+    ImageTag,
+    vk::UniqueImage,
+    vk::UniqueDeviceMemory,
+    vk::UniqueImageView,
+    ImageInfo>;
+using PipelinePool = HandlePool<PipelineTag, vk::UniquePipeline, vk::UniquePipelineLayout>;
+
+/**
+ * @brief Owns the GPU objects that renderer code refers to by handle.
+ *
+ * Must be destroyed before the device. Objects that the GPU might still be using should be
+ * `destroy`ed from their pool and the returned components retired in a DeletionQueue.
+ */
+struct GpuResources
+{
+    BufferHandle addBuffer(Buffer&& buffer);
+    // vk::Buffer of a valid handle
+    vk::Buffer getBuffer(BufferHandle handle) const;
+
+    ImageHandle addImage(Image&& image);
+    // View of every level of a valid handle
+    vk::ImageView getImageView(ImageHandle handle) const;
+
+    PipelineHandle addPipeline(vk::UniquePipeline&& pipeline, vk::UniquePipelineLayout&& layout);
+    vk::Pipeline getPipeline(PipelineHandle handle) const;
+    vk::PipelineLayout getPipelineLayout(PipelineHandle handle) const;
+
+    BufferPool buffers;
+    ImagePool images;
+    PipelinePool pipelines;
+};
@@ -0,0 +1,107 @@
+#include "gpu_timeline.h"
+
+#include <algorithm>
+
+std::variant<GpuTimeline, vk::Result> GpuTimeline::create(const vk::UniqueDevice& device)
+{
+    vk::SemaphoreTypeCreateInfo typeInfo = {
+        .semaphoreType = vk::SemaphoreType::eTimeline,
+        .initialValue = 0,
+    };
+    auto [csRes, semaphore] = device->createSemaphoreUnique({.pNext = &typeInfo});
+    if(csRes != vk::Result::eSuccess)
+        return csRes;
+
+    return GpuTimeline(device.get(), std::move(semaphore));
+}
+
+GpuTimeline::GpuTimeline(vk::Device device, vk::UniqueSemaphore&& semaphore)
+    : device(device)
+    , semaphore(std::move(semaphore))
+    , lastSubmitted(0)
+    , lastCompleted(0)
+{
+}
+
+std::variant<uint64_t, vk::Result> GpuTimeline::submit(
+    vk::Queue queue,
+    const Submission& submission)
+{
+    uint64_t value = lastSubmitted + 1;
+
+    // Binary semaphores ignore their value, but every semaphore needs a slot
+    vk::Semaphore signalSemaphores[] = {semaphore.get(), submission.signalSemaphore};
+    uint64_t signalValues[] = {value, 0};
+    uint64_t waitValue = 0;
+    bool hasWait = (bool)submission.waitSemaphore;
+    uint32_t signalCount = submission.signalSemaphore ? 2 : 1;
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo = {
+        .waitSemaphoreValueCount = hasWait ? 1u : 0u,
+        .pWaitSemaphoreValues = &waitValue,
+        .signalSemaphoreValueCount = signalCount,
+        .pSignalSemaphoreValues = signalValues,
+    };
+    vk::SubmitInfo submitInfo = {
+        .pNext = &timelineInfo,
+        .waitSemaphoreCount = hasWait ? 1u : 0u,
+        .pWaitSemaphores = &submission.waitSemaphore,
+        .pWaitDstStageMask = &submission.waitStage,
+        .commandBufferCount = (uint32_t)submission.commandBuffers.size(),
+        .pCommandBuffers = submission.commandBuffers.data(),
+        .signalSemaphoreCount = signalCount,
+        .pSignalSemaphores = signalSemaphores,
+    };
+
+    auto res = queue.submit(1, &submitInfo, VK_NULL_HANDLE);
+    if(res != vk::Result::eSuccess)
+        return res;
+
+    lastSubmitted = value;
+    return value;
+}
+
+bool GpuTimeline::isComplete(uint64_t value)
+{
+    if(value <= lastCompleted)
+        return true;
+
+    uint64_t counter;
+    auto res = device.getSemaphoreCounterValue(semaphore.get(), &counter);
+    if(res != vk::Result::eSuccess)
+        return false;
+
+    lastCompleted = std::max(lastCompleted, counter);
+    return value <= lastCompleted;
+}
+
+vk::Result GpuTimeline::wait(uint64_t value, uint64_t timeout)
+{
+    if(value <= lastCompleted)
+        return vk::Result::eSuccess;
+
+    vk::SemaphoreWaitInfo waitInfo = {
+        .semaphoreCount = 1,
+        .pSemaphores = &semaphore.get(),
+        .pValues = &value,
+    };
+    auto res = device.waitSemaphores(&waitInfo, timeout);
+    if(res == vk::Result::eSuccess)
+        lastCompleted = std::max(lastCompleted, value);
+    return res;
+}
+
+uint64_t GpuTimeline::getLastSubmitted() const
+{
+    return lastSubmitted;
+}
+
+uint64_t GpuTimeline::getLastCompleted() const
+{
+    return lastCompleted;
+}
+
+vk::Semaphore GpuTimeline::getSemaphore() const
+{
+    return semaphore.get();
+}
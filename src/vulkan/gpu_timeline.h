@@ -0,0 +1,53 @@
+#pragma once
+
+#include <span>
+#include <variant>
+#include <vulkan/vulkan_raii.hpp>
+
+/**
+ * @brief A monotonically increasing GPU timeline for one queue, backed by a timeline semaphore.
+ *
+ * Every submission through `submit` signals the next value, so "is this work done?" becomes a
+ * comparison against the last completed value. That value is cached and only re-queried from the
+ * driver when asked about a value past it, which makes `isComplete` cheap enough to call per
+ * resource.
+ *
+ * Value 0 is never signaled by a submission and is always complete, so it can be used as "not in
+ * flight".
+ */
+class GpuTimeline
+{
+  public:
+    struct Submission
+    {
+        std::span<const vk::CommandBuffer> commandBuffers;
+        // Optional binary semaphores, e.g. from vkAcquireNextImageKHR and for vkQueuePresentKHR
+        vk::Semaphore waitSemaphore;
+        vk::PipelineStageFlags waitStage;
+        vk::Semaphore signalSemaphore;
+    };
+
+    static std::variant<GpuTimeline, vk::Result> create(const vk::UniqueDevice& device);
+
+    /**
+     * @brief Submits to `queue` and signals the next timeline value, which is returned. The queue
+     * must be the only queue this timeline is used with
+     */
+    std::variant<uint64_t, vk::Result> submit(vk::Queue queue, const Submission& submission);
+
+    bool isComplete(uint64_t value);
+    vk::Result wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+    // The value of the most recent submission
+    uint64_t getLastSubmitted() const;
+    uint64_t getLastCompleted() const;
+    vk::Semaphore getSemaphore() const;
+
+  private:
+    GpuTimeline(vk::Device device, vk::UniqueSemaphore&& semaphore);
+
+    vk::Device device;
+    vk::UniqueSemaphore semaphore;
+    uint64_t lastSubmitted;
+    uint64_t lastCompleted;
+};
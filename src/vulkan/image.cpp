@@ -0,0 +1,385 @@
+#include "image.h"
+
+#include "commands.h"
+
+using Builder = Image::Builder;
+
+Builder::Builder(const vk::UniqueDevice& device)
+    : device(device)
+    , fullMipChain(false)
+    , memoryProperties()
+    , requiredMemoryFlags(vk::MemoryPropertyFlagBits::eDeviceLocal)
+{
+    imageInfo = vk::ImageCreateInfo{
+        .imageType = vk::ImageType::e2D,
+        .format = vk::Format::eR8G8B8A8Unorm,
+        .extent = {1, 1, 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = vk::SampleCountFlagBits::e1,
+        .tiling = vk::ImageTiling::eOptimal,
+        .sharingMode = vk::SharingMode::eExclusive,
+        .initialLayout = vk::ImageLayout::eUndefined,
+    };
+}
+
+Builder& Builder::withExtent(uint32_t width, uint32_t height)
+{
+    imageInfo.extent = vk::Extent3D{width, height, 1};
+    return *this;
+}
+
+Builder& Builder::withFormat(vk::Format format)
+{
+    imageInfo.format = format;
+    return *this;
+}
+
+Builder& Builder::withMipLevels(uint32_t levels)
+{
+    imageInfo.mipLevels = levels;
+    fullMipChain = false;
+    return *this;
+}
+
+Builder& Builder::withFullMipChain()
+{
+    fullMipChain = true;
+    return *this;
+}
+
+Builder& Builder::withSampledUsage()
+{
+    imageInfo.usage |= vk::ImageUsageFlagBits::eSampled;
+    return *this;
+}
+
+Builder& Builder::withTransferSourceUsage()
+{
+    imageInfo.usage |= vk::ImageUsageFlagBits::eTransferSrc;
+    return *this;
+}
+
+Builder& Builder::withTransferDestUsage()
+{
+    imageInfo.usage |= vk::ImageUsageFlagBits::eTransferDst;
+    return *this;
+}
+
+Builder& Builder::withStorageUsage()
+{
+    imageInfo.usage |= vk::ImageUsageFlagBits::eStorage;
+    return *this;
+}
+
+Builder& Builder::withMemoryProperties(
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    vk::MemoryPropertyFlags required)
+{
+    this->memoryProperties = memoryProperties;
+    this->requiredMemoryFlags = required;
+    return *this;
+}
+
+std::variant<Image, Builder::Error> Builder::build() const
+{
+    Builder::Error error = {};
+
+    vk::ImageCreateInfo imageInfo = this->imageInfo;
+    if(fullMipChain)
+        imageInfo.mipLevels = fullMipLevelCount(imageInfo.extent.width, imageInfo.extent.height);
+    // sRGB formats don't support storage usage themselves, only their UNORM views do
+    bool srgbStorage =
+        (imageInfo.usage & vk::ImageUsageFlagBits::eStorage) && srgbToUnorm(imageInfo.format);
+    if(srgbStorage)
+        imageInfo.flags |=
+            vk::ImageCreateFlagBits::eMutableFormat | vk::ImageCreateFlagBits::eExtendedUsage;
+
+    auto [ciRes, image] = device->createImageUnique(imageInfo);
+    if(ciRes == vk::Result::eErrorOutOfHostMemory || ciRes == vk::Result::eErrorOutOfDeviceMemory)
+    {
+        error.type = Builder::ErrorType::OutOfMemory;
+        error.OutOfMemory.result = ciRes;
+        return error;
+    }
+    else if(ciRes != vk::Result::eSuccess)
+    {
+        error.type = Builder::ErrorType::CreateImage;
+        error.CreateImage.result = ciRes;
+        return error;
+    }
+
+    vk::MemoryRequirements memoryRequirements = device->getImageMemoryRequirements(image.get());
+    std::optional<uint32_t> memoryIndex;
+    for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if(memoryRequirements.memoryTypeBits & (1 << i)
+           && (memoryProperties.memoryTypes[i].propertyFlags & requiredMemoryFlags)
+                  == requiredMemoryFlags)
+        {
+            memoryIndex = i;
+            break;
+        }
+    }
+    if(!memoryIndex.has_value())
+    {
+        error.type = Builder::ErrorType::NoMemoryTypeFound;
+        error.NoMemoryTypeFound.message = "No memory type has the required flags";
+        return error;
+    }
+
+    auto [amRes, memory] = device->allocateMemoryUnique({
+        .allocationSize = memoryRequirements.size,
+        .memoryTypeIndex = memoryIndex.value(),
+    });
+    if(amRes == vk::Result::eErrorOutOfHostMemory || amRes == vk::Result::eErrorOutOfDeviceMemory)
+    {
+        error.type = Builder::ErrorType::OutOfMemory;
+        error.OutOfMemory.result = amRes;
+        return error;
+    }
+    else if(amRes != vk::Result::eSuccess)
+    {
+        error.type = Builder::ErrorType::AllocateMemory;
+        error.AllocateMemory.result = amRes;
+        return error;
+    }
+
+    auto bimRes = device->bindImageMemory(image.get(), memory.get(), 0);
+    if(bimRes != vk::Result::eSuccess)
+    {
+        error.type = Builder::ErrorType::AllocateMemory;
+        error.AllocateMemory.result = bimRes;
+        return error;
+    }
+
+    // The sRGB view can't inherit the storage usage
+    vk::ImageViewUsageCreateInfo viewUsage = {
+        .usage = imageInfo.usage & ~vk::ImageUsageFlags(vk::ImageUsageFlagBits::eStorage),
+    };
+    auto [civRes, view] = device->createImageViewUnique({
+        .pNext = srgbStorage ? &viewUsage : nullptr,
+        .image = image.get(),
+        .viewType = vk::ImageViewType::e2D,
+        .format = imageInfo.format,
+        .subresourceRange =
+            {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseMipLevel = 0,
+                .levelCount = imageInfo.mipLevels,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    });
+    if(civRes != vk::Result::eSuccess)
+    {
+        error.type = Builder::ErrorType::CreateImageView;
+        error.CreateImageView.result = civRes;
+        return error;
+    }
+
+    return Image(
+        imageInfo.extent,
+        imageInfo.format,
+        imageInfo.mipLevels,
+        std::move(image),
+        std::move(memory),
+        std::move(view));
+}
+
+Image::Image(
+    vk::Extent3D extent,
+    vk::Format format,
+    uint32_t mipLevels,
+    vk::UniqueImage&& image,
+    vk::UniqueDeviceMemory&& memory,
+    vk::UniqueImageView&& view)
+    : extent(extent)
+    , format(format)
+    , mipLevels(mipLevels)
+    , image(std::move(image))
+    , memory(std::move(memory))
+    , view(std::move(view))
+{
+}
+
+void Image::recordUpload(
+    vk::CommandBuffer commandBuffer,
+    vk::Buffer source,
+    vk::DeviceSize offset) const
+{
+    Commands::transitionImageLayout(
+        commandBuffer,
+        image.get(),
+        vk::ImageLayout::eUndefined,
+        vk::ImageLayout::eTransferDstOptimal,
+        allLevels());
+
+    vk::BufferImageCopy copy = {
+        .bufferOffset = offset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource =
+            {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = extent,
+    };
+    commandBuffer.copyBufferToImage(
+        source,
+        image.get(),
+        vk::ImageLayout::eTransferDstOptimal,
+        1,
+        &copy);
+}
+
+vk::ImageSubresourceRange Image::allLevels() const
+{
+    return vk::ImageSubresourceRange{
+        .aspectMask = vk::ImageAspectFlagBits::eColor,
+        .baseMipLevel = 0,
+        .levelCount = mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+    };
+}
+
+std::optional<vk::Format> srgbToUnorm(vk::Format format)
+{
+    switch(format)
+    {
+        case vk::Format::eR8G8B8A8Srgb: return vk::Format::eR8G8B8A8Unorm;
+        case vk::Format::eB8G8R8A8Srgb: return vk::Format::eB8G8R8A8Unorm;
+        case vk::Format::eA8B8G8R8SrgbPack32: return vk::Format::eA8B8G8R8UnormPack32;
+        default: return std::nullopt;
+    }
+}
+
+std::optional<TexelBlock> texelBlock(vk::Format format)
+{
+    using F = vk::Format;
+    switch(format)
+    {
+        case F::eR8Unorm:
+        case F::eR8Snorm:
+        case F::eR8Uint:
+        case F::eR8Sint:
+        case F::eR8Srgb: return TexelBlock{1, 1, 1};
+        case F::eR8G8Unorm:
+        case F::eR8G8Snorm:
+        case F::eR8G8Uint:
+        case F::eR8G8Sint:
+        case F::eR8G8Srgb:
+        case F::eR16Unorm:
+        case F::eR16Snorm:
+        case F::eR16Uint:
+        case F::eR16Sint:
+        case F::eR16Sfloat:
+        case F::eR4G4B4A4UnormPack16:
+        case F::eB4G4R4A4UnormPack16:
+        case F::eR5G6B5UnormPack16:
+        case F::eB5G6R5UnormPack16:
+        case F::eR5G5B5A1UnormPack16:
+        case F::eB5G5R5A1UnormPack16:
+        case F::eA1R5G5B5UnormPack16: return TexelBlock{1, 1, 2};
+        case F::eR8G8B8A8Unorm:
+        case F::eR8G8B8A8Snorm:
+        case F::eR8G8B8A8Uint:
+        case F::eR8G8B8A8Sint:
+        case F::eR8G8B8A8Srgb:
+        case F::eB8G8R8A8Unorm:
+        case F::eB8G8R8A8Snorm:
+        case F::eB8G8R8A8Uint:
+        case F::eB8G8R8A8Sint:
+        case F::eB8G8R8A8Srgb:
+        case F::eA8B8G8R8UnormPack32:
+        case F::eA8B8G8R8SnormPack32:
+        case F::eA8B8G8R8UintPack32:
+        case F::eA8B8G8R8SintPack32:
+        case F::eA8B8G8R8SrgbPack32:
+        case F::eA2R10G10B10UnormPack32:
+        case F::eA2R10G10B10UintPack32:
+        case F::eA2B10G10R10UnormPack32:
+        case F::eA2B10G10R10UintPack32:
+        case F::eR16G16Unorm:
+        case F::eR16G16Snorm:
+        case F::eR16G16Uint:
+        case F::eR16G16Sint:
+        case F::eR16G16Sfloat:
+        case F::eR32Uint:
+        case F::eR32Sint:
+        case F::eR32Sfloat:
+        case F::eB10G11R11UfloatPack32:
+        case F::eE5B9G9R9UfloatPack32: return TexelBlock{1, 1, 4};
+        case F::eR16G16B16A16Unorm:
+        case F::eR16G16B16A16Snorm:
+        case F::eR16G16B16A16Uint:
+        case F::eR16G16B16A16Sint:
+        case F::eR16G16B16A16Sfloat:
+        case F::eR32G32Uint:
+        case F::eR32G32Sint:
+        case F::eR32G32Sfloat: return TexelBlock{1, 1, 8};
+        case F::eR32G32B32A32Uint:
+        case F::eR32G32B32A32Sint:
+        case F::eR32G32B32A32Sfloat: return TexelBlock{1, 1, 16};
+        case F::eBc1RgbUnormBlock:
+        case F::eBc1RgbSrgbBlock:
+        case F::eBc1RgbaUnormBlock:
+        case F::eBc1RgbaSrgbBlock:
+        case F::eBc4UnormBlock:
+        case F::eBc4SnormBlock:
+        case F::eEtc2R8G8B8UnormBlock:
+        case F::eEtc2R8G8B8SrgbBlock:
+        case F::eEtc2R8G8B8A1UnormBlock:
+        case F::eEtc2R8G8B8A1SrgbBlock:
+        case F::eEacR11UnormBlock:
+        case F::eEacR11SnormBlock: return TexelBlock{4, 4, 8};
+        case F::eBc2UnormBlock:
+        case F::eBc2SrgbBlock:
+        case F::eBc3UnormBlock:
+        case F::eBc3SrgbBlock:
+        case F::eBc5UnormBlock:
+        case F::eBc5SnormBlock:
+        case F::eBc6HUfloatBlock:
+        case F::eBc6HSfloatBlock:
+        case F::eBc7UnormBlock:
+        case F::eBc7SrgbBlock:
+        case F::eEtc2R8G8B8A8UnormBlock:
+        case F::eEtc2R8G8B8A8SrgbBlock:
+        case F::eEacR11G11UnormBlock:
+        case F::eEacR11G11SnormBlock:
+        case F::eAstc4x4UnormBlock:
+        case F::eAstc4x4SrgbBlock: return TexelBlock{4, 4, 16};
+        case F::eAstc5x4UnormBlock:
+        case F::eAstc5x4SrgbBlock: return TexelBlock{5, 4, 16};
+        case F::eAstc5x5UnormBlock:
+        case F::eAstc5x5SrgbBlock: return TexelBlock{5, 5, 16};
+        case F::eAstc6x5UnormBlock:
+        case F::eAstc6x5SrgbBlock: return TexelBlock{6, 5, 16};
+        case F::eAstc6x6UnormBlock:
+        case F::eAstc6x6SrgbBlock: return TexelBlock{6, 6, 16};
+        case F::eAstc8x5UnormBlock:
+        case F::eAstc8x5SrgbBlock: return TexelBlock{8, 5, 16};
+        case F::eAstc8x6UnormBlock:
+        case F::eAstc8x6SrgbBlock: return TexelBlock{8, 6, 16};
+        case F::eAstc8x8UnormBlock:
+        case F::eAstc8x8SrgbBlock: return TexelBlock{8, 8, 16};
+        case F::eAstc10x5UnormBlock:
+        case F::eAstc10x5SrgbBlock: return TexelBlock{10, 5, 16};
+        case F::eAstc10x6UnormBlock:
+        case F::eAstc10x6SrgbBlock: return TexelBlock{10, 6, 16};
+        case F::eAstc10x8UnormBlock:
+        case F::eAstc10x8SrgbBlock: return TexelBlock{10, 8, 16};
+        case F::eAstc10x10UnormBlock:
+        case F::eAstc10x10SrgbBlock: return TexelBlock{10, 10, 16};
+        case F::eAstc12x10UnormBlock:
+        case F::eAstc12x10SrgbBlock: return TexelBlock{12, 10, 16};
+        case F::eAstc12x12UnormBlock:
+        case F::eAstc12x12SrgbBlock: return TexelBlock{12, 12, 16};
+        default: return std::nullopt;
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include <vulkan/vulkan_raii.hpp>
+
+struct Image
+{
+    class Builder
+    {
+        using Self = Builder;
+
+      public:
+        enum class ErrorType
+        {
+            OutOfMemory,
+            CreateImage,
+            AllocateMemory,
+            NoMemoryTypeFound,
+            CreateImageView,
+        };
+
+        struct Error
+        {
+            ErrorType type;
+            union
+            {
+                struct
+                {
+                    vk::Result result;
+                } OutOfMemory;
+                struct
+                {
+                    vk::Result result;
+                } CreateImage;
+                struct
+                {
+                    vk::Result result;
+                } AllocateMemory;
+                struct
+                {
+                    const char* message;
+                } NoMemoryTypeFound;
+                struct
+                {
+                    vk::Result result;
+                } CreateImageView;
+            };
+        };
+
+        Builder(const vk::UniqueDevice&);
+
+        Self& withExtent(uint32_t width, uint32_t height);
+        Self& withFormat(vk::Format);
+        Self& withMipLevels(uint32_t);
+        // Every level down to 1x1
+        Self& withFullMipChain();
+        Self& withSampledUsage();
+        Self& withTransferSourceUsage();
+        Self& withTransferDestUsage();
+        // sRGB formats get a mutable format and extended usage so they can be written through a
+        // UNORM view. Views in the sRGB format, including `view`, then need every usage but storage
+        Self& withStorageUsage();
+        // Device local unless other flags are asked for
+        Self& withMemoryProperties(
+            const vk::PhysicalDeviceMemoryProperties&,
+            vk::MemoryPropertyFlags required = vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+        // Allocates and binds memory and creates a view of every level
+        std::variant<Image, Error> build() const;
+
+      private:
+        const vk::UniqueDevice& device;
+
+        bool fullMipChain;
+
+        vk::ImageCreateInfo imageInfo;
+        vk::PhysicalDeviceMemoryProperties memoryProperties;
+        vk::MemoryPropertyFlags requiredMemoryFlags;
+    };
+
+    Image(
+        vk::Extent3D extent,
+        vk::Format format,
+        uint32_t mipLevels,
+        vk::UniqueImage&& image,
+        vk::UniqueDeviceMemory&& memory,
+        vk::UniqueImageView&& view);
+    Image(Image&&) = default;
+    Image& operator=(Image&&) = default;
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    /**
+     * @brief Moves every level to TransferDstOptimal and copies level 0 from tightly packed texels
+     * at `offset` in `source`. Follow up with MipGenerator::generate or a transition of the levels
+     * to where they are used next
+     */
+    void recordUpload(
+        vk::CommandBuffer commandBuffer,
+        vk::Buffer source,
+        vk::DeviceSize offset) const;
+
+    vk::ImageSubresourceRange allLevels() const;
+
+    vk::Extent3D extent;
+    vk::Format format;
+    uint32_t mipLevels;
+    vk::UniqueImage image;
+    vk::UniqueDeviceMemory memory;
+    vk::UniqueImageView view;
+};
+
+constexpr uint32_t fullMipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for(uint32_t size = width > height ? width : height; size > 1; size /= 2)
+        levels++;
+    return levels;
+}
+
+// The UNORM format with the same layout, or std::nullopt if `format` isn't sRGB
+std::optional<vk::Format> srgbToUnorm(vk::Format format);
+
+struct TexelBlock
+{
+    // In texels, 1 x 1 for uncompressed formats
+    uint32_t width;
+    uint32_t height;
+    // In bytes
+    uint32_t size;
+};
+
+// Of uncompressed color formats and BCn, ETC2/EAC and ASTC, std::nullopt for anything else
+std::optional<TexelBlock> texelBlock(vk::Format format);
@@ -1,6 +1,7 @@
 #include "instance_builder.h"
 
 #include "../stl_utils.h"
+#include "dispatch.h"
 #include <variant>
 
 struct ValidatedLayer
@@ -121,6 +122,8 @@ std::optional<InstanceBuilder::Error> InstanceBuilder::build(SelectedConfig& con
     // Some errors require multiple iterations in loops and such, so declare it here
     Error error = {};
 
+    Dispatch::initLoader();
+
     auto validatedLayersVar = validateLayers(layers);
     if(std::holds_alternative<vk::Result>(validatedLayersVar))
     {
@@ -160,6 +163,7 @@ std::optional<InstanceBuilder::Error> InstanceBuilder::build(SelectedConfig& con
         return error;
     }
 
+    Dispatch::initInstance(instance.get());
     config.instance = std::move(instance);
 
     return std::nullopt;
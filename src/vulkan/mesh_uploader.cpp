@@ -0,0 +1,201 @@
+#include "mesh_uploader.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr vk::DeviceSize StagingAlignment = 16;
+}
+
+MeshUploader::MeshUploader(
+    const vk::UniqueDevice& device,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    GpuResources& resources)
+    : device(device)
+    , memoryProperties(memoryProperties)
+    , resources(resources)
+{
+}
+
+std::variant<LoadedMesh, MeshUploader::Error> MeshUploader::add(MeshData&& mesh)
+{
+    PendingMesh upload = {
+        .mesh = std::move(mesh),
+        .smallIndices = {},
+        .loaded = {},
+        .vertexBytesCopied = 0,
+        .indexBytesCopied = 0,
+    };
+
+    AssetFormat::MeshInfo& info = upload.loaded.info;
+    info = {
+        .vertexCount = (uint32_t)upload.mesh.vertices.size(),
+        .indexCount = (uint32_t)upload.mesh.indices.size(),
+        .vertexStride = sizeof(MeshVertex),
+        .indexSize = 4,
+        .boundsMin = {},
+        .boundsMax = {},
+    };
+    glm::vec3 boundsMin(0.0f);
+    glm::vec3 boundsMax(0.0f);
+    if(!upload.mesh.vertices.empty())
+        boundsMin = boundsMax = upload.mesh.vertices[0].position;
+    for(const MeshVertex& vertex : upload.mesh.vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    std::copy_n(&boundsMin.x, 3, info.boundsMin);
+    std::copy_n(&boundsMax.x, 3, info.boundsMax);
+
+    upload.loaded.indexType = vk::IndexType::eUint32;
+    if(info.vertexCount <= 1 << 16)
+    {
+        upload.smallIndices.assign(upload.mesh.indices.begin(), upload.mesh.indices.end());
+        upload.mesh.indices = {};
+        upload.loaded.indexType = vk::IndexType::eUint16;
+        info.indexSize = 2;
+    }
+
+    auto vertexBuilder = Buffer::Builder(device);
+    vertexBuilder.withVertexBufferFormat()
+        .withTransferDestFormat(memoryProperties)
+        .withSize(info.vertexCount * info.vertexStride);
+    auto vertexBufferVar = createBuffer(vertexBuilder);
+    if(std::holds_alternative<Error>(vertexBufferVar))
+        return std::get<Error>(vertexBufferVar);
+    auto indexBuilder = Buffer::Builder(device);
+    indexBuilder.withIndexBufferFormat()
+        .withTransferDestFormat(memoryProperties)
+        .withSize(info.indexCount * info.indexSize);
+    auto indexBufferVar = createBuffer(indexBuilder);
+    if(std::holds_alternative<Error>(indexBufferVar))
+        return std::get<Error>(indexBufferVar);
+
+    upload.loaded.vertexBuffer = resources.addBuffer(std::move(std::get<Buffer>(vertexBufferVar)));
+    upload.loaded.indexBuffer = resources.addBuffer(std::move(std::get<Buffer>(indexBufferVar)));
+    pending.push_back(std::move(upload));
+    return pending.back().loaded;
+}
+
+void MeshUploader::update(
+    vk::CommandBuffer commandBuffer,
+    TransientBuffer& staging,
+    vk::DeviceSize budget)
+{
+    bool copied = false;
+    while(!pending.empty())
+    {
+        PendingMesh& upload = pending.front();
+        auto vertices = std::as_bytes(std::span(upload.mesh.vertices));
+        auto indices = upload.loaded.indexType == vk::IndexType::eUint16
+                           ? std::as_bytes(std::span(upload.smallIndices))
+                           : std::as_bytes(std::span(upload.mesh.indices));
+
+        vk::Buffer vertexBuffer = resources.getBuffer(upload.loaded.vertexBuffer);
+        vk::Buffer indexBuffer = resources.getBuffer(upload.loaded.indexBuffer);
+
+        vk::DeviceSize previousBudget = budget;
+        bool done =
+            copy(commandBuffer, staging, budget, vertices, upload.vertexBytesCopied, vertexBuffer)
+            && copy(commandBuffer, staging, budget, indices, upload.indexBytesCopied, indexBuffer);
+        copied = copied || budget != previousBudget;
+        if(!done)
+            break;
+        pending.pop_front();
+    }
+
+    if(!copied)
+        return;
+    vk::MemoryBarrier barrier = {
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead,
+    };
+    commandBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eVertexInput,
+        vk::DependencyFlags(),
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+}
+
+bool MeshUploader::isUploaded(const LoadedMesh& mesh) const
+{
+    return std::none_of(pending.begin(), pending.end(), [&](const PendingMesh& upload) {
+        return upload.loaded.vertexBuffer == mesh.vertexBuffer;
+    });
+}
+
+vk::DeviceSize MeshUploader::getPendingBytes() const
+{
+    vk::DeviceSize bytes = 0;
+    for(const PendingMesh& upload : pending)
+    {
+        bytes += upload.loaded.info.vertexCount * upload.loaded.info.vertexStride
+                 - upload.vertexBytesCopied;
+        bytes += upload.loaded.info.indexCount * upload.loaded.info.indexSize
+                 - upload.indexBytesCopied;
+    }
+    return bytes;
+}
+
+std::variant<Buffer, MeshUploader::Error> MeshUploader::createBuffer(Buffer::Builder& builder) const
+{
+    Error error = {};
+
+    auto bufferVar = builder.build();
+    if(std::holds_alternative<Buffer::Builder::Error>(bufferVar))
+    {
+        error.type = ErrorType::CreateBuffer;
+        error.CreateBuffer.error = std::get<Buffer::Builder::Error>(bufferVar);
+        return error;
+    }
+    Buffer& buffer = std::get<Buffer>(bufferVar);
+
+    vk::Result bbmRes = device->bindBufferMemory(buffer.buffer.get(), buffer.memory.get(), 0);
+    if(bbmRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::BindBufferMemory;
+        error.BindBufferMemory.result = bbmRes;
+        return error;
+    }
+    return std::move(buffer);
+}
+
+bool MeshUploader::copy(
+    vk::CommandBuffer commandBuffer,
+    TransientBuffer& staging,
+    vk::DeviceSize& budget,
+    std::span<const std::byte> data,
+    vk::DeviceSize& copied,
+    vk::Buffer destination)
+{
+    while(copied < data.size())
+    {
+        // Only as much as still fits, so every frame makes progress
+        vk::DeviceSize used = (staging.getUsed() + StagingAlignment - 1) & ~(StagingAlignment - 1);
+        vk::DeviceSize available = staging.getCapacity() - std::min(used, staging.getCapacity());
+        vk::DeviceSize size = std::min({data.size() - copied, budget, available});
+        if(size == 0)
+            return false;
+        auto allocation = staging.allocate(size, StagingAlignment);
+        if(!allocation.has_value())
+            return false;
+
+        std::memcpy(allocation->data, data.data() + copied, size);
+        vk::BufferCopy region = {
+            .srcOffset = allocation->offset,
+            .dstOffset = copied,
+            .size = size,
+        };
+        commandBuffer.copyBuffer(allocation->buffer, destination, 1, &region);
+        copied += size;
+        budget -= size;
+    }
+    return true;
+}
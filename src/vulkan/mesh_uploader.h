@@ -0,0 +1,89 @@
+#pragma once
+
+#include <deque>
+#include <span>
+#include <variant>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../mesh_data.h"
+#include "asset_loader.h"
+#include "gpu_resources.h"
+#include "transient_buffer.h"
+
+/**
+ * @brief Uploads meshes that are too large for one frame's staging, such as OBJ or glTF scenes
+ * that were just loaded, a piece per frame.
+ *
+ * `add` creates the device local buffers right away and keeps the mesh data, and `update` copies
+ * up to a byte budget of it per frame through the frame's TransientBuffer, oldest mesh first.
+ * Meshes with at most 65536 vertices get 16 bit indices.
+ */
+class MeshUploader
+{
+  public:
+    enum class ErrorType
+    {
+        CreateBuffer,
+        BindBufferMemory,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                Buffer::Builder::Error error;
+            } CreateBuffer;
+            struct
+            {
+                vk::Result result;
+            } BindBufferMemory;
+        };
+    };
+
+    MeshUploader(
+        const vk::UniqueDevice& device,
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+        GpuResources& resources);
+
+    // `mesh` needs at least one triangle. Don't draw it before `isUploaded` says so
+    std::variant<LoadedMesh, Error> add(MeshData&& mesh);
+
+    /**
+     * @brief Stages up to `budget` bytes of pending meshes in `staging` and records their copies,
+     * followed by a barrier for vertex input. Must be recorded outside of a render pass
+     */
+    void update(vk::CommandBuffer commandBuffer, TransientBuffer& staging, vk::DeviceSize budget);
+
+    bool isUploaded(const LoadedMesh& mesh) const;
+    vk::DeviceSize getPendingBytes() const;
+
+  private:
+    struct PendingMesh
+    {
+        MeshData mesh;
+        // Used instead of mesh.indices for 16 bit indices
+        std::vector<uint16_t> smallIndices;
+        LoadedMesh loaded;
+        vk::DeviceSize vertexBytesCopied;
+        vk::DeviceSize indexBytesCopied;
+    };
+
+    const vk::UniqueDevice& device;
+    vk::PhysicalDeviceMemoryProperties memoryProperties;
+    GpuResources& resources;
+
+    std::deque<PendingMesh> pending;
+
+    std::variant<Buffer, Error> createBuffer(Buffer::Builder& builder) const;
+    // Copies what fits of `data` from `copied` on. Returns false once staging or budget run out
+    bool copy(
+        vk::CommandBuffer commandBuffer,
+        TransientBuffer& staging,
+        vk::DeviceSize& budget,
+        std::span<const std::byte> data,
+        vk::DeviceSize& copied,
+        vk::Buffer destination);
+};
@@ -0,0 +1,406 @@
+#include "mip_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "../shader_paths.h"
+#include "commands.h"
+
+namespace
+{
+    struct PushConstants
+    {
+        uint32_t destinationSize[2];
+        uint32_t encodeSrgb;
+    };
+
+    // Matches local_size in mip_downsample.comp
+    constexpr uint32_t GroupSize = 8;
+
+    vk::ImageSubresourceRange levelRange(uint32_t level)
+    {
+        return vk::ImageSubresourceRange{
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .baseMipLevel = level,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        };
+    }
+}
+
+std::variant<MipGenerator, MipGenerator::Error> MipGenerator::create(
+    const vk::UniqueDevice& device,
+    vk::PhysicalDevice physicalDevice,
+    const ShaderRegistry& shaderRegistry)
+{
+    Error error = {};
+
+    const Shader* shader = shaderRegistry.getComputeShader(ShaderPaths::MipDownsample);
+    if(!shader)
+    {
+        error.type = ErrorType::ShaderNotLoaded;
+        return error;
+    }
+
+    // Only used with texelFetch, so the filter doesn't matter
+    auto [csRes, sampler] = device->createSamplerUnique({
+        .magFilter = vk::Filter::eNearest,
+        .minFilter = vk::Filter::eNearest,
+        .mipmapMode = vk::SamplerMipmapMode::eNearest,
+        .addressModeU = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeV = vk::SamplerAddressMode::eClampToEdge,
+        .addressModeW = vk::SamplerAddressMode::eClampToEdge,
+    });
+    if(csRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::CreateSampler;
+        error.CreateSampler.result = csRes;
+        return error;
+    }
+
+    std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {
+        vk::DescriptorSetLayoutBinding{
+            .binding = 0,
+            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        },
+        vk::DescriptorSetLayoutBinding{
+            .binding = 1,
+            .descriptorType = vk::DescriptorType::eStorageImage,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        },
+    };
+    auto [cdslRes, setLayout] = device->createDescriptorSetLayoutUnique({
+        .bindingCount = (uint32_t)bindings.size(),
+        .pBindings = bindings.data(),
+    });
+    if(cdslRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::CreateLayout;
+        error.CreateLayout.result = cdslRes;
+        return error;
+    }
+
+    vk::PushConstantRange pushConstantRange = {
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    auto [cplRes, pipelineLayout] = device->createPipelineLayoutUnique({
+        .setLayoutCount = 1,
+        .pSetLayouts = &setLayout.get(),
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    });
+    if(cplRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::CreateLayout;
+        error.CreateLayout.result = cplRes;
+        return error;
+    }
+
+    auto [ccpRes, pipeline] = device->createComputePipelineUnique(
+        VK_NULL_HANDLE,
+        {
+            .stage =
+                {
+                    .stage = vk::ShaderStageFlagBits::eCompute,
+                    .module = shader->shaderModule.get(),
+                    .pName = "main",
+                },
+            .layout = pipelineLayout.get(),
+        });
+    if(ccpRes != vk::Result::eSuccess)
+    {
+        error.type = ErrorType::CreatePipeline;
+        error.CreatePipeline.result = ccpRes;
+        return error;
+    }
+
+    return MipGenerator(
+        device.get(),
+        physicalDevice,
+        std::move(sampler),
+        std::move(setLayout),
+        std::move(pipelineLayout),
+        std::move(pipeline));
+}
+
+MipGenerator::MipGenerator(
+    vk::Device device,
+    vk::PhysicalDevice physicalDevice,
+    vk::UniqueSampler&& sampler,
+    vk::UniqueDescriptorSetLayout&& setLayout,
+    vk::UniquePipelineLayout&& pipelineLayout,
+    vk::UniquePipeline&& pipeline)
+    : device(device)
+    , physicalDevice(physicalDevice)
+    , sampler(std::move(sampler))
+    , setLayout(std::move(setLayout))
+    , pipelineLayout(std::move(pipelineLayout))
+    , pipeline(std::move(pipeline))
+{
+}
+
+MipGenerator::Method MipGenerator::methodFor(vk::Format format) const
+{
+    auto blitFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst
+                        | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+    if((physicalDevice.getFormatProperties(format).optimalTilingFeatures & blitFeatures)
+       == blitFeatures)
+        return Method::Blit;
+
+    // The shader writes rgba8
+    vk::Format storageFormat = srgbToUnorm(format).value_or(format);
+    auto storageFeatures = physicalDevice.getFormatProperties(storageFormat).optimalTilingFeatures;
+    auto sampledFeatures = physicalDevice.getFormatProperties(format).optimalTilingFeatures;
+    if(storageFormat == vk::Format::eR8G8B8A8Unorm
+       && (storageFeatures & vk::FormatFeatureFlagBits::eStorageImage)
+       && (sampledFeatures & vk::FormatFeatureFlagBits::eSampledImage))
+        return Method::Compute;
+
+    return Method::Unsupported;
+}
+
+std::optional<MipGenerator::Error> MipGenerator::generate(
+    vk::CommandBuffer commandBuffer,
+    const Image& image,
+    DescriptorAllocator& descriptorAllocator,
+    DeletionQueue& deletionQueue,
+    uint64_t timelineValue) const
+{
+    switch(methodFor(image.format))
+    {
+        case Method::Blit: generateWithBlits(commandBuffer, image); return std::nullopt;
+        case Method::Compute:
+            return generateWithCompute(
+                commandBuffer,
+                image,
+                descriptorAllocator,
+                deletionQueue,
+                timelineValue);
+        case Method::Unsupported: break;
+    }
+
+    Error error = {};
+    error.type = ErrorType::UnsupportedFormat;
+    return error;
+}
+
+void MipGenerator::generateWithBlits(vk::CommandBuffer commandBuffer, const Image& image) const
+{
+    auto width = (int32_t)image.extent.width;
+    auto height = (int32_t)image.extent.height;
+    for(uint32_t level = 1; level < image.mipLevels; ++level)
+    {
+        Commands::transitionImageLayout(
+            commandBuffer,
+            image.image.get(),
+            vk::ImageLayout::eTransferDstOptimal,
+            vk::ImageLayout::eTransferSrcOptimal,
+            levelRange(level - 1));
+
+        int32_t nextWidth = std::max(width / 2, 1);
+        int32_t nextHeight = std::max(height / 2, 1);
+        vk::ImageBlit blit = {
+            .srcSubresource =
+                {
+                    .aspectMask = vk::ImageAspectFlagBits::eColor,
+                    .mipLevel = level - 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            .srcOffsets = std::array<vk::Offset3D, 2>{{{0, 0, 0}, {width, height, 1}}},
+            .dstSubresource =
+                {
+                    .aspectMask = vk::ImageAspectFlagBits::eColor,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            .dstOffsets = std::array<vk::Offset3D, 2>{{{0, 0, 0}, {nextWidth, nextHeight, 1}}},
+        };
+        commandBuffer.blitImage(
+            image.image.get(),
+            vk::ImageLayout::eTransferSrcOptimal,
+            image.image.get(),
+            vk::ImageLayout::eTransferDstOptimal,
+            1,
+            &blit,
+            vk::Filter::eLinear);
+
+        Commands::transitionImageLayout(
+            commandBuffer,
+            image.image.get(),
+            vk::ImageLayout::eTransferSrcOptimal,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            levelRange(level - 1));
+
+        width = nextWidth;
+        height = nextHeight;
+    }
+
+    Commands::transitionImageLayout(
+        commandBuffer,
+        image.image.get(),
+        vk::ImageLayout::eTransferDstOptimal,
+        vk::ImageLayout::eShaderReadOnlyOptimal,
+        levelRange(image.mipLevels - 1));
+}
+
+std::optional<MipGenerator::Error> MipGenerator::generateWithCompute(
+    vk::CommandBuffer commandBuffer,
+    const Image& image,
+    DescriptorAllocator& descriptorAllocator,
+    DeletionQueue& deletionQueue,
+    uint64_t timelineValue) const
+{
+    Error error = {};
+    uint32_t passCount = image.mipLevels - 1;
+    if(passCount == 0)
+    {
+        Commands::transitionImageLayout(
+            commandBuffer,
+            image.image.get(),
+            vk::ImageLayout::eTransferDstOptimal,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            image.allLevels());
+        return std::nullopt;
+    }
+
+    std::vector<vk::UniqueImageView> views;
+    std::vector<vk::DescriptorSet> descriptorSets(passCount);
+    for(vk::DescriptorSet& set : descriptorSets)
+    {
+        auto setVar = descriptorAllocator.allocate(setLayout.get());
+        if(std::holds_alternative<vk::Result>(setVar))
+        {
+            error.type = ErrorType::CreateDescriptors;
+            error.CreateDescriptors.result = std::get<vk::Result>(setVar);
+            return error;
+        }
+        set = std::get<vk::DescriptorSet>(setVar);
+    }
+
+    // A sampled view of every level but the last and a storage view of every level but the first
+    vk::Format storageFormat = srgbToUnorm(image.format).value_or(image.format);
+    // The sRGB source views can't have the storage usage of the image
+    vk::ImageViewUsageCreateInfo sampledUsage = {.usage = vk::ImageUsageFlagBits::eSampled};
+    auto createView = [&](uint32_t level, vk::Format format) -> std::optional<vk::ImageView> {
+        auto [civRes, view] = device.createImageViewUnique({
+            .pNext = srgbToUnorm(format).has_value() ? &sampledUsage : nullptr,
+            .image = image.image.get(),
+            .viewType = vk::ImageViewType::e2D,
+            .format = format,
+            .subresourceRange = levelRange(level),
+        });
+        if(civRes != vk::Result::eSuccess)
+        {
+            error.type = ErrorType::CreateImageView;
+            error.CreateImageView.result = civRes;
+            return std::nullopt;
+        }
+        views.push_back(std::move(view));
+        return views.back().get();
+    };
+
+    for(uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        auto sourceView = createView(pass, image.format);
+        auto destinationView = createView(pass + 1, storageFormat);
+        if(!sourceView.has_value() || !destinationView.has_value())
+            return error;
+
+        vk::DescriptorImageInfo sourceInfo = {
+            .sampler = sampler.get(),
+            .imageView = sourceView.value(),
+            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        };
+        vk::DescriptorImageInfo destinationInfo = {
+            .imageView = destinationView.value(),
+            .imageLayout = vk::ImageLayout::eGeneral,
+        };
+        std::array<vk::WriteDescriptorSet, 2> writes = {
+            vk::WriteDescriptorSet{
+                .dstSet = descriptorSets[pass],
+                .dstBinding = 0,
+                .descriptorCount = 1,
+                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+                .pImageInfo = &sourceInfo,
+            },
+            vk::WriteDescriptorSet{
+                .dstSet = descriptorSets[pass],
+                .dstBinding = 1,
+                .descriptorCount = 1,
+                .descriptorType = vk::DescriptorType::eStorageImage,
+                .pImageInfo = &destinationInfo,
+            },
+        };
+        device.updateDescriptorSets((uint32_t)writes.size(), writes.data(), 0, nullptr);
+    }
+
+    Commands::transitionImageLayout(
+        commandBuffer,
+        image.image.get(),
+        vk::ImageLayout::eTransferDstOptimal,
+        vk::ImageLayout::eShaderReadOnlyOptimal,
+        levelRange(0));
+    Commands::transitionImageLayout(
+        commandBuffer,
+        image.image.get(),
+        vk::ImageLayout::eTransferDstOptimal,
+        vk::ImageLayout::eGeneral,
+        vk::ImageSubresourceRange{
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .baseMipLevel = 1,
+            .levelCount = passCount,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        });
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline.get());
+    uint32_t width = image.extent.width;
+    uint32_t height = image.extent.height;
+    for(uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+
+        commandBuffer.bindDescriptorSets(
+            vk::PipelineBindPoint::eCompute,
+            pipelineLayout.get(),
+            0,
+            1,
+            &descriptorSets[pass],
+            0,
+            nullptr);
+        PushConstants pushConstants = {
+            .destinationSize = {width, height},
+            .encodeSrgb = storageFormat != image.format,
+        };
+        Commands::pushConstants(
+            commandBuffer,
+            pipelineLayout.get(),
+            vk::ShaderStageFlagBits::eCompute,
+            pushConstants);
+        commandBuffer.dispatch(
+            (width + GroupSize - 1) / GroupSize,
+            (height + GroupSize - 1) / GroupSize,
+            1);
+
+        // The next pass reads this level
+        Commands::transitionImageLayout(
+            commandBuffer,
+            image.image.get(),
+            vk::ImageLayout::eGeneral,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            levelRange(pass + 1));
+    }
+
+    deletionQueue.retire(std::move(views), timelineValue);
+    return std::nullopt;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../shader_registry.h"
+#include "deletion_queue.h"
+#include "descriptor_allocator.h"
+#include "image.h"
+
+/**
+ * @brief Fills the mip chain of an image on the GPU.
+ *
+ * Formats that support linear filtered blits are downsampled level by level with vkCmdBlitImage.
+ * Everything else that can be written as rgba8 storage image (sRGB through a UNORM view) is
+ * downsampled with a 2x2 box filter in mip_downsample.comp instead.
+ */
+class MipGenerator
+{
+  public:
+    enum class Method
+    {
+        // Needs an image with transfer source usage
+        Blit,
+        // Needs an image with sampled and storage usage
+        Compute,
+        Unsupported,
+    };
+
+    enum class ErrorType
+    {
+        ShaderNotLoaded,
+        CreateSampler,
+        CreateLayout,
+        CreatePipeline,
+        UnsupportedFormat,
+        CreateImageView,
+        CreateDescriptors,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                vk::Result result;
+            } CreateSampler;
+            struct
+            {
+                vk::Result result;
+            } CreateLayout;
+            struct
+            {
+                vk::Result result;
+            } CreatePipeline;
+            struct
+            {
+                vk::Result result;
+            } CreateImageView;
+            struct
+            {
+                vk::Result result;
+            } CreateDescriptors;
+        };
+    };
+
+    // ShaderPaths::MipDownsample must be loaded as compute shader
+    static std::variant<MipGenerator, Error> create(
+        const vk::UniqueDevice& device,
+        vk::PhysicalDevice physicalDevice,
+        const ShaderRegistry& shaderRegistry);
+
+    Method methodFor(vk::Format format) const;
+
+    /**
+     * @brief Expects every level in TransferDstOptimal with level 0 filled, which is how
+     * Image::recordUpload leaves it, and leaves every level in ShaderReadOnlyOptimal.
+     *
+     * The compute path allocates a descriptor set per level from `descriptorAllocator`, which
+     * must not be reset before that submission is done, e.g. the one of the frame it's recorded
+     * in. Its views for the levels are retired in `deletionQueue` until `timelineValue`, the
+     * value of the submission that executes `commandBuffer` (GpuTimeline::getLastSubmitted() + 1
+     * if it's the next one)
+     */
+    std::optional<Error> generate(
+        vk::CommandBuffer commandBuffer,
+        const Image& image,
+        DescriptorAllocator& descriptorAllocator,
+        DeletionQueue& deletionQueue,
+        uint64_t timelineValue) const;
+
+  private:
+    MipGenerator(
+        vk::Device device,
+        vk::PhysicalDevice physicalDevice,
+        vk::UniqueSampler&& sampler,
+        vk::UniqueDescriptorSetLayout&& setLayout,
+        vk::UniquePipelineLayout&& pipelineLayout,
+        vk::UniquePipeline&& pipeline);
+
+    vk::Device device;
+    vk::PhysicalDevice physicalDevice;
+    vk::UniqueSampler sampler;
+    vk::UniqueDescriptorSetLayout setLayout;
+    vk::UniquePipelineLayout pipelineLayout;
+    vk::UniquePipeline pipeline;
+
+    void generateWithBlits(vk::CommandBuffer commandBuffer, const Image& image) const;
+    std::optional<Error> generateWithCompute(
+        vk::CommandBuffer commandBuffer,
+        const Image& image,
+        DescriptorAllocator& descriptorAllocator,
+        DeletionQueue& deletionQueue,
+        uint64_t timelineValue) const;
+};
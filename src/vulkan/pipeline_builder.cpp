@@ -1,5 +1,7 @@
 #include "pipeline_builder.h"
 
+#include "../checked.h"
+
 PipelineBuilder& PipelineBuilder::usingShaderRegistry(const ShaderRegistry& registry)
 {
     this->shaderRegistry = &registry;
@@ -18,6 +20,12 @@ PipelineBuilder& PipelineBuilder::usingDevice(vk::UniqueDevice& device)
     return *this;
 }
 
+PipelineBuilder& PipelineBuilder::usingPhysicalDevice(vk::PhysicalDevice physicalDevice)
+{
+    this->physicalDevice = physicalDevice;
+    return *this;
+}
+
 PipelineBuilder& PipelineBuilder::withVertexShader(const std::filesystem::path& path)
 {
     this->vertexShaderPathOpt = path;
@@ -60,7 +68,51 @@ PipelineBuilder& PipelineBuilder::withBlendState(Blend blend)
     return *this;
 }
 
+PipelineBuilder& PipelineBuilder::withPushConstants(vk::ShaderStageFlags stages, uint32_t size)
+{
+    this->pushConstantRange = vk::PushConstantRange{
+        .stageFlags = stages,
+        .offset = 0,
+        .size = size,
+    };
+    return *this;
+}
+
+PipelineBuilder& PipelineBuilder::withDescriptorSetLayouts(
+    std::span<const vk::DescriptorSetLayout> layouts)
+{
+    this->descriptorSetLayouts.assign(layouts.begin(), layouts.end());
+    return *this;
+}
+
 void PipelineBuilder::build(SelectedConfig& config)
+{
+    fillAll();
+
+    auto [crpRes, renderPass] = (*device)->createRenderPassUnique(renderPassInfo);
+    checkResult(crpRes);
+
+    auto [pipeline, pipelineLayout] = createPipeline(renderPass.get());
+
+    vk::Rect2D renderArea = {
+        .offset = {(int32_t)vport.x, (int32_t)vport.y},
+        .extent = {(uint32_t)vport.width, (uint32_t)vport.height}};
+
+    config.pipelineConfig.pipeline = std::move(pipeline);
+    config.pipelineConfig.layout = std::move(pipelineLayout);
+    config.pipelineConfig.renderPass = std::move(renderPass);
+    config.pipelineConfig.renderArea = renderArea;
+}
+
+PipelineHandle PipelineBuilder::build(GpuResources& resources, vk::RenderPass renderPass)
+{
+    fillAll();
+
+    auto [pipeline, pipelineLayout] = createPipeline(renderPass);
+    return resources.addPipeline(std::move(pipeline), std::move(pipelineLayout));
+}
+
+void PipelineBuilder::fillAll()
 {
     fillVertexInfo();
     fillShaderStageInfo();
@@ -71,12 +123,13 @@ void PipelineBuilder::build(SelectedConfig& config)
     fillRasterizerInfo();
     fillLayoutInfo();
     fillRenderPassInfo();
+}
 
+std::tuple<vk::UniquePipeline, vk::UniquePipelineLayout> PipelineBuilder::createPipeline(
+    vk::RenderPass renderPass)
+{
     auto [cplRes, pipelineLayout] = (*device)->createPipelineLayoutUnique(layoutInfo);
-    assert(cplRes == vk::Result::eSuccess);
-
-    auto [crpRes, renderPass] = (*device)->createRenderPassUnique(renderPassInfo);
-    assert(crpRes == vk::Result::eSuccess);
+    checkResult(cplRes);
 
     vk::GraphicsPipelineCreateInfo pipelineCreateInfo = {
         .stageCount = (uint32_t)shaderStages.size(),
@@ -89,9 +142,9 @@ void PipelineBuilder::build(SelectedConfig& config)
         .pMultisampleState = &multisampleInfo,
         .pDepthStencilState = nullptr,
         .pColorBlendState = &blendStateInfo,
-        .pDynamicState = nullptr,
+        .pDynamicState = dynamicStates.empty() ? nullptr : &dynamicStateInfo,
         .layout = pipelineLayout.get(),
-        .renderPass = renderPass.get(),
+        .renderPass = renderPass,
         .subpass = 0,
         .basePipelineHandle = nullptr,
         .basePipelineIndex = -1,
@@ -99,38 +152,19 @@ void PipelineBuilder::build(SelectedConfig& config)
 
     auto [cgpRes, pipeline] =
         (*device)->createGraphicsPipelineUnique(VK_NULL_HANDLE, pipelineCreateInfo);
-    assert(cgpRes == vk::Result::eSuccess);
-
-    vk::Rect2D renderArea = {
-        .offset = {(int32_t)vport.x, (int32_t)vport.y},
-        .extent = {(uint32_t)vport.width, (uint32_t)vport.height}};
+    checkResult(cgpRes);
 
-    config.pipelineConfig.pipeline = std::move(pipeline);
-    config.pipelineConfig.layout = std::move(pipelineLayout);
-    config.pipelineConfig.renderPass = std::move(renderPass);
-    config.pipelineConfig.renderArea = renderArea;
+    return {std::move(pipeline), std::move(pipelineLayout)};
 }
 
 void PipelineBuilder::fillVertexInfo()
 {
-    if(this->vertexAttributes.empty())
-    {
-        vertexInputInfo = vk::PipelineVertexInputStateCreateInfo{
-            .vertexBindingDescriptionCount = 0,
-            .pVertexBindingDescriptions = nullptr,
-            .vertexAttributeDescriptionCount = 0,
-            .pVertexAttributeDescriptions = nullptr,
-        };
-    }
-    else
-    {
-        vertexInputInfo = vk::PipelineVertexInputStateCreateInfo{
-            .vertexBindingDescriptionCount = 1,
-            .pVertexBindingDescriptions = &this->vertexBinding,
-            .vertexAttributeDescriptionCount = (uint32_t)this->vertexAttributes.size(),
-            .pVertexAttributeDescriptions = this->vertexAttributes.data(),
-        };
-    }
+    vertexInputInfo = vk::PipelineVertexInputStateCreateInfo{
+        .vertexBindingDescriptionCount = (uint32_t)this->vertexBindings.size(),
+        .pVertexBindingDescriptions = this->vertexBindings.data(),
+        .vertexAttributeDescriptionCount = (uint32_t)this->vertexAttributes.size(),
+        .pVertexAttributeDescriptions = this->vertexAttributes.data(),
+    };
 }
 
 void PipelineBuilder::fillShaderStageInfo()
@@ -170,6 +204,14 @@ void PipelineBuilder::fillInputAssemblyInfo()
         };
         return;
     }
+    if(primitiveTopology == PrimitiveTopology::TriangleStrip)
+    {
+        inputAssemblyInfo = vk::PipelineInputAssemblyStateCreateInfo{
+            .topology = vk::PrimitiveTopology::eTriangleStrip,
+            .primitiveRestartEnable = false,
+        };
+        return;
+    }
     assert(false);
 }
 
@@ -195,6 +237,31 @@ void PipelineBuilder::fillViewportInfo()
             .scissorCount = 1,
             .pScissors = &scissor,
         };
+        dynamicStates.clear();
+        return;
+    }
+    if(viewport == Viewport::Dynamic)
+    {
+        // Still used for the render area
+        vport = vk::Viewport{
+            .x = 0.0f,
+            .y = 0.0f,
+            .width = (float)config->resolutionWidth,
+            .height = (float)config->resolutionHeight,
+            .minDepth = 0.0f,
+            .maxDepth = 1.0f,
+        };
+        viewportInfo = vk::PipelineViewportStateCreateInfo{
+            .viewportCount = 1,
+            .pViewports = nullptr,
+            .scissorCount = 1,
+            .pScissors = nullptr,
+        };
+        dynamicStates = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+        dynamicStateInfo = vk::PipelineDynamicStateCreateInfo{
+            .dynamicStateCount = (uint32_t)dynamicStates.size(),
+            .pDynamicStates = dynamicStates.data(),
+        };
         return;
     }
     assert(false);
@@ -219,6 +286,29 @@ void PipelineBuilder::fillMultisampleInfo()
 
 void PipelineBuilder::fillBlendInfo()
 {
+    blendStateInfo = vk::PipelineColorBlendStateCreateInfo{
+        .logicOpEnable = false,
+        .logicOp = vk::LogicOp::eOr,
+        .attachmentCount = 1,
+        .pAttachments = &blendAttachmentInfo,
+        .blendConstants = vk::ArrayWrapper1D<float, 4>({0.0f, 0.0f, 0.0f, 0.0f}),
+    };
+
+    if(blend == Blend::Alpha)
+    {
+        blendAttachmentInfo = vk::PipelineColorBlendAttachmentState{
+            .blendEnable = true,
+            .srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
+            .dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+            .colorBlendOp = vk::BlendOp::eAdd,
+            .srcAlphaBlendFactor = vk::BlendFactor::eOne,
+            .dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
+            .alphaBlendOp = vk::BlendOp::eAdd,
+            .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG
+                              | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
+        };
+        return;
+    }
     if(blend == Blend::Disabled)
     {
         blendAttachmentInfo = vk::PipelineColorBlendAttachmentState{
@@ -232,14 +322,6 @@ void PipelineBuilder::fillBlendInfo()
             .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG
                               | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
         };
-
-        blendStateInfo = vk::PipelineColorBlendStateCreateInfo{
-            .logicOpEnable = false,
-            .logicOp = vk::LogicOp::eOr,
-            .attachmentCount = 1,
-            .pAttachments = &blendAttachmentInfo,
-            .blendConstants = vk::ArrayWrapper1D<float, 4>({0.0f, 0.0f, 0.0f, 0.0f}),
-        };
         return;
     }
     assert(false);
@@ -263,16 +345,41 @@ void PipelineBuilder::fillRasterizerInfo()
         };
         return;
     }
+    if(rasterizer == Rasterizer::NoCulling)
+    {
+        rasterizerInfo = vk::PipelineRasterizationStateCreateInfo{
+            .depthClampEnable = false,
+            .rasterizerDiscardEnable = false,
+            .polygonMode = vk::PolygonMode::eFill,
+            .cullMode = vk::CullModeFlagBits::eNone,
+            .frontFace = vk::FrontFace::eClockwise,
+            .depthBiasEnable = false,
+            .depthBiasConstantFactor = 0.0f,
+            .depthBiasClamp = 0.0f,
+            .depthBiasSlopeFactor = 0.0f,
+            .lineWidth = 1.0f,
+        };
+        return;
+    }
     assert(false);
 }
 
 void PipelineBuilder::fillLayoutInfo()
 {
+    if(pushConstantRange.has_value())
+    {
+        // The minimum every device supports
+        uint32_t maxSize = 128;
+        if(physicalDevice.has_value())
+            maxSize = physicalDevice->getProperties().limits.maxPushConstantsSize;
+        checkTrue(pushConstantRange->size <= maxSize);
+    }
+
     layoutInfo = vk::PipelineLayoutCreateInfo{
-        .setLayoutCount = 0,
-        .pSetLayouts = nullptr,
-        .pushConstantRangeCount = 0,
-        .pPushConstantRanges = nullptr,
+        .setLayoutCount = (uint32_t)descriptorSetLayouts.size(),
+        .pSetLayouts = descriptorSetLayouts.data(),
+        .pushConstantRangeCount = pushConstantRange.has_value() ? 1u : 0u,
+        .pPushConstantRanges = pushConstantRange.has_value() ? &pushConstantRange.value() : nullptr,
     };
 }
 
@@ -3,12 +3,16 @@
 #include <filesystem>
 #include <numeric>
 #include <optional>
+#include <span>
 #include <tuple>
+#include <type_traits>
 #include <vulkan/vulkan_raii.hpp>
 
 #include "../config.h"
 #include "../shader_registry.h"
 #include "../stl_utils.h"
+#include "gpu_resources.h"
+#include "vertex_layout.h"
 
 class PipelineBuilder
 {
@@ -17,17 +21,23 @@ class PipelineBuilder
   public:
     enum class PrimitiveTopology
     {
-        TriangleList
+        TriangleList,
+        TriangleStrip,
     };
 
     enum class Viewport
     {
-        Fullscreen
+        Fullscreen,
+        // Viewport and scissor are set with vkCmdSetViewport/vkCmdSetScissor, so the pipeline
+        // survives swapchain resizes
+        Dynamic,
     };
 
     enum class Rasterizer
     {
-        BackfaceCulling
+        BackfaceCulling,
+        // For geometry that can be mirrored, such as sprites with a negative size
+        NoCulling,
     };
 
     enum class Multisample
@@ -37,12 +47,16 @@ class PipelineBuilder
 
     enum class Blend
     {
-        Disabled
+        Disabled,
+        // Non-premultiplied "over"
+        Alpha,
     };
 
     Self usingShaderRegistry(const ShaderRegistry&);
     Self usingConfig(const UserConfig&);
     Self usingDevice(vk::UniqueDevice&);
+    // Optional, device limits such as maxPushConstantsSize are checked against it when building
+    Self usingPhysicalDevice(vk::PhysicalDevice);
 
     Self withVertexShader(const std::filesystem::path&);
     Self withFragmentShader(const std::filesystem::path&);
@@ -52,78 +66,72 @@ class PipelineBuilder
     Self withRasterizerState(Rasterizer);
     Self withMultisampleState(Multisample);
     Self withBlendState(Blend);
-
-    constexpr static uint32_t vkFormatSize(vk::Format format)
-    {
-        switch(format)
-        {
-            case vk::Format::eR32Sfloat: return sizeof(float);
-            case vk::Format::eR32G32Sfloat: return sizeof(float) * 2;
-            case vk::Format::eR32G32B32Sfloat: return sizeof(float) * 3;
-            case vk::Format::eR32G32B32A32Sfloat: return sizeof(float) * 4;
-            default: return 0;
-        }
-    }
-
-    template<typename T, typename... VkFormats>
-    Self withLinearVertexLayout(VkFormats... formats)
-    {
-        assert(sizeof(T) == (vkFormatSize(formats) + ...));
-        withLinearVertexLayout(formats...);
-        return *this;
-    }
-
-    template<typename... Rest>
-    Self withLinearVertexLayout(vk::Format format, Rest... rest)
+    Self withPushConstants(vk::ShaderStageFlags stages, uint32_t size);
+
+    /**
+     * @brief A push constant range sized from `Constants`, recorded with Commands::pushConstants.
+     * Only 128 bytes are guaranteed, so anything bigger needs `usingPhysicalDevice` to be checked
+     * against maxPushConstantsSize instead
+     */
+    template<typename Constants>
+    Self withPushConstants(vk::ShaderStageFlags stages)
     {
-        appendLinearVertexLayout(format);
-        if constexpr(sizeof...(rest) > 0)
-            withLinearVertexLayout(rest...);
-        else
-            withPerVertexData(
-                vertexAttributes.back().offset + vkFormatSize(vertexAttributes.back().format));
-
-        return *this;
+        static_assert(std::is_trivially_copyable_v<Constants>);
+        static_assert(sizeof(Constants) % 4 == 0, "Push constant sizes are multiples of 4");
+        return withPushConstants(stages, sizeof(Constants));
     }
+    // Set layouts of the pipeline layout in set order, e.g. BindlessDescriptors::getSetLayouts
+    Self withDescriptorSetLayouts(std::span<const vk::DescriptorSetLayout> layouts);
 
-    Self withPerVertexData(uint32_t stride)
+    // Replaces all vertex streams with `layout`
+    template<typename Vertex, size_t N>
+    Self withVertexLayout(const VertexLayout<Vertex, N>& layout)
     {
-        this->vertexBinding = {
-            .binding = 0,
-            .stride = stride,
-            .inputRate = vk::VertexInputRate::eVertex,
-        };
-        return *this;
+        this->vertexBindings.clear();
+        this->vertexAttributes.clear();
+        return withVertexStream(layout);
     }
 
-    Self appendLinearVertexLayout(vk::Format format)
+    /**
+     * @brief Adds `layout` as the next vertex stream, e.g. positions only, then the remaining
+     * attributes, then per-instance data. The stream's binding is the number of streams added
+     * before it and its locations continue after theirs, so the shader declares the inputs of all
+     * streams in order
+     */
+    template<typename Vertex, size_t N>
+    Self withVertexStream(const VertexLayout<Vertex, N>& layout)
     {
-        // Unsupported variable, add it to `vkFormatSize`
-        assert(vkFormatSize(format) != 0);
+        uint32_t binding = (uint32_t)this->vertexBindings.size();
+        uint32_t firstLocation = (uint32_t)this->vertexAttributes.size();
 
-        uint32_t offset = 0;
-        if(!vertexAttributes.empty())
-            offset = vertexAttributes.back().offset + vkFormatSize(vertexAttributes.back().format);
-
-        this->vertexAttributes.push_back({
-            .location = (uint32_t)this->vertexAttributes.size(),
-            .binding = 0,
-            .format = format,
-            .offset = offset,
-        });
+        vk::VertexInputBindingDescription bindingDescription = layout.binding;
+        bindingDescription.binding = binding;
+        this->vertexBindings.push_back(bindingDescription);
 
+        for(vk::VertexInputAttributeDescription attribute : layout.attributes)
+        {
+            attribute.binding = binding;
+            attribute.location += firstLocation;
+            this->vertexAttributes.push_back(attribute);
+        }
         return *this;
     }
 
     void build(SelectedConfig&);
+    /**
+     * @brief Builds another pipeline for a render pass that already exists, such as the one made by
+     * `build(SelectedConfig&)`
+     */
+    PipelineHandle build(GpuResources& resources, vk::RenderPass renderPass);
 
   private:
-    vk::VertexInputBindingDescription vertexBinding;
+    std::vector<vk::VertexInputBindingDescription> vertexBindings;
     std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
 
     const ShaderRegistry* shaderRegistry;
     const UserConfig* config;
     vk::UniqueDevice* device;
+    std::optional<vk::PhysicalDevice> physicalDevice;
 
     std::optional<std::filesystem::path> vertexShaderPathOpt;
     std::optional<std::filesystem::path> fragmentShaderPathOpt;
@@ -133,6 +141,8 @@ class PipelineBuilder
     Rasterizer rasterizer;
     Multisample multisample;
     Blend blend;
+    std::optional<vk::PushConstantRange> pushConstantRange;
+    std::vector<vk::DescriptorSetLayout> descriptorSetLayouts;
 
     void fillVertexInfo();
     void fillShaderStageInfo();
@@ -143,6 +153,10 @@ class PipelineBuilder
     void fillRasterizerInfo();
     void fillLayoutInfo();
     void fillRenderPassInfo();
+    void fillAll();
+
+    std::tuple<vk::UniquePipeline, vk::UniquePipelineLayout> createPipeline(
+        vk::RenderPass renderPass);
 
     std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
     vk::PipelineVertexInputStateCreateInfo vertexInputInfo;
@@ -150,6 +164,8 @@ class PipelineBuilder
     vk::PipelineViewportStateCreateInfo viewportInfo;
     vk::Rect2D scissor;
     vk::Viewport vport; // Temp name
+    std::vector<vk::DynamicState> dynamicStates;
+    vk::PipelineDynamicStateCreateInfo dynamicStateInfo;
     vk::PipelineLayoutCreateInfo layoutInfo;
     vk::PipelineMultisampleStateCreateInfo multisampleInfo;
     vk::PipelineColorBlendAttachmentState blendAttachmentInfo;
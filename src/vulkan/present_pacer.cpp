@@ -0,0 +1,65 @@
+#include "present_pacer.h"
+
+PresentPacer::PresentPacer(vk::Device device, bool presentWait, uint32_t maxQueuedPresents)
+    : device(device)
+    , enabled(presentWait && maxQueuedPresents > 0)
+    , maxQueuedPresents(maxQueuedPresents)
+    , lastPresentId(0)
+    , lastWaitedId(0)
+    , inputTime(Clock::now())
+    , inputTimes(maxQueuedPresents + 1)
+    , presentIdInfo()
+{
+}
+
+std::optional<std::chrono::nanoseconds> PresentPacer::wait(vk::SwapchainKHR swapchain)
+{
+    if(!enabled || lastPresentId <= maxQueuedPresents)
+        return std::nullopt;
+
+    uint64_t presentId = lastPresentId - maxQueuedPresents;
+    if(presentId <= lastWaitedId)
+        return std::nullopt;
+
+    // Don't hang forever on a present that never happens, e.g. when the window is hidden. An
+    // out-of-date swapchain is picked up by the next acquire anyway
+    constexpr uint64_t timeout = 100'000'000;
+    auto res = device.waitForPresentKHR(swapchain, presentId, timeout);
+    if(res != vk::Result::eSuccess)
+        return std::nullopt;
+
+    lastWaitedId = presentId;
+    return Clock::now() - inputTimes[presentId % inputTimes.size()];
+}
+
+void PresentPacer::markInput()
+{
+    inputTime = Clock::now();
+}
+
+void PresentPacer::attach(vk::PresentInfoKHR& presentInfo)
+{
+    if(!enabled)
+        return;
+
+    lastPresentId++;
+    inputTimes[lastPresentId % inputTimes.size()] = inputTime;
+
+    presentIdInfo = {
+        .pNext = presentInfo.pNext,
+        .swapchainCount = 1,
+        .pPresentIds = &lastPresentId,
+    };
+    presentInfo.pNext = &presentIdInfo;
+}
+
+void PresentPacer::resetSwapchain()
+{
+    lastPresentId = 0;
+    lastWaitedId = 0;
+}
+
+bool PresentPacer::isEnabled() const
+{
+    return enabled;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+/**
+ * @brief Caps how many presents can be queued up ahead of the display using VK_KHR_present_id and
+ * VK_KHR_present_wait, and measures input-to-present latency along the way.
+ *
+ * Without the extensions (or with `maxQueuedPresents` 0) every function is a no-op and frames are
+ * only throttled by frames in flight and the swapchain.
+ */
+class PresentPacer
+{
+    using Clock = std::chrono::steady_clock;
+
+  public:
+    // `presentWait` is SelectedConfig::deviceFeatures.presentWait
+    PresentPacer(vk::Device device, bool presentWait, uint32_t maxQueuedPresents);
+
+    /**
+     * @brief Blocks until no more than `maxQueuedPresents` presents are still waiting to reach the
+     * display. Call right before sampling input so the input is as fresh as possible once shown.
+     *
+     * Returns the input-to-present latency of the present that was waited on, if it waited
+     */
+    std::optional<std::chrono::nanoseconds> wait(vk::SwapchainKHR swapchain);
+    // Call right after sampling input
+    void markInput();
+    // Chains a vk::PresentIdKHR into `presentInfo`. It stays valid until the next call
+    void attach(vk::PresentInfoKHR& presentInfo);
+    // Present ids are per swapchain, so this must be called when the swapchain is recreated
+    void resetSwapchain();
+
+    bool isEnabled() const;
+
+  private:
+    vk::Device device;
+    bool enabled;
+    uint32_t maxQueuedPresents;
+
+    uint64_t lastPresentId;
+    uint64_t lastWaitedId;
+    Clock::time_point inputTime;
+    // Indexed by present id modulo size; only the last maxQueuedPresents + 1 are ever needed
+    std::vector<Clock::time_point> inputTimes;
+    vk::PresentIdKHR presentIdInfo;
+};
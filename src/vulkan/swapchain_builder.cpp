@@ -1,5 +1,10 @@
 #include "swapchain_builder.h"
 
+#include <algorithm>
+
+#include "../checked.h"
+#include "../stl_utils.h"
+
 using Self = SwapchainBuilder;
 
 SwapchainBuilder::SwapchainBuilder(
@@ -13,17 +18,60 @@ SwapchainBuilder::SwapchainBuilder(
 }
 
 std::optional<SwapchainBuilder::Error> SwapchainBuilder::build(
-    SelectedConfig::SwapChain& swapChainData)
+    SelectedConfig::SwapChain& swapChainData,
+    vk::SwapchainKHR oldSwapchain)
 {
     Error error;
 
+    uint32_t imageCount = config.backbufferCount;
+    vk::PresentModeKHR selectedPresentMode = presentMode.value_or(vk::PresentModeKHR::eFifo);
+    if(physicalDevice.has_value())
+    {
+        auto [gscRes, capabilities] =
+            physicalDevice.value().getSurfaceCapabilitiesKHR(surface.get());
+        if(gscRes != vk::Result::eSuccess)
+        {
+            error.type = ErrorType::SurfaceQuery;
+            error.SurfaceQuery.result = gscRes;
+            return error;
+        }
+
+        // maxImageCount is 0 if there's no limit
+        imageCount = std::max(imageCount, capabilities.minImageCount);
+        if(capabilities.maxImageCount != 0)
+            imageCount = std::min(imageCount, capabilities.maxImageCount);
+
+        if(!presentMode.has_value() && !presentModePreference.empty())
+        {
+            auto [gpmRes, supportedModes] =
+                physicalDevice.value().getSurfacePresentModesKHR(surface.get());
+            if(gpmRes != vk::Result::eSuccess)
+            {
+                error.type = ErrorType::SurfaceQuery;
+                error.SurfaceQuery.result = gpmRes;
+                return error;
+            }
+
+            // FIFO is the only mode that's guaranteed to be supported
+            auto iter = std::find_if(
+                entire_collection(presentModePreference),
+                [&supportedModes](vk::PresentModeKHR mode) {
+                    return std::find(entire_collection(supportedModes), mode)
+                           != supportedModes.end();
+                });
+            if(iter != presentModePreference.end())
+                selectedPresentMode = *iter;
+        }
+    }
+
+    vk::Extent2D imageExtent =
+        extent.value_or(vk::Extent2D{config.resolutionWidth, config.resolutionHeight});
     vk::SwapchainCreateInfoKHR swapchainCreateInfo = {
         .surface = surface.get(),
-        .minImageCount = config.backbufferCount,
+        .minImageCount = imageCount,
         .imageFormat = this->backbufferFormat.value_or(vk::Format::eB8G8R8A8Snorm),
         .imageColorSpace = this->backbufferColorSpace.value_or(vk::ColorSpaceKHR::eSrgbNonlinear),
-        .imageExtent =
-            extent.value_or(vk::Extent2D{config.resolutionWidth, config.resolutionHeight}),
+        .imageExtent = imageExtent,
         .imageArrayLayers = 1,
         .imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
         .imageSharingMode = vk::SharingMode::eExclusive,
@@ -31,9 +79,9 @@ std::optional<SwapchainBuilder::Error> SwapchainBuilder::build(
         .pQueueFamilyIndices = nullptr,
         .preTransform = vk::SurfaceTransformFlagBitsKHR::eIdentity,
         .compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
-        .presentMode = presentMode.value_or(vk::PresentModeKHR::eFifo),
+        .presentMode = selectedPresentMode,
         .clipped = VK_TRUE,
-        .oldSwapchain = VK_NULL_HANDLE,
+        .oldSwapchain = oldSwapchain,
     };
 
     auto [csRes, swapchain] = device->createSwapchainKHRUnique(swapchainCreateInfo);
@@ -99,21 +147,39 @@ std::optional<SwapchainBuilder::Error> SwapchainBuilder::build(
                 .renderPass = this->renderPass.value()->get(),
                 .attachmentCount = 1,
                 .pAttachments = &swapchainImageView.get(),
-                .width = config.resolutionWidth,
-                .height = config.resolutionHeight,
+                .width = imageExtent.width,
+                .height = imageExtent.height,
                 .layers = 1,
             };
 
             auto [cfRes, framebuffer] = device->createFramebufferUnique(framebufferCreateInfo);
-            assert(cfRes == vk::Result::eSuccess);
+            checkResult(cfRes);
             framebuffers.push_back(std::move(framebuffer));
         }
     }
 
+    std::vector<vk::UniqueSemaphore> renderFinished;
+    renderFinished.reserve(images.size());
+    for(size_t i = 0; i < images.size(); ++i)
+    {
+        auto [csRes, semaphore] = device->createSemaphoreUnique({});
+        if(csRes != vk::Result::eSuccess)
+        {
+            error.type = ErrorType::OutOfMemory;
+            error.OutOfMemory.result = csRes;
+            error.OutOfMemory.message = "vkCreateSemaphore - swapchain";
+            return error;
+        }
+        renderFinished.push_back(std::move(semaphore));
+    }
+
     swapChainData.swapchain = std::move(swapchain);
+    swapChainData.presentMode = selectedPresentMode;
+    swapChainData.extent = imageExtent;
     swapChainData.images = std::move(images);
     swapChainData.imageViews = std::move(imageViews);
     swapChainData.framebuffers = std::move(framebuffers);
+    swapChainData.renderFinished = std::move(renderFinished);
 
     return std::nullopt;
 }
@@ -130,12 +196,24 @@ Self SwapchainBuilder::withColorSpace(vk::ColorSpaceKHR colorSpace)
     return *this;
 }
 
+Self SwapchainBuilder::usingPhysicalDevice(vk::PhysicalDevice physicalDevice)
+{
+    this->physicalDevice = physicalDevice;
+    return *this;
+}
+
 Self SwapchainBuilder::withPresentMode(vk::PresentModeKHR presentMode)
 {
     this->presentMode = presentMode;
     return *this;
 }
 
+Self SwapchainBuilder::withPresentModePreference(std::vector<vk::PresentModeKHR> preference)
+{
+    this->presentModePreference = std::move(preference);
+    return *this;
+}
+
 Self SwapchainBuilder::createFramebuffersFor(vk::UniqueRenderPass& renderPass)
 {
     this->renderPass = &renderPass;
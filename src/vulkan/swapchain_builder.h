@@ -15,6 +15,7 @@ class SwapchainBuilder
     enum class ErrorType
     {
         SwapChainCreationError,
+        SurfaceQuery,
         OutOfMemory,
     };
 
@@ -28,6 +29,10 @@ class SwapchainBuilder
                 vk::Result result;
             } SwapChainCreationError;
             struct
+            {
+                vk::Result result;
+            } SurfaceQuery;
+            struct
             {
                 const char* message;
                 vk::Result result;
@@ -42,10 +47,20 @@ class SwapchainBuilder
 
     Self withBackbufferFormat(vk::Format);
     Self withColorSpace(vk::ColorSpaceKHR);
+    // Needed to query the surface for present modes and image counts. Without it the present mode
+    // and image count are used as given
+    Self usingPhysicalDevice(vk::PhysicalDevice);
     Self withPresentMode(vk::PresentModeKHR);
+    // The first mode in the list that the surface supports, FIFO if none are. Requires
+    // `usingPhysicalDevice`
+    Self withPresentModePreference(std::vector<vk::PresentModeKHR>);
     Self createFramebuffersFor(vk::UniqueRenderPass&);
 
-    std::optional<Error> build(SelectedConfig::SwapChain& swapChainData);
+    // `oldSwapchain` is retired by the new swapchain, but its images stay valid until it is
+    // destroyed, so frames that still use them can finish
+    std::optional<Error> build(
+        SelectedConfig::SwapChain& swapChainData,
+        vk::SwapchainKHR oldSwapchain = VK_NULL_HANDLE);
 
   private:
     const UserConfig& config;
@@ -56,5 +71,7 @@ class SwapchainBuilder
     std::optional<vk::Format> backbufferFormat;
     std::optional<vk::ColorSpaceKHR> backbufferColorSpace;
     std::optional<vk::PresentModeKHR> presentMode;
+    std::vector<vk::PresentModeKHR> presentModePreference;
+    std::optional<vk::PhysicalDevice> physicalDevice;
     std::optional<vk::Extent2D> extent;
 };
\ No newline at end of file
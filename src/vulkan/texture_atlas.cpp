@@ -0,0 +1,365 @@
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#include "../stl_utils.h"
+#include "commands.h"
+
+using Builder = TextureAtlas::Builder;
+
+namespace
+{
+    constexpr uint32_t TexelSize = 4;
+}
+
+Builder::Builder(const vk::UniqueDevice& device)
+    : device(device)
+    , memoryProperties()
+    , pageSize(2048)
+    , maxPages(4)
+    , format(vk::Format::eR8G8B8A8Srgb)
+    , padding(1)
+{
+}
+
+Builder& Builder::usingMemoryProperties(const vk::PhysicalDeviceMemoryProperties& memoryProperties)
+{
+    this->memoryProperties = memoryProperties;
+    return *this;
+}
+
+Builder& Builder::withPageSize(uint32_t size)
+{
+    this->pageSize = size;
+    return *this;
+}
+
+Builder& Builder::withMaxPages(uint32_t count)
+{
+    this->maxPages = count;
+    return *this;
+}
+
+Builder& Builder::withFormat(vk::Format format)
+{
+    this->format = format;
+    return *this;
+}
+
+Builder& Builder::withPadding(uint32_t padding)
+{
+    this->padding = padding;
+    return *this;
+}
+
+std::variant<TextureAtlas, TextureAtlas::Error> Builder::build() const
+{
+    assert(maxPages > 0);
+
+    TextureAtlas atlas(device, memoryProperties, pageSize, maxPages, format, padding);
+    if(auto error = atlas.addPage())
+        return error.value();
+    return atlas;
+}
+
+TextureAtlas::TextureAtlas(
+    const vk::UniqueDevice& device,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    uint32_t pageSize,
+    uint32_t maxPages,
+    vk::Format format,
+    uint32_t padding)
+    : device(device)
+    , memoryProperties(memoryProperties)
+    , pageSize(pageSize)
+    , maxPages(maxPages)
+    , format(format)
+    , padding(padding)
+{
+}
+
+std::variant<AtlasRegionHandle, TextureAtlas::Error> TextureAtlas::add(
+    uint32_t width,
+    uint32_t height,
+    const void* texels,
+    TransientBuffer& staging,
+    uint64_t frame)
+{
+    assert(width > 0 && height > 0);
+    Error error = {};
+    uint32_t paddedWidth = width + 2 * padding;
+    uint32_t paddedHeight = height + 2 * padding;
+
+    // Staging is taken last, a full atlas would otherwise waste it for the rest of the frame
+    auto allocateVar = allocate(paddedWidth, paddedHeight, frame);
+    if(std::holds_alternative<Error>(allocateVar))
+        return std::get<Error>(allocateVar);
+    auto [pageIndex, rect] = std::get<std::pair<uint32_t, PackedRect>>(allocateVar);
+
+    auto allocation = staging.allocate(
+        (vk::DeviceSize)paddedWidth * paddedHeight * TexelSize,
+        TexelSize);
+    if(!allocation.has_value())
+    {
+        pages[pageIndex].packer.release(rect);
+        error.type = ErrorType::StagingFull;
+        return error;
+    }
+
+    // The padding repeats the edge texels. Staging memory is usually write-combined, so it's
+    // filled strictly in order
+    const auto* source = (const uint32_t*)texels;
+    auto* destination = (uint32_t*)allocation->data;
+    for(uint32_t y = 0; y < paddedHeight; ++y)
+    {
+        uint32_t sourceY = std::clamp(y, padding, padding + height - 1) - padding;
+        const uint32_t* sourceRow = source + (size_t)sourceY * width;
+        uint32_t* destinationRow = destination + (size_t)y * paddedWidth;
+
+        for(uint32_t x = 0; x < padding; ++x)
+            destinationRow[x] = sourceRow[0];
+        std::memcpy(destinationRow + padding, sourceRow, width * TexelSize);
+        for(uint32_t x = 0; x < padding; ++x)
+            destinationRow[padding + width + x] = sourceRow[width - 1];
+    }
+
+    Page& page = pages[pageIndex];
+    page.pendingCopies.push_back(PendingCopy{
+        .buffer = allocation->buffer,
+        .copy =
+            {
+                .bufferOffset = allocation->offset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource =
+                    {
+                        .aspectMask = vk::ImageAspectFlagBits::eColor,
+                        .mipLevel = 0,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                .imageOffset = {(int32_t)rect.x, (int32_t)rect.y, 0},
+                .imageExtent = {paddedWidth, paddedHeight, 1},
+            },
+    });
+    page.regionCount++;
+    page.lastUsed = std::max(page.lastUsed, frame);
+
+    return regions.create(RegionInfo{.page = pageIndex, .rect = rect, .lastUsed = frame});
+}
+
+std::optional<TextureAtlas::Region> TextureAtlas::use(AtlasRegionHandle handle, uint64_t frame)
+{
+    RegionInfo* info = regions.get<RegionInfo>(handle);
+    if(!info)
+        return std::nullopt;
+
+    info->lastUsed = frame;
+    Page& page = pages[info->page];
+    page.lastUsed = std::max(page.lastUsed, frame);
+
+    float scale = 1.0f / (float)pageSize;
+    const PackedRect& rect = info->rect;
+    return Region{
+        .page = info->page,
+        .uvRect =
+            {
+                (float)(rect.x + padding) * scale,
+                (float)(rect.y + padding) * scale,
+                (float)(rect.x + rect.width - padding) * scale,
+                (float)(rect.y + rect.height - padding) * scale,
+            },
+    };
+}
+
+void TextureAtlas::remove(AtlasRegionHandle handle)
+{
+    auto removed = regions.destroy(handle);
+    if(!removed.has_value())
+        return;
+
+    auto [info] = removed.value();
+    Page& page = pages[info.page];
+    // Otherwise its copy could overlap with a region that takes its place before the upload
+    std::erase_if(page.pendingCopies, [&](const PendingCopy& pending) {
+        return pending.copy.imageOffset.x == (int32_t)info.rect.x
+               && pending.copy.imageOffset.y == (int32_t)info.rect.y;
+    });
+    assert(page.regionCount > 0);
+    page.regionCount--;
+    // Free rects are never merged, so an empty page starts over instead
+    if(page.regionCount == 0)
+        page.packer.reset();
+    else
+        page.packer.release(info.rect);
+}
+
+uint32_t TextureAtlas::evictUnused(uint64_t frame, uint64_t maxAge)
+{
+    uint32_t evicted = 0;
+    // Backwards since removing moves the last region into the removed one's place
+    for(uint32_t i = regions.size(); i > 0; --i)
+    {
+        const RegionInfo& info = regions.all<RegionInfo>()[i - 1];
+        if(info.lastUsed + maxAge < frame)
+        {
+            remove(regions.handleAt(i - 1));
+            evicted++;
+        }
+    }
+    return evicted;
+}
+
+void TextureAtlas::recordUploads(vk::CommandBuffer commandBuffer)
+{
+    for(Page& page : pages)
+    {
+        if(!page.isNew && page.pendingCopies.empty())
+            continue;
+
+        // Waits for every earlier read of the page, including other frames in flight
+        Commands::transitionImageLayout(
+            commandBuffer,
+            page.image.image.get(),
+            page.isNew ? vk::ImageLayout::eUndefined : vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::ImageLayout::eTransferDstOptimal,
+            page.image.allLevels());
+
+        // Unpacked space is transparent instead of garbage
+        if(page.isNew)
+        {
+            vk::ImageSubresourceRange subresources = page.image.allLevels();
+            vk::ClearColorValue transparent = {std::array<float, 4>({0.0f, 0.0f, 0.0f, 0.0f})};
+            commandBuffer.clearColorImage(
+                page.image.image.get(),
+                vk::ImageLayout::eTransferDstOptimal,
+                &transparent,
+                1,
+                &subresources);
+        }
+
+        // One command per staging buffer, which is usually just one
+        std::vector<vk::BufferImageCopy> copies;
+        for(size_t first = 0; first < page.pendingCopies.size();)
+        {
+            vk::Buffer buffer = page.pendingCopies[first].buffer;
+            copies.clear();
+            size_t end = first;
+            for(; end < page.pendingCopies.size() && page.pendingCopies[end].buffer == buffer;
+                ++end)
+                copies.push_back(page.pendingCopies[end].copy);
+
+            commandBuffer.copyBufferToImage(
+                buffer,
+                page.image.image.get(),
+                vk::ImageLayout::eTransferDstOptimal,
+                (uint32_t)copies.size(),
+                copies.data());
+            first = end;
+        }
+
+        Commands::transitionImageLayout(
+            commandBuffer,
+            page.image.image.get(),
+            vk::ImageLayout::eTransferDstOptimal,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            page.image.allLevels());
+
+        page.isNew = false;
+        page.pendingCopies.clear();
+    }
+}
+
+vk::ImageView TextureAtlas::getPageView(uint32_t page) const
+{
+    return pages[page].image.view.get();
+}
+
+uint32_t TextureAtlas::getPageCount() const
+{
+    return (uint32_t)pages.size();
+}
+
+uint32_t TextureAtlas::getRegionCount() const
+{
+    return regions.size();
+}
+
+std::optional<TextureAtlas::Error> TextureAtlas::addPage()
+{
+    auto imageVar = Image::Builder(device)
+                        .withExtent(pageSize, pageSize)
+                        .withFormat(format)
+                        .withTransferDestUsage()
+                        .withSampledUsage()
+                        .withMemoryProperties(memoryProperties)
+                        .build();
+    if(std::holds_alternative<Image::Builder::Error>(imageVar))
+    {
+        Error error = {};
+        error.type = ErrorType::CreatePage;
+        error.CreatePage.error = std::get<Image::Builder::Error>(imageVar);
+        return error;
+    }
+
+    pages.push_back(Page{
+        .image = std::move(std::get<Image>(imageVar)),
+        .packer = SkylinePacker(pageSize, pageSize),
+        .regionCount = 0,
+        .lastUsed = 0,
+        .isNew = true,
+        .pendingCopies = {},
+    });
+    return std::nullopt;
+}
+
+std::variant<std::pair<uint32_t, PackedRect>, TextureAtlas::Error> TextureAtlas::allocate(
+    uint32_t width,
+    uint32_t height,
+    uint64_t frame)
+{
+    Error error = {};
+    error.type = ErrorType::Full;
+    if(width > pageSize || height > pageSize)
+        return error;
+
+    for(uint32_t i = 0; i < pages.size(); ++i)
+    {
+        if(auto rect = pages[i].packer.insert(width, height))
+            return std::pair(i, rect.value());
+    }
+
+    if(pages.size() < maxPages)
+    {
+        if(auto pageError = addPage())
+            return pageError.value();
+        uint32_t page = (uint32_t)pages.size() - 1;
+        return std::pair(page, pages[page].packer.insert(width, height).value());
+    }
+
+    // Regions used by the current frame can't be overwritten, everything older is ordered by
+    // the upload barriers
+    auto lru = std::min_element(entire_collection(pages), [](const Page& a, const Page& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    if(lru->lastUsed >= frame)
+        return error;
+
+    uint32_t page = (uint32_t)(lru - pages.begin());
+    evictPage(page);
+    return std::pair(page, pages[page].packer.insert(width, height).value());
+}
+
+void TextureAtlas::evictPage(uint32_t page)
+{
+    for(uint32_t i = regions.size(); i > 0; --i)
+    {
+        if(regions.all<RegionInfo>()[i - 1].page == page)
+            remove(regions.handleAt(i - 1));
+    }
+    pages[page].packer.reset();
+    pages[page].lastUsed = 0;
+}
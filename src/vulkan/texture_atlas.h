@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../handle_pool.h"
+#include "../skyline_packer.h"
+#include "image.h"
+#include "transient_buffer.h"
+
+struct AtlasRegionTag;
+using AtlasRegionHandle = Handle<AtlasRegionTag>;
+
+/**
+ * @brief Packs many small images into a few large pages so sprites using them can share draws.
+ *
+ * Regions are added at runtime: the texels are staged in the frame's TransientBuffer and copied
+ * into their page by `recordUploads`, so adding one never stalls. Every region remembers the last
+ * frame it was used in. `evictUnused` drops regions that haven't been used for a while, and when
+ * every page is full and no more pages may be created, the least recently used page is emptied
+ * entirely. Evicted handles become invalid, so users find out through `use` and add the region
+ * again.
+ *
+ * Overwriting evicted regions is safe while older frames are still in flight since uploads are
+ * ordered after all earlier fragment shader reads on the queue.
+ */
+class TextureAtlas
+{
+  public:
+    struct Region
+    {
+        uint32_t page;
+        // u0, v0, u1, v1 without the padding, matching Sprite::uvRect
+        glm::vec4 uvRect;
+    };
+
+    enum class ErrorType
+    {
+        // The region doesn't fit in a page, or every page is in use by the current frame
+        Full,
+        StagingFull,
+        CreatePage,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                Image::Builder::Error error;
+            } CreatePage;
+        };
+    };
+
+    class Builder
+    {
+        using Self = Builder;
+
+      public:
+        Builder(const vk::UniqueDevice&);
+
+        Self& usingMemoryProperties(const vk::PhysicalDeviceMemoryProperties&);
+        // Pages are square
+        Self& withPageSize(uint32_t);
+        Self& withMaxPages(uint32_t);
+        // Only formats with 4 byte texels are supported
+        Self& withFormat(vk::Format);
+        // Texels around every region that repeat its edges, so linear filtering doesn't pick up
+        // the neighbours
+        Self& withPadding(uint32_t);
+
+        // Creates the first page
+        std::variant<TextureAtlas, Error> build() const;
+
+      private:
+        const vk::UniqueDevice& device;
+        vk::PhysicalDeviceMemoryProperties memoryProperties;
+
+        uint32_t pageSize;
+        uint32_t maxPages;
+        vk::Format format;
+        uint32_t padding;
+    };
+
+    /**
+     * @brief Packs a `width` x `height` image with tightly packed rows of `texels` and stages it in
+     * `staging`, which must be the transient buffer of the frame that calls `recordUploads` next.
+     * `frame` is any counter that increases by one every frame
+     */
+    std::variant<AtlasRegionHandle, Error> add(
+        uint32_t width,
+        uint32_t height,
+        const void* texels,
+        TransientBuffer& staging,
+        uint64_t frame);
+    // Marks the region as used in `frame`. Returns std::nullopt if it has been evicted
+    std::optional<Region> use(AtlasRegionHandle handle, uint64_t frame);
+    void remove(AtlasRegionHandle handle);
+    // Removes regions that weren't used in the last `maxAge` frames. Returns how many
+    uint32_t evictUnused(uint64_t frame, uint64_t maxAge);
+
+    /**
+     * @brief Copies everything added since the last call into the pages and transitions them for
+     * sampling in fragment shaders. Must be recorded outside of a render pass
+     */
+    void recordUploads(vk::CommandBuffer commandBuffer);
+
+    vk::ImageView getPageView(uint32_t page) const;
+    uint32_t getPageCount() const;
+    uint32_t getRegionCount() const;
+
+  private:
+    struct PendingCopy
+    {
+        vk::Buffer buffer;
+        vk::BufferImageCopy copy;
+    };
+
+    struct Page
+    {
+        Image image;
+        SkylinePacker packer;
+        uint32_t regionCount;
+        // Most recent use of any of its regions
+        uint64_t lastUsed;
+        // Still in VK_IMAGE_LAYOUT_UNDEFINED
+        bool isNew;
+        std::vector<PendingCopy> pendingCopies;
+    };
+
+    struct RegionInfo
+    {
+        uint32_t page;
+        // Padding included
+        PackedRect rect;
+        uint64_t lastUsed;
+    };
+
+    TextureAtlas(
+        const vk::UniqueDevice& device,
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+        uint32_t pageSize,
+        uint32_t maxPages,
+        vk::Format format,
+        uint32_t padding);
+
+    const vk::UniqueDevice& device;
+    vk::PhysicalDeviceMemoryProperties memoryProperties;
+    uint32_t pageSize;
+    uint32_t maxPages;
+    vk::Format format;
+    uint32_t padding;
+
+    std::vector<Page> pages;
+    HandlePool<AtlasRegionTag, RegionInfo> regions;
+
+    std::optional<Error> addPage();
+    // Finds space in an existing page, a new page or the least recently used page, in that order
+    std::variant<std::pair<uint32_t, PackedRect>, Error> allocate(
+        uint32_t width,
+        uint32_t height,
+        uint64_t frame);
+    void evictPage(uint32_t page);
+};
@@ -0,0 +1,154 @@
+#include "texture_residency.h"
+
+#include <algorithm>
+
+#include "../stl_utils.h"
+
+namespace
+{
+    // Textures that weren't used for this many frames only keep their tail
+    constexpr uint64_t UnusedAge = 120;
+}
+
+vk::DeviceSize TextureResidency::budgetFromMemoryProperties(
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    float fraction)
+{
+    vk::DeviceSize largestHeap = 0;
+    for(uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        const vk::MemoryHeap& heap = memoryProperties.memoryHeaps[i];
+        if(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+            largestHeap = std::max(largestHeap, heap.size);
+    }
+    return (vk::DeviceSize)((double)largestHeap * fraction);
+}
+
+TextureResidency::TextureResidency(TextureStreamer& streamer, vk::DeviceSize budget)
+    : streamer(streamer)
+    , budget(budget)
+    , plannedBytes(0)
+{
+}
+
+void TextureResidency::add(StreamedTextureHandle handle, float priority)
+{
+    auto tailLevel = streamer.getTailLevel(handle);
+    if(!tailLevel.has_value())
+        return;
+
+    if(handle.index() >= entries.size())
+        entries.resize(handle.index() + 1);
+    entries[handle.index()] = Entry{
+        .handle = handle,
+        .priority = priority,
+        .lastUsed = 0,
+        // Until it's used
+        .wantedLevel = tailLevel.value(),
+        .tailLevel = tailLevel.value(),
+        .level = tailLevel.value(),
+    };
+}
+
+void TextureResidency::remove(StreamedTextureHandle handle)
+{
+    if(Entry* entry = find(handle))
+        entry->handle = {};
+}
+
+void TextureResidency::markUsed(StreamedTextureHandle handle, uint64_t frame, uint32_t wantedLevel)
+{
+    Entry* entry = find(handle);
+    if(!entry)
+        return;
+
+    // Several users in one frame get the most detailed level any of them needs
+    if(entry->lastUsed == frame)
+        entry->wantedLevel = std::min(entry->wantedLevel, wantedLevel);
+    else
+        entry->wantedLevel = wantedLevel;
+    entry->lastUsed = frame;
+}
+
+void TextureResidency::update(uint64_t frame)
+{
+    plannedBytes = 0;
+    evictionOrder.clear();
+    for(Entry& entry : entries)
+    {
+        if(!entry.handle)
+            continue;
+        auto levels = streamer.getLevels(entry.handle);
+        // Unloaded without being removed
+        if(levels.empty())
+        {
+            entry.handle = {};
+            continue;
+        }
+
+        bool recentlyUsed = entry.lastUsed + UnusedAge >= frame;
+        entry.level = recentlyUsed ? std::min(entry.wantedLevel, entry.tailLevel) : entry.tailLevel;
+        for(uint32_t level = entry.level; level < levels.size(); ++level)
+            plannedBytes += levels[level].size;
+        if(entry.level < entry.tailLevel)
+            evictionOrder.push_back(&entry);
+    }
+
+    std::sort(entire_collection(evictionOrder), [](const Entry* a, const Entry* b) {
+        if(a->lastUsed != b->lastUsed)
+            return a->lastUsed < b->lastUsed;
+        return a->priority < b->priority;
+    });
+
+    // Textures last used in the same frame lose a level each per round, so they degrade evenly
+    for(size_t first = 0; first < evictionOrder.size() && plannedBytes > budget;)
+    {
+        uint64_t lastUsed = evictionOrder[first]->lastUsed;
+        size_t end = first;
+        while(end < evictionOrder.size() && evictionOrder[end]->lastUsed == lastUsed)
+            ++end;
+
+        for(bool dropped = true; dropped && plannedBytes > budget;)
+        {
+            dropped = false;
+            for(size_t i = first; i < end && plannedBytes > budget; ++i)
+            {
+                Entry& entry = *evictionOrder[i];
+                if(entry.level == entry.tailLevel)
+                    continue;
+                plannedBytes -= streamer.getLevels(entry.handle)[entry.level].size;
+                entry.level++;
+                dropped = true;
+            }
+        }
+        first = end;
+    }
+
+    for(const Entry& entry : entries)
+    {
+        if(entry.handle)
+            streamer.setMostDetailedLevel(entry.handle, entry.level);
+    }
+}
+
+void TextureResidency::setBudget(vk::DeviceSize budget)
+{
+    this->budget = budget;
+}
+
+vk::DeviceSize TextureResidency::getBudget() const
+{
+    return budget;
+}
+
+vk::DeviceSize TextureResidency::getPlannedBytes() const
+{
+    return plannedBytes;
+}
+
+TextureResidency::Entry* TextureResidency::find(StreamedTextureHandle handle)
+{
+    if(!handle || handle.index() >= entries.size() || entries[handle.index()].handle != handle)
+        return nullptr;
+    return &entries[handle.index()];
+}
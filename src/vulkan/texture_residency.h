@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "texture_streamer.h"
+
+/**
+ * @brief Decides how many levels of every streamed texture stay resident so they fit in a memory
+ * budget.
+ *
+ * The renderer marks the textures it uses every frame along with the most detailed level it
+ * needs. `update` starts from those levels, or just the tail for textures that weren't used
+ * recently, and while the total is over budget drops the most detailed level of the least
+ * recently used textures first, a level per texture at a time among equally old ones and lower
+ * priorities first. The chosen levels go to the TextureStreamer, which frees dropped levels and
+ * streams missing ones in.
+ *
+ * Sizes are estimated from the level sizes in the files, which for compressed formats is close to
+ * what the device allocates. Tails are always kept, so a budget smaller than every tail together
+ * is exceeded rather than failing.
+ */
+class TextureResidency
+{
+  public:
+    // `fraction` of the largest device local heap
+    static vk::DeviceSize budgetFromMemoryProperties(
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+        float fraction);
+
+    TextureResidency(TextureStreamer& streamer, vk::DeviceSize budget);
+
+    // Textures with a higher priority lose levels after those with a lower one that were last
+    // used in the same frame
+    void add(StreamedTextureHandle handle, float priority = 1.0f);
+    void remove(StreamedTextureHandle handle);
+    void markUsed(StreamedTextureHandle handle, uint64_t frame, uint32_t wantedLevel = 0);
+
+    // Call once per frame before TextureStreamer::update
+    void update(uint64_t frame);
+
+    void setBudget(vk::DeviceSize budget);
+    vk::DeviceSize getBudget() const;
+    // Estimated size of the levels chosen by the last `update`
+    vk::DeviceSize getPlannedBytes() const;
+
+  private:
+    struct Entry
+    {
+        // Null if the slot is unused
+        StreamedTextureHandle handle;
+        float priority;
+        uint64_t lastUsed;
+        uint32_t wantedLevel;
+        uint32_t tailLevel;
+        // Chosen by `update`
+        uint32_t level;
+    };
+
+    TextureStreamer& streamer;
+    vk::DeviceSize budget;
+    vk::DeviceSize plannedBytes;
+
+    // Indexed by the handle's index
+    std::vector<Entry> entries;
+    // Reused by `update`
+    std::vector<Entry*> evictionOrder;
+
+    Entry* find(StreamedTextureHandle handle);
+};
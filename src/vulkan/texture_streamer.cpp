@@ -0,0 +1,463 @@
+#include "texture_streamer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "commands.h"
+
+namespace
+{
+    // Covers the texel block size of every compressed format
+    constexpr vk::DeviceSize StagingAlignment = 16;
+
+    vk::ImageSubresourceRange levelRange(uint32_t baseLevel, uint32_t levelCount)
+    {
+        return vk::ImageSubresourceRange{
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .baseMipLevel = baseLevel,
+            .levelCount = levelCount,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        };
+    }
+}
+
+TextureStreamer::TextureStreamer(
+    const vk::UniqueDevice& device,
+    vk::PhysicalDevice physicalDevice,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+    vk::DeviceSize stagingCapacity,
+    uint32_t tailSize)
+    : device(device)
+    , physicalDevice(physicalDevice)
+    , memoryProperties(memoryProperties)
+    , stagingCapacity(stagingCapacity)
+    , tailSize(tailSize)
+{
+}
+
+std::variant<StreamedTextureHandle, TextureStreamer::Error> TextureStreamer::load(
+    const std::filesystem::path& path,
+    uint32_t mostDetailedLevel)
+{
+    Error error = {};
+
+    auto file = MappedFile::open(path);
+    if(!file.has_value())
+    {
+        error.type = ErrorType::FileNotFound;
+        return error;
+    }
+
+    auto parseVar = Ktx2::parse(file->getData());
+    if(std::holds_alternative<Ktx2::Error>(parseVar))
+    {
+        error.type = ErrorType::InvalidFile;
+        error.InvalidFile.error = std::get<Ktx2::Error>(parseVar);
+        return error;
+    }
+    Ktx2::Texture& ktx = std::get<Ktx2::Texture>(parseVar);
+
+    // Compressed formats only report features if their feature is supported, which
+    // DeviceBuilder::withOptionalTextureCompression enables
+    auto format = (vk::Format)ktx.format;
+    auto requiredFeatures =
+        vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eTransferDst;
+    auto block = texelBlock(format);
+    if(!block.has_value()
+       || (physicalDevice.getFormatProperties(format).optimalTilingFeatures & requiredFeatures)
+              != requiredFeatures)
+    {
+        error.type = ErrorType::UnsupportedFormat;
+        error.UnsupportedFormat.format = format;
+        return error;
+    }
+
+    // The copies in streamLevel read exactly this much from the staging allocation
+    auto levelCount = (uint32_t)ktx.levels.size();
+    for(uint32_t level = 0; level < levelCount; ++level)
+    {
+        vk::DeviceSize blocksX =
+            (std::max(ktx.width >> level, 1u) + block->width - 1) / block->width;
+        vk::DeviceSize blocksY =
+            (std::max(ktx.height >> level, 1u) + block->height - 1) / block->height;
+        if(ktx.levels[level].size != blocksX * blocksY * block->size)
+        {
+            error.type = ErrorType::InvalidLevelSize;
+            error.InvalidLevelSize.level = level;
+            return error;
+        }
+    }
+
+    uint32_t tailLevel = levelCount - 1;
+    for(uint32_t level = 0; level < levelCount; ++level)
+    {
+        if((ktx.width >> level) <= tailSize && (ktx.height >> level) <= tailSize)
+        {
+            tailLevel = level;
+            break;
+        }
+    }
+
+    // A level larger than staging could never be allocated and would stall streaming for good
+    uint32_t stagedLevel = levelCount;
+    while(stagedLevel > 0 && ktx.levels[stagedLevel - 1].size <= stagingCapacity)
+        stagedLevel--;
+    if(stagedLevel > tailLevel)
+    {
+        error.type = ErrorType::TooLargeForStaging;
+        error.TooLargeForStaging.size = ktx.levels[stagedLevel - 1].size;
+        return error;
+    }
+    mostDetailedLevel = std::clamp(mostDetailedLevel, stagedLevel, tailLevel);
+
+    vk::Extent2D extent = {ktx.width, ktx.height};
+    auto imageVar = createImage(format, extent, mostDetailedLevel, levelCount - mostDetailedLevel);
+    if(std::holds_alternative<Image::Builder::Error>(imageVar))
+    {
+        error.type = ErrorType::CreateImage;
+        error.CreateImage.error = std::get<Image::Builder::Error>(imageVar);
+        return error;
+    }
+
+    return textures.create(StreamedTexture{
+        .path = path,
+        .file = std::move(file),
+        .extent = extent,
+        .levels = std::move(ktx.levels),
+        .image = std::move(std::get<Image>(imageVar)),
+        .baseLevel = mostDetailedLevel,
+        .residentLevel = levelCount,
+        .mostDetailedLevel = mostDetailedLevel,
+        .tailLevel = tailLevel,
+        .stagedLevel = stagedLevel,
+        .partialView = {},
+    });
+}
+
+void TextureStreamer::unload(StreamedTextureHandle handle, DeletionQueue& deletionQueue)
+{
+    auto removed = textures.destroy(handle);
+    if(!removed.has_value())
+        return;
+
+    auto& [texture] = removed.value();
+    deletionQueue.retire(std::move(texture.partialView));
+    deletionQueue.retire(std::move(texture.image));
+}
+
+void TextureStreamer::setMostDetailedLevel(StreamedTextureHandle handle, uint32_t level)
+{
+    if(StreamedTexture* texture = textures.get<StreamedTexture>(handle))
+        texture->mostDetailedLevel = std::clamp(level, texture->stagedLevel, texture->tailLevel);
+}
+
+std::optional<TextureStreamer::Error> TextureStreamer::update(
+    vk::CommandBuffer commandBuffer,
+    TransientBuffer& staging,
+    vk::DeviceSize budget,
+    DeletionQueue& deletionQueue,
+    uint64_t timelineValue)
+{
+    Error error = {};
+    std::optional<Error> resizeError;
+
+    auto all = textures.all<StreamedTexture>();
+    std::vector<uint32_t> previousLevels(all.size());
+    std::vector<bool> resized(all.size(), false);
+    for(size_t i = 0; i < all.size(); ++i)
+    {
+        StreamedTexture& texture = all[i];
+        previousLevels[i] = texture.residentLevel;
+        if(texture.mostDetailedLevel != texture.baseLevel)
+        {
+            // The new image is created while the old one is still alive, which is most likely to
+            // run out of memory when memory is tight. The texture keeps its old image then
+            if(auto textureError = resize(commandBuffer, texture, deletionQueue, timelineValue))
+            {
+                texture.mostDetailedLevel = texture.baseLevel;
+                if(!resizeError.has_value())
+                    resizeError = textureError;
+            }
+            else
+                resized[i] = true;
+        }
+
+        if(texture.residentLevel > texture.mostDetailedLevel && !texture.file.has_value())
+        {
+            texture.file = MappedFile::open(texture.path);
+            if(!texture.file.has_value())
+            {
+                error.type = ErrorType::FileNotFound;
+                return error;
+            }
+        }
+    }
+
+    // One level per texture and round until nothing fits anymore
+    for(bool streamed = true; streamed;)
+    {
+        streamed = false;
+        for(StreamedTexture& texture : all)
+        {
+            if(texture.residentLevel > texture.mostDetailedLevel
+               && streamLevel(commandBuffer, texture, staging, budget))
+                streamed = true;
+        }
+    }
+
+    for(size_t i = 0; i < all.size(); ++i)
+    {
+        StreamedTexture& texture = all[i];
+        if(texture.residentLevel == previousLevels[i] && !resized[i])
+            continue;
+
+        // The old view might still be used by frames in flight
+        if(texture.partialView)
+            deletionQueue.retire(std::move(texture.partialView), timelineValue);
+        if(texture.residentLevel == texture.baseLevel)
+        {
+            texture.file.reset();
+            continue;
+        }
+        if(texture.residentLevel == texture.levels.size())
+            continue;
+
+        auto [civRes, view] = device->createImageViewUnique({
+            .image = texture.image.image.get(),
+            .viewType = vk::ImageViewType::e2D,
+            .format = texture.image.format,
+            .subresourceRange = levelRange(
+                texture.residentLevel - texture.baseLevel,
+                (uint32_t)texture.levels.size() - texture.residentLevel),
+        });
+        if(civRes != vk::Result::eSuccess)
+        {
+            error.type = ErrorType::CreateImageView;
+            error.CreateImageView.result = civRes;
+            return error;
+        }
+        texture.partialView = std::move(view);
+    }
+
+    return resizeError;
+}
+
+std::variant<Image, Image::Builder::Error> TextureStreamer::createImage(
+    vk::Format format,
+    vk::Extent2D extent,
+    uint32_t baseLevel,
+    uint32_t levelCount) const
+{
+    return Image::Builder(device)
+        .withExtent(
+            std::max(extent.width >> baseLevel, 1u),
+            std::max(extent.height >> baseLevel, 1u))
+        .withFormat(format)
+        .withMipLevels(levelCount)
+        .withTransferSourceUsage()
+        .withTransferDestUsage()
+        .withSampledUsage()
+        .withMemoryProperties(memoryProperties)
+        .build();
+}
+
+std::optional<TextureStreamer::Error> TextureStreamer::resize(
+    vk::CommandBuffer commandBuffer,
+    StreamedTexture& texture,
+    DeletionQueue& deletionQueue,
+    uint64_t timelineValue)
+{
+    auto levelCount = (uint32_t)texture.levels.size();
+    uint32_t baseLevel = texture.mostDetailedLevel;
+    auto imageVar = createImage(
+        texture.image.format,
+        texture.extent,
+        baseLevel,
+        levelCount - baseLevel);
+    if(std::holds_alternative<Image::Builder::Error>(imageVar))
+    {
+        Error error = {};
+        error.type = ErrorType::CreateImage;
+        error.CreateImage.error = std::get<Image::Builder::Error>(imageVar);
+        return error;
+    }
+    Image& image = std::get<Image>(imageVar);
+
+    uint32_t firstCopied = std::max(texture.residentLevel, baseLevel);
+    if(firstCopied < levelCount)
+    {
+        uint32_t copiedCount = levelCount - firstCopied;
+        Commands::transitionImageLayout(
+            commandBuffer,
+            texture.image.image.get(),
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::ImageLayout::eTransferSrcOptimal,
+            levelRange(firstCopied - texture.baseLevel, copiedCount));
+        Commands::transitionImageLayout(
+            commandBuffer,
+            image.image.get(),
+            vk::ImageLayout::eUndefined,
+            vk::ImageLayout::eTransferDstOptimal,
+            levelRange(firstCopied - baseLevel, copiedCount));
+
+        std::vector<vk::ImageCopy> copies;
+        for(uint32_t level = firstCopied; level < levelCount; ++level)
+        {
+            copies.push_back(vk::ImageCopy{
+                .srcSubresource =
+                    {
+                        .aspectMask = vk::ImageAspectFlagBits::eColor,
+                        .mipLevel = level - texture.baseLevel,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                .srcOffset = {0, 0, 0},
+                .dstSubresource =
+                    {
+                        .aspectMask = vk::ImageAspectFlagBits::eColor,
+                        .mipLevel = level - baseLevel,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                .dstOffset = {0, 0, 0},
+                .extent =
+                    {
+                        std::max(texture.extent.width >> level, 1u),
+                        std::max(texture.extent.height >> level, 1u),
+                        1,
+                    },
+            });
+        }
+        commandBuffer.copyImage(
+            texture.image.image.get(),
+            vk::ImageLayout::eTransferSrcOptimal,
+            image.image.get(),
+            vk::ImageLayout::eTransferDstOptimal,
+            (uint32_t)copies.size(),
+            copies.data());
+
+        Commands::transitionImageLayout(
+            commandBuffer,
+            image.image.get(),
+            vk::ImageLayout::eTransferDstOptimal,
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            levelRange(firstCopied - baseLevel, copiedCount));
+    }
+
+    deletionQueue.retire(std::move(texture.image), timelineValue);
+    texture.image = std::move(image);
+    texture.baseLevel = baseLevel;
+    texture.residentLevel = firstCopied;
+    return std::nullopt;
+}
+
+bool TextureStreamer::streamLevel(
+    vk::CommandBuffer commandBuffer,
+    StreamedTexture& texture,
+    TransientBuffer& staging,
+    vk::DeviceSize& budget)
+{
+    uint32_t level = texture.residentLevel - 1;
+    const Ktx2::Level& source = texture.levels[level];
+    uint32_t imageLevel = level - texture.baseLevel;
+    vk::Extent3D extent = {
+        std::max(texture.extent.width >> level, 1u),
+        std::max(texture.extent.height >> level, 1u),
+        1,
+    };
+
+    bool inTail = extent.width <= tailSize && extent.height <= tailSize;
+    if(!inTail && source.size > budget)
+        return false;
+    auto allocation = staging.allocate(source.size, StagingAlignment);
+    if(!allocation.has_value())
+        return false;
+
+    // Only the pages of this level are read from disk
+    std::memcpy(allocation->data, texture.file->getData().data() + source.offset, source.size);
+    budget -= std::min(budget, (vk::DeviceSize)source.size);
+
+    // The other levels might be sampled by frames in flight, so only this one changes layout
+    Commands::transitionImageLayout(
+        commandBuffer,
+        texture.image.image.get(),
+        vk::ImageLayout::eUndefined,
+        vk::ImageLayout::eTransferDstOptimal,
+        levelRange(imageLevel, 1));
+    vk::BufferImageCopy copy = {
+        .bufferOffset = allocation->offset,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource =
+            {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = imageLevel,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .imageOffset = {0, 0, 0},
+        .imageExtent = extent,
+    };
+    commandBuffer.copyBufferToImage(
+        allocation->buffer,
+        texture.image.image.get(),
+        vk::ImageLayout::eTransferDstOptimal,
+        1,
+        &copy);
+    Commands::transitionImageLayout(
+        commandBuffer,
+        texture.image.image.get(),
+        vk::ImageLayout::eTransferDstOptimal,
+        vk::ImageLayout::eShaderReadOnlyOptimal,
+        levelRange(imageLevel, 1));
+
+    texture.residentLevel = level;
+    return true;
+}
+
+vk::ImageView TextureStreamer::getView(StreamedTextureHandle handle) const
+{
+    const StreamedTexture* texture = textures.get<StreamedTexture>(handle);
+    if(!texture)
+        return VK_NULL_HANDLE;
+    if(texture->residentLevel == texture->baseLevel)
+        return texture->image.view.get();
+    return texture->partialView.get();
+}
+
+std::optional<uint32_t> TextureStreamer::getResidentLevel(StreamedTextureHandle handle) const
+{
+    const StreamedTexture* texture = textures.get<StreamedTexture>(handle);
+    if(!texture)
+        return std::nullopt;
+    return texture->residentLevel;
+}
+
+std::optional<uint32_t> TextureStreamer::getTailLevel(StreamedTextureHandle handle) const
+{
+    const StreamedTexture* texture = textures.get<StreamedTexture>(handle);
+    if(!texture)
+        return std::nullopt;
+    return texture->tailLevel;
+}
+
+std::span<const Ktx2::Level> TextureStreamer::getLevels(StreamedTextureHandle handle) const
+{
+    const StreamedTexture* texture = textures.get<StreamedTexture>(handle);
+    if(!texture)
+        return {};
+    return texture->levels;
+}
+
+vk::DeviceSize TextureStreamer::getPendingBytes() const
+{
+    vk::DeviceSize pendingBytes = 0;
+    for(const StreamedTexture& texture : textures.all<StreamedTexture>())
+    {
+        for(uint32_t level = texture.mostDetailedLevel; level < texture.residentLevel; ++level)
+            pendingBytes += texture.levels[level].size;
+    }
+    return pendingBytes;
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <variant>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "../handle_pool.h"
+#include "../ktx2.h"
+#include "../mapped_file.h"
+#include "deletion_queue.h"
+#include "image.h"
+#include "transient_buffer.h"
+
+struct StreamedTextureTag;
+using StreamedTextureHandle = Handle<StreamedTextureTag>;
+
+/**
+ * @brief Loads KTX2 textures in their GPU format (BCn, ETC2, ASTC, ...) and streams their levels
+ * in from memory mapped files, smallest first.
+ *
+ * `load` only parses the header and creates the image. `update` copies level data straight from
+ * the mapping into the frame's TransientBuffer without decoding, within a per frame byte budget,
+ * so loading a texture never stalls a frame and never holds a CPU copy of the file. Levels no
+ * larger than the tail size are small enough to always go in with the first update. A texture can
+ * be sampled through `getView` as soon as its tail is resident; the view only covers the resident
+ * levels and is replaced whenever more arrive. Once every level is resident the file is unmapped.
+ *
+ * The image only has the levels from the most detailed wanted one down. Changing that level
+ * recreates the image in the next `update` and copies the resident levels over on the GPU, so
+ * dropping levels actually frees their memory, and the file is mapped again to stream levels
+ * back in.
+ */
+class TextureStreamer
+{
+  public:
+    enum class ErrorType
+    {
+        FileNotFound,
+        InvalidFile,
+        // The device can't sample the format, e.g. ASTC on most desktop GPUs, or its level sizes
+        // can't be checked
+        UnsupportedFormat,
+        // A level doesn't have the size its extent and format call for
+        InvalidLevelSize,
+        // Even the tail has a level that is larger than the staging capacity
+        TooLargeForStaging,
+        CreateImage,
+        CreateImageView,
+    };
+
+    struct Error
+    {
+        ErrorType type;
+        union
+        {
+            struct
+            {
+                Ktx2::Error error;
+            } InvalidFile;
+            struct
+            {
+                vk::Format format;
+            } UnsupportedFormat;
+            struct
+            {
+                uint32_t level;
+            } InvalidLevelSize;
+            struct
+            {
+                vk::DeviceSize size;
+            } TooLargeForStaging;
+            struct
+            {
+                Image::Builder::Error error;
+            } CreateImage;
+            struct
+            {
+                vk::Result result;
+            } CreateImageView;
+        };
+    };
+
+    // `stagingCapacity` is the capacity of the TransientBuffer passed to `update`, levels larger
+    // than that are never streamed in. Levels of at most `tailSize` x `tailSize` texels ignore the
+    // budget of `update`
+    TextureStreamer(
+        const vk::UniqueDevice& device,
+        vk::PhysicalDevice physicalDevice,
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties,
+        vk::DeviceSize stagingCapacity,
+        uint32_t tailSize = 64);
+
+    // `mostDetailedLevel` as in `setMostDetailedLevel`, to not create a larger image than needed
+    std::variant<StreamedTextureHandle, Error> load(
+        const std::filesystem::path& path,
+        uint32_t mostDetailedLevel = 0);
+    // The image and view are retired in `deletionQueue` until everything submitted so far is done,
+    // so call it outside of recording a frame that uses the texture
+    void unload(StreamedTextureHandle handle, DeletionQueue& deletionQueue);
+    // Streams levels in up to `level` and drops more detailed ones, clamped to the tail and to the
+    // levels that fit into staging
+    void setMostDetailedLevel(StreamedTextureHandle handle, uint32_t level);
+
+    /**
+     * @brief Resizes images whose most detailed level changed, then stages up to `budget` bytes
+     * of missing levels in `staging` and records their copies. Every texture gets one level per
+     * round, so many textures stream in evenly. Must be recorded outside of a render pass, before
+     * anything samples the views.
+     *
+     * Replaced images and views are retired in `deletionQueue` until `timelineValue`, the value
+     * of the submission that executes `commandBuffer`.
+     *
+     * A texture whose image can't be resized, e.g. because the device is out of memory, keeps
+     * its current levels while the others are still updated, and the first such error is
+     * returned. Any other error returns right away
+     */
+    std::optional<Error> update(
+        vk::CommandBuffer commandBuffer,
+        TransientBuffer& staging,
+        vk::DeviceSize budget,
+        DeletionQueue& deletionQueue,
+        uint64_t timelineValue);
+
+    // VK_NULL_HANDLE until the tail is resident or if the handle isn't valid
+    vk::ImageView getView(StreamedTextureHandle handle) const;
+    // The most detailed resident level, or the level count if none is resident yet
+    std::optional<uint32_t> getResidentLevel(StreamedTextureHandle handle) const;
+    // The most detailed level `setMostDetailedLevel` can't go past
+    std::optional<uint32_t> getTailLevel(StreamedTextureHandle handle) const;
+    // Sizes and offsets in the file of every level, most detailed first. Empty for invalid handles
+    std::span<const Ktx2::Level> getLevels(StreamedTextureHandle handle) const;
+    // Bytes that are still waiting to be streamed in
+    vk::DeviceSize getPendingBytes() const;
+
+  private:
+    struct StreamedTexture
+    {
+        std::filesystem::path path;
+        // Only mapped while levels are missing
+        std::optional<MappedFile> file;
+        // Of level 0
+        vk::Extent2D extent;
+        std::vector<Ktx2::Level> levels;
+
+        // Has the levels from baseLevel on, so image level i is level baseLevel + i
+        Image image;
+        uint32_t baseLevel;
+        // Levels are absolute, not relative to baseLevel
+        uint32_t residentLevel;
+        uint32_t mostDetailedLevel;
+        uint32_t tailLevel;
+        // This level and all less detailed ones fit into staging
+        uint32_t stagedLevel;
+        // Of the resident levels while not all of them are, otherwise image.view is used
+        vk::UniqueImageView partialView;
+    };
+
+    const vk::UniqueDevice& device;
+    vk::PhysicalDevice physicalDevice;
+    vk::PhysicalDeviceMemoryProperties memoryProperties;
+    vk::DeviceSize stagingCapacity;
+    uint32_t tailSize;
+
+    HandlePool<StreamedTextureTag, StreamedTexture> textures;
+
+    std::variant<Image, Image::Builder::Error> createImage(
+        vk::Format format,
+        vk::Extent2D extent,
+        uint32_t baseLevel,
+        uint32_t levelCount) const;
+    // Recreates the image with baseLevel at mostDetailedLevel and copies the resident levels over
+    std::optional<Error> resize(
+        vk::CommandBuffer commandBuffer,
+        StreamedTexture& texture,
+        DeletionQueue& deletionQueue,
+        uint64_t timelineValue);
+    // Copies the next level of `texture` if it fits. Returns whether it did
+    bool streamLevel(
+        vk::CommandBuffer commandBuffer,
+        StreamedTexture& texture,
+        TransientBuffer& staging,
+        vk::DeviceSize& budget);
+};
@@ -0,0 +1,86 @@
+#include "transient_buffer.h"
+
+#include <algorithm>
+
+std::variant<TransientBuffer, Buffer::Builder::Error> TransientBuffer::create(
+    const vk::UniqueDevice& device,
+    uint32_t size,
+    const vk::PhysicalDeviceMemoryProperties& memoryProperties)
+{
+    auto bufferVar = Buffer::Builder(device)
+                         .withSize(size)
+                         .withVertexBufferFormat()
+                         .withMapFunctionality(memoryProperties)
+                         .withTransferSourceFormat(memoryProperties)
+                         .build();
+    if(std::holds_alternative<Buffer::Builder::Error>(bufferVar))
+        return std::get<Buffer::Builder::Error>(bufferVar);
+    Buffer buffer = std::get<Buffer>(std::move(bufferVar));
+
+    Buffer::Builder::Error error = {};
+
+    auto bbmRes = device->bindBufferMemory(buffer.buffer.get(), buffer.memory.get(), 0);
+    if(bbmRes != vk::Result::eSuccess)
+    {
+        error.type = Buffer::Builder::ErrorType::AllocateMemory;
+        error.AllocateMemory.result = bbmRes;
+        return error;
+    }
+
+    // Stays mapped until the memory is freed
+    void* mapped;
+    auto mmRes = device->mapMemory(
+        buffer.memory.get(),
+        0,
+        VK_WHOLE_SIZE,
+        vk::MemoryMapFlags(),
+        &mapped);
+    if(mmRes != vk::Result::eSuccess)
+    {
+        error.type = Buffer::Builder::ErrorType::AllocateMemory;
+        error.AllocateMemory.result = mmRes;
+        return error;
+    }
+
+    return TransientBuffer(std::move(buffer), size, mapped);
+}
+
+TransientBuffer::TransientBuffer(Buffer&& buffer, vk::DeviceSize size, void* mapped)
+    : buffer(std::move(buffer))
+    , size(size)
+    , mapped(mapped)
+    , head(0)
+{
+}
+
+std::optional<TransientBuffer::Allocation> TransientBuffer::allocate(
+    vk::DeviceSize size,
+    vk::DeviceSize alignment)
+{
+    alignment = std::max<vk::DeviceSize>(alignment, 1);
+    vk::DeviceSize offset = (head + alignment - 1) / alignment * alignment;
+    if(offset + size > this->size)
+        return std::nullopt;
+
+    head = offset + size;
+    return Allocation{
+        .buffer = buffer.buffer.get(),
+        .offset = offset,
+        .data = (char*)mapped + offset,
+    };
+}
+
+void TransientBuffer::reset()
+{
+    head = 0;
+}
+
+vk::DeviceSize TransientBuffer::getUsed() const
+{
+    return head;
+}
+
+vk::DeviceSize TransientBuffer::getCapacity() const
+{
+    return size;
+}
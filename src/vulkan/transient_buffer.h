@@ -0,0 +1,47 @@
+#pragma once
+
+#include <optional>
+#include <variant>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "buffer.h"
+
+/**
+ * @brief Persistently mapped linear allocator for data that only lives for one frame, such as
+ * per-frame vertex/instance data or upload staging.
+ *
+ * Allocating is a pointer bump and everything is freed at once with `reset`, which must only be
+ * called once the GPU is done with the frame that used it.
+ */
+class TransientBuffer
+{
+  public:
+    struct Allocation
+    {
+        vk::Buffer buffer;
+        vk::DeviceSize offset;
+        void* data;
+    };
+
+    static std::variant<TransientBuffer, Buffer::Builder::Error> create(
+        const vk::UniqueDevice& device,
+        uint32_t size,
+        const vk::PhysicalDeviceMemoryProperties& memoryProperties);
+
+    // Returns std::nullopt if the buffer is full
+    std::optional<Allocation> allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+    void reset();
+
+    vk::DeviceSize getUsed() const;
+    vk::DeviceSize getCapacity() const;
+
+  private:
+    TransientBuffer(Buffer&& buffer, vk::DeviceSize size, void* mapped);
+
+    Buffer buffer;
+    // The size the VkBuffer was created with. Buffer::size is the size of its memory, which can
+    // be larger
+    vk::DeviceSize size;
+    void* mapped;
+    vk::DeviceSize head;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+constexpr uint32_t vkFormatSize(vk::Format format)
+{
+    switch(format)
+    {
+        case vk::Format::eR32Sfloat: return sizeof(float);
+        case vk::Format::eR32G32Sfloat: return sizeof(float) * 2;
+        case vk::Format::eR32G32B32Sfloat: return sizeof(float) * 3;
+        case vk::Format::eR32G32B32A32Sfloat: return sizeof(float) * 4;
+        case vk::Format::eR32Uint:
+        case vk::Format::eR32Sint: return sizeof(uint32_t);
+        case vk::Format::eR32G32Uint:
+        case vk::Format::eR32G32Sint: return sizeof(uint32_t) * 2;
+
+        // Half floats
+        case vk::Format::eR16Sfloat: return 2;
+        case vk::Format::eR16G16Sfloat: return 4;
+        case vk::Format::eR16G16B16A16Sfloat: return 8;
+
+        // Normalized and integer 8/16 bit. 3 component formats are left out on purpose since they
+        // are poorly supported as vertex formats
+        case vk::Format::eR8Unorm:
+        case vk::Format::eR8Snorm:
+        case vk::Format::eR8Uint: return 1;
+        case vk::Format::eR8G8Unorm:
+        case vk::Format::eR8G8Snorm:
+        case vk::Format::eR8G8Uint:
+        case vk::Format::eR16Unorm:
+        case vk::Format::eR16Snorm:
+        case vk::Format::eR16Uint: return 2;
+        case vk::Format::eR8G8B8A8Unorm:
+        case vk::Format::eR8G8B8A8Snorm:
+        case vk::Format::eR8G8B8A8Uint:
+        case vk::Format::eB8G8R8A8Unorm:
+        case vk::Format::eR16G16Unorm:
+        case vk::Format::eR16G16Snorm:
+        case vk::Format::eR16G16Uint: return 4;
+        case vk::Format::eR16G16B16A16Unorm:
+        case vk::Format::eR16G16B16A16Snorm:
+        case vk::Format::eR16G16B16A16Uint: return 8;
+
+        // Packed
+        case vk::Format::eA2B10G10R10UnormPack32:
+        case vk::Format::eA2B10G10R10SnormPack32:
+        case vk::Format::eA2R10G10B10UnormPack32:
+        case vk::Format::eB10G11R11UfloatPack32: return 4;
+
+        default: return 0;
+    }
+}
+
+struct VertexLayoutAttribute
+{
+    vk::Format format;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t alignment;
+};
+
+// Describes `member` of `Vertex` with its real offset, padding included
+#define VERTEX_ATTRIBUTE(Vertex, member, vkFormat)                \
+    VertexLayoutAttribute                                         \
+    {                                                             \
+        .format = vkFormat,                                       \
+        .offset = (uint32_t)offsetof(Vertex, member),             \
+        .size = (uint32_t)sizeof(Vertex::member),                 \
+        .alignment = (uint32_t)alignof(decltype(Vertex::member)), \
+    }
+
+/**
+ * @brief One vertex stream (binding). Bindings and locations start at 0 here, PipelineBuilder moves
+ * them after the streams that were added before this one
+ */
+template<typename Vertex, size_t N>
+struct VertexLayout
+{
+    vk::VertexInputBindingDescription binding;
+    // Locations are assigned in the order the attributes were given in
+    std::array<vk::VertexInputAttributeDescription, N> attributes;
+};
+
+namespace VertexLayoutErrors
+{
+    // Not constexpr, so calling them from makeVertexLayout turns into a compile error that names
+    // the problem
+    void unsupportedFormat();
+    void formatDoesNotMatchMemberSize();
+    void attributesOverlap();
+    void memberNotDescribed();
+}
+
+/**
+ * @brief Builds the vertex input description for `Vertex` at compile time.
+ *
+ * Fails to compile if an attribute's format is unknown to vkFormatSize, if a format doesn't have
+ * the size of its member, if attributes overlap, or if there's a gap that isn't exactly the padding
+ * the compiler puts before the next member or at the end, which means a member was left out.
+ * Members with alignas can't be told apart from left out ones and fail too.
+ *
+ *     constexpr auto layout = makeVertexLayout<MyVertex>({
+ *         VERTEX_ATTRIBUTE(MyVertex, position, vk::Format::eR32G32B32Sfloat),
+ *         VERTEX_ATTRIBUTE(MyVertex, normal, vk::Format::eA2B10G10R10SnormPack32),
+ *     });
+ */
+template<typename Vertex, size_t N>
+consteval VertexLayout<Vertex, N> makeVertexLayout(
+    const VertexLayoutAttribute (&attributes)[N],
+    vk::VertexInputRate inputRate = vk::VertexInputRate::eVertex)
+{
+    VertexLayout<Vertex, N> layout = {
+        .binding =
+            {
+                .binding = 0,
+                .stride = sizeof(Vertex),
+                .inputRate = inputRate,
+            },
+        .attributes = {},
+    };
+
+    // Sorted by offset to check overlaps and gaps, insertion sort is fine for a handful
+    std::array<VertexLayoutAttribute, N> sorted = {};
+    for(size_t i = 0; i < N; ++i)
+    {
+        const VertexLayoutAttribute& attribute = attributes[i];
+        if(vkFormatSize(attribute.format) == 0)
+            VertexLayoutErrors::unsupportedFormat();
+        if(vkFormatSize(attribute.format) != attribute.size)
+            VertexLayoutErrors::formatDoesNotMatchMemberSize();
+
+        layout.attributes[i] = {
+            .location = (uint32_t)i,
+            .binding = 0,
+            .format = attribute.format,
+            .offset = attribute.offset,
+        };
+
+        size_t j = i;
+        for(; j > 0 && sorted[j - 1].offset > attribute.offset; --j)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = attribute;
+    }
+
+    // Padding only ever rounds up to the alignment of the next member, or of the struct at the end
+    auto alignUp = [](uint32_t offset, uint32_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    };
+    uint32_t end = 0;
+    for(const VertexLayoutAttribute& attribute : sorted)
+    {
+        if(attribute.offset < end)
+            VertexLayoutErrors::attributesOverlap();
+        if(attribute.offset != alignUp(end, attribute.alignment))
+            VertexLayoutErrors::memberNotDescribed();
+        end = attribute.offset + attribute.size;
+    }
+    if(sizeof(Vertex) != alignUp(end, (uint32_t)alignof(Vertex)))
+        VertexLayoutErrors::memberNotDescribed();
+
+    return layout;
+}